@@ -31,6 +31,19 @@ static const char help[] =
   "  --settings FILE              Load settings file into EEPROM.\n"
   "  --get-settings FILE          Read EEPROM settings and write to file.\n"
   "  --fix-settings IN OUT        Read settings from a file and fix them.\n"
+  "  --fix-settings-batch IN DIR  Fix many settings files in parallel.  IN is a\n"
+  "                               directory or a file listing one file per line.\n"
+  "                               Fixed files are written to DIR.\n"
+  "  --product NAME               With --fix-settings-batch, convert settings to\n"
+  "                               the specified product (e.g. 18v27).\n"
+  "  --firmware-version VER       The firmware version for --product (e.g. 1.02).\n"
+  "                               Required with --product.\n"
+  "  --jobs NUM                   Number of threads for --fix-settings-batch.\n"
+  "  --compile-settings IN OUT    Check a settings file and write its raw settings\n"
+  "                               image to OUT as a C/C++ header.  Fails if the\n"
+  "                               settings need to be fixed.\n"
+  "  --allow-fix                  With --compile-settings, fix the settings and\n"
+  "                               print warnings instead of failing.\n"
   "\n"
   "RAM (volatile) settings:\n"
   "  --get-ram-settings FILE      Read settings from device RAM and write to file.\n"
@@ -47,6 +60,31 @@ static const char help[] =
   "  --current-limit-fwd NUM      Set hard forward current limit in milliamps.\n"
   "  --current-limit-rev NUM      Set hard reverse current limit in milliamps.\n"
   "\n"
+  "Usage accounting:\n"
+  "  --track-usage DIR            Read the device's variables until interrupted and\n"
+  "                               add its motor usage to a file in DIR named after\n"
+  "                               its serial number.\n"
+  "  --duration SECONDS           With --track-usage, --detect-anomalies,\n"
+  "                               --stream, or --provision, stop after SECONDS.\n"
+  "  --usage DIR                  Print the motor usage recorded in DIR.\n"
+  "  --detect-anomalies           Read the device's variables until interrupted and\n"
+  "                               print alerts when they behave unusually.\n"
+  "  --stream                     Print the variables of every device (or the one\n"
+  "                               specified with -d) as CSV, reading moving\n"
+  "                               devices more often than idle ones.  While\n"
+  "                               streaming, type \"stop [SERIAL]\" or\n"
+  "                               \"target SERIAL VALUE\" to control the devices.\n"
+  "  --poll-budget NUM            With --stream, read at most NUM times per second\n"
+  "                               in total (default 200, 0 for no limit).\n"
+  "\n"
+  "Provisioning:\n"
+  "  --provision FILE             Wait for devices to be connected and load the\n"
+  "                               settings in FILE into each one, then verify them.\n"
+  "                               Several devices can be connected at once.\n"
+  "                               Fails if any device could not be provisioned.\n"
+  "  --firmware FILE              With --provision, also upgrade each device with\n"
+  "                               the firmware in FILE (a .fmi file) first.\n"
+  "\n"
   "Encoded current limits:\n"
   "  --current-table              Print a CSV with encoded hard current limits and\n"
   "                               calibrated current limits in milliamps.\n"
@@ -58,8 +96,6 @@ static const char help[] =
   "For more help, see: " DOCUMENTATION_URL "\n"
   "\n";
 
-// TODO: add --stream, like the old jrkcmd, for streaming variables
-
 struct arguments
 {
   bool show_status = false;
@@ -111,6 +147,18 @@ struct arguments
   std::string fix_settings_input_filename;
   std::string fix_settings_output_filename;
 
+  bool fix_settings_batch = false;
+  std::string fix_settings_batch_input;
+  std::string fix_settings_batch_output_dir;
+  uint32_t fix_settings_batch_product = 0;
+  uint16_t fix_settings_batch_firmware_version = 0;
+  unsigned int fix_settings_batch_jobs = 0;
+
+  bool compile_settings = false;
+  std::string compile_settings_input_filename;
+  std::string compile_settings_output_filename;
+  bool compile_settings_allow_fix = false;
+
   bool set_ram_settings = false;
   std::string set_ram_settings_filename;
 
@@ -143,6 +191,24 @@ struct arguments
   bool override_current_limit_reverse = false;
   uint32_t current_limit_reverse_ma = 0;
 
+  bool track_usage = false;
+  std::string track_usage_dir;
+
+  // Used by track_usage, detect_anomalies, stream, and provision.
+  uint32_t duration = 0;
+
+  bool print_usage = false;
+  std::string print_usage_dir;
+
+  bool detect_anomalies = false;
+
+  bool stream = false;
+  uint32_t stream_poll_budget = 200;
+
+  bool provision = false;
+  std::string provision_settings_filename;
+  std::string provision_firmware_filename;
+
   bool get_current_limit_table = false;
 
   bool current_limit_decode = false;
@@ -173,10 +239,17 @@ struct arguments
       set_eeprom_settings ||
       get_eeprom_settings ||
       fix_settings ||
+      fix_settings_batch ||
+      compile_settings ||
       set_ram_settings ||
       get_ram_settings ||
       reinitialize ||
       override_specific_settings() ||
+      track_usage ||
+      print_usage ||
+      detect_anomalies ||
+      stream ||
+      provision ||
       get_current_limit_table ||
       current_limit_decode ||
       current_limit_encode ||
@@ -269,6 +342,46 @@ static std::string parse_arg_string(arg_reader & arg_reader)
     return std::string(value_c);
 }
 
+static uint32_t parse_arg_product(arg_reader & arg_reader)
+{
+  std::string name = parse_arg_string(arg_reader);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  for (uint32_t product = 1; product <= JRK_PRODUCT_UMC06A; product++)
+  {
+    if (name == jrk_look_up_product_name_short(product))
+    {
+      return product;
+    }
+  }
+  throw exception_with_exit_code(EXIT_BAD_ARGS,
+    "Unknown product name after '" + std::string(arg_reader.last()) + "'.");
+}
+
+// Parses a firmware version like "1.02" into the BCD format returned by
+// jrk_device_get_firmware_version().
+static uint16_t parse_arg_firmware_version(arg_reader & arg_reader)
+{
+  std::string str = parse_arg_string(arg_reader);
+  size_t dot = str.find('.');
+  std::string major = str.substr(0, dot);
+  std::string minor = dot == std::string::npos ? "00" : str.substr(dot + 1);
+  if (major.empty() || major.size() > 2 || minor.size() != 2 ||
+    major.find_first_not_of("0123456789") != std::string::npos ||
+    minor.find_first_not_of("0123456789") != std::string::npos)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The firmware version after '" + std::string(arg_reader.last()) +
+      "' is invalid.  It should look like 1.02.");
+  }
+
+  uint16_t version = 0;
+  for (char c : major + minor)
+  {
+    version = (version << 4) | (c - '0');
+  }
+  return version;
+}
+
 static arguments parse_args(int argc, char ** argv)
 {
   arg_reader arg_reader(argc, argv);
@@ -396,6 +509,36 @@ static arguments parse_args(int argc, char ** argv)
       args.fix_settings_input_filename = parse_arg_string(arg_reader);
       args.fix_settings_output_filename = parse_arg_string(arg_reader);
     }
+    else if (arg == "--fix-settings-batch")
+    {
+      args.fix_settings_batch = true;
+      args.fix_settings_batch_input = parse_arg_string(arg_reader);
+      args.fix_settings_batch_output_dir = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--compile-settings")
+    {
+      args.compile_settings = true;
+      args.compile_settings_input_filename = parse_arg_string(arg_reader);
+      args.compile_settings_output_filename = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--allow-fix")
+    {
+      args.compile_settings_allow_fix = true;
+    }
+    else if (arg == "--product")
+    {
+      args.fix_settings_batch_product = parse_arg_product(arg_reader);
+    }
+    else if (arg == "--firmware-version")
+    {
+      args.fix_settings_batch_firmware_version =
+        parse_arg_firmware_version(arg_reader);
+    }
+    else if (arg == "--jobs" || arg == "-j")
+    {
+      args.fix_settings_batch_jobs =
+        parse_arg_int<unsigned int>(arg_reader, 1, 1024);
+    }
     else if (arg == "--get-ram-settings")
     {
       args.get_ram_settings = true;
@@ -478,6 +621,42 @@ static arguments parse_args(int argc, char ** argv)
       args.current_limit_encode = true;
       args.current_limit_ma_to_convert = parse_arg_int<uint32_t>(arg_reader);
     }
+    else if (arg == "--track-usage")
+    {
+      args.track_usage = true;
+      args.track_usage_dir = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--duration")
+    {
+      args.duration =
+        parse_arg_int<uint32_t>(arg_reader, 1, 0xFFFFFFFF / 1000);
+    }
+    else if (arg == "--usage")
+    {
+      args.print_usage = true;
+      args.print_usage_dir = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--detect-anomalies")
+    {
+      args.detect_anomalies = true;
+    }
+    else if (arg == "--stream")
+    {
+      args.stream = true;
+    }
+    else if (arg == "--poll-budget")
+    {
+      args.stream_poll_budget = parse_arg_int<uint32_t>(arg_reader);
+    }
+    else if (arg == "--provision")
+    {
+      args.provision = true;
+      args.provision_settings_filename = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--firmware")
+    {
+      args.provision_firmware_filename = parse_arg_string(arg_reader);
+    }
     else if (arg == "--debug")
     {
       // This is an unadvertized option for helping customers troubleshoot
@@ -490,6 +669,30 @@ static arguments parse_args(int argc, char ** argv)
         std::string("Unknown option: '") + arg + "'.");
     }
   }
+
+  if (!args.fix_settings_batch && (args.fix_settings_batch_product ||
+    args.fix_settings_batch_firmware_version || args.fix_settings_batch_jobs))
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "--product, --firmware-version, and --jobs require "
+      "--fix-settings-batch.");
+  }
+
+  // Some settings depend on the firmware version, so guessing it could
+  // silently produce settings that are wrong for the units.
+  if (args.fix_settings_batch_product &&
+    !args.fix_settings_batch_firmware_version)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "--product requires --firmware-version.");
+  }
+
+  if (args.compile_settings_allow_fix && !args.compile_settings)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "--allow-fix requires --compile-settings.");
+  }
+
   return args;
 }
 
@@ -819,6 +1022,21 @@ static void run(const arguments & args)
       args.fix_settings_output_filename);
   }
 
+  if (args.fix_settings_batch)
+  {
+    fix_settings_batch(args.fix_settings_batch_input,
+      args.fix_settings_batch_output_dir,
+      args.fix_settings_batch_product,
+      args.fix_settings_batch_firmware_version,
+      args.fix_settings_batch_jobs);
+  }
+
+  if (args.compile_settings)
+  {
+    compile_settings(args.compile_settings_input_filename,
+      args.compile_settings_output_filename, args.compile_settings_allow_fix);
+  }
+
   if (args.get_eeprom_settings)
   {
     get_eeprom_settings(selector, args.get_eeprom_settings_filename);
@@ -920,6 +1138,33 @@ static void run(const arguments & args)
     print_debug_data(selector);
   }
 
+  if (args.track_usage)
+  {
+    track_usage(selector, args.track_usage_dir, args.duration);
+  }
+
+  if (args.print_usage)
+  {
+    print_usage(selector, args.print_usage_dir,
+      args.serial_number_specified ? args.serial_number : "");
+  }
+
+  if (args.detect_anomalies)
+  {
+    detect_anomalies(selector, args.duration);
+  }
+
+  if (args.stream)
+  {
+    stream_variables(selector, args.stream_poll_budget, args.duration);
+  }
+
+  if (args.provision)
+  {
+    provision(args.provision_settings_filename,
+      args.provision_firmware_filename, args.duration);
+  }
+
   if (args.show_status)
   {
     get_status(selector, args.full_output);
@@ -30,3 +30,23 @@ void print_status(
   const std::string & cmd_port,
   const std::string & ttl_port,
   bool full_output);
+
+void track_usage(device_selector &, const std::string & dir,
+  uint32_t duration_s);
+
+void print_usage(device_selector &, const std::string & dir,
+  const std::string & serial_number);
+
+void detect_anomalies(device_selector &, uint32_t duration_s);
+
+void stream_variables(device_selector &, uint32_t budget, uint32_t duration_s);
+
+void provision(const std::string & settings_filename,
+  const std::string & firmware_filename, uint32_t duration_s);
+
+void fix_settings_batch(const std::string & input,
+  const std::string & output_dir,
+  uint32_t product, uint16_t firmware_version, unsigned int job_count);
+
+void compile_settings(const std::string & input_filename,
+  const std::string & output_filename, bool allow_fix);
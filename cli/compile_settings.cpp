@@ -0,0 +1,102 @@
+// Compiles a settings file into a C/C++ header holding its raw settings image,
+// so that programs can provision a Jrk without parsing settings files.
+
+#include "cli.h"
+
+static std::string base_name(const std::string & path)
+{
+  size_t pos = path.find_last_of("/\\");
+  if (pos == std::string::npos) { return path; }
+  return path.substr(pos + 1);
+}
+
+// Makes a C identifier for the image from the name of the settings file.
+static std::string identifier_for_file(const std::string & filename)
+{
+  std::string name = base_name(filename);
+  size_t dot = name.find('.');
+  if (dot != std::string::npos) { name = name.substr(0, dot); }
+
+  if (filename == "-" || name.empty()) { return "jrk_settings"; }
+
+  for (char & c : name)
+  {
+    if (!isalnum((unsigned char)c)) { c = '_'; }
+  }
+  return "jrk_settings_" + name;
+}
+
+static std::string upper_case(std::string str)
+{
+  for (char & c : str) { c = toupper((unsigned char)c); }
+  return str;
+}
+
+void compile_settings(const std::string & input_filename,
+  const std::string & output_filename, bool allow_fix)
+{
+  std::string in_str = read_string_from_file_or_pipe(input_filename);
+  jrk::settings settings = jrk::settings::read_from_string(in_str);
+
+  // The image is written to units without being fixed, so by default a file
+  // that fixing would change is an error here, where it can fail the build,
+  // rather than something that gets noticed in production.  Settings that are
+  // missing from the file take the product's defaults, which do not need
+  // fixing.  Some changes (like rounding the baud rate) have no warning, so
+  // we also compare the images.
+  jrk::settings_image original_image = settings.encode();
+  std::string warnings;
+  settings.fix(&warnings);
+  jrk::settings_image image = settings.encode();
+  bool changed = !warnings.empty() ||
+    memcmp(image.bytes, original_image.bytes, sizeof(image.bytes)) != 0;
+
+  std::cerr << warnings;
+  if (changed && !allow_fix)
+  {
+    throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+      "The settings in " + input_filename + " need to be fixed.  "
+      "Use --fix-settings to fix them, or --allow-fix to compile the fixed "
+      "settings.");
+  }
+
+  uint32_t product = settings.get_product();
+  std::string name = identifier_for_file(input_filename);
+
+  std::ostringstream out;
+  out << "// Generated by " CLI_NAME " --compile-settings from "
+    << base_name(input_filename) << ".  Do not edit." << std::endl;
+  out << "//" << std::endl;
+  out << "// This is a raw settings image for the "
+    << jrk_look_up_product_name_ui(product) << ", in the format" << std::endl;
+  out << "// used by jrk_settings_encode().  Byte 0 is not used.  To apply it, "
+    "write" << std::endl;
+  out << "// the other bytes with jrk_set_eeprom_setting_byte() or" << std::endl;
+  out << "// jrk_set_ram_setting_segment(), and then reinitialize the Jrk."
+    << std::endl;
+  out << std::endl;
+  out << "#pragma once" << std::endl;
+  out << std::endl;
+  out << "#include <stdint.h>" << std::endl;
+  out << std::endl;
+  out << "#define " << upper_case(name) << "_PRODUCT " << product << std::endl;
+  out << std::endl;
+  out << "#if defined(__cplusplus) && __cplusplus >= 201103L" << std::endl;
+  out << "static constexpr uint8_t " << name << "[" << sizeof(image.bytes)
+    << "] =" << std::endl;
+  out << "#else" << std::endl;
+  out << "static const uint8_t " << name << "[" << sizeof(image.bytes)
+    << "] =" << std::endl;
+  out << "#endif" << std::endl;
+  out << "{" << std::endl;
+  for (size_t i = 0; i < sizeof(image.bytes); i++)
+  {
+    if (i % 12 == 0) { out << " "; }
+    out << " 0x" << std::hex << std::uppercase << std::setw(2)
+      << std::setfill('0') << (unsigned int)image.bytes[i] << std::dec << ",";
+    if (i % 12 == 11 || i + 1 == sizeof(image.bytes)) { out << std::endl; }
+  }
+  out << "};" << std::endl;
+
+  write_string_to_file_or_pipe(output_filename, out.str());
+}
@@ -0,0 +1,61 @@
+// Watches a device's variables for unusual values and prints alerts as they
+// start and stop.
+
+#include "cli.h"
+
+// How often we read the variables.
+static const uint32_t sample_period_ms = 50;
+
+static std::string format_time(uint64_t ms)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(3) << ms / 1000.0 << " s";
+  return stream.str();
+}
+
+void detect_anomalies(device_selector & selector, uint32_t duration_s)
+{
+  jrk::handle handle(selector.select_device());
+  jrk::anomaly_detector detector = jrk::anomaly_detector::create();
+
+  auto start = std::chrono::steady_clock::now();
+  uint32_t active_alerts = 0;
+  bool fit_reported = false;
+
+  std::cout << std::fixed << std::setprecision(1);
+
+  while (true)
+  {
+    jrk::variables vars = handle.get_variables(0);
+    uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    uint32_t alerts = detector.add_sample(vars);
+
+    double slope, intercept;
+    if (!fit_reported && detector.get_fit(&slope, &intercept))
+    {
+      std::cout << format_time(time) << ": Learned current fit: "
+        << std::setprecision(3) << slope << " mA per duty cycle unit + "
+        << std::setprecision(1) << intercept << " mA" << std::endl;
+      fit_reported = true;
+    }
+
+    // Only report changes so that a long anomaly does not flood the output.
+    for (uint8_t channel = 0; channel < JRK_ANOMALY_CHANNEL_COUNT; channel++)
+    {
+      uint32_t bit = 1 << channel;
+      if ((alerts ^ active_alerts) & bit)
+      {
+        std::cout << format_time(time) << ": "
+          << jrk_look_up_anomaly_channel_name(channel)
+          << ((alerts & bit) ? " alert" : " cleared")
+          << " (z = " << detector.get_z_score(channel) << ")" << std::endl;
+      }
+    }
+    active_alerts = alerts;
+
+    if (duration_s && time >= (uint64_t)duration_s * 1000) { break; }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(sample_period_ms));
+  }
+}
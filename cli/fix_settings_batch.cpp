@@ -0,0 +1,228 @@
+// Fixes many settings files at once using several threads.
+
+#include "cli.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <dirent.h>
+#include <sys/stat.h>
+
+struct batch_file
+{
+  std::string input_path;
+  std::string output_path;
+  bool success = false;
+  std::string warnings;
+  std::string error_message;
+};
+
+static bool is_directory(const std::string & path)
+{
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool is_regular_file(const std::string & path)
+{
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static std::string join_path(const std::string & dir, const std::string & name)
+{
+  if (dir.empty()) { return name; }
+  char last = dir[dir.size() - 1];
+  if (last == '/' || last == '\\') { return dir + name; }
+  return dir + "/" + name;
+}
+
+static std::string base_name(const std::string & path)
+{
+  size_t pos = path.find_last_of("/\\");
+  if (pos == std::string::npos) { return path; }
+  return path.substr(pos + 1);
+}
+
+// Returns the regular files in a directory (not recursive), sorted by name.
+static std::vector<std::string> list_directory(const std::string & dir_path)
+{
+  DIR * dir = opendir(dir_path.c_str());
+  if (dir == NULL)
+  {
+    int error_code = errno;
+    throw std::runtime_error(dir_path + ": " + strerror(error_code) + ".");
+  }
+
+  std::vector<std::string> paths;
+  while (struct dirent * entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name.empty() || name[0] == '.') { continue; }
+    std::string path = join_path(dir_path, name);
+    if (is_regular_file(path)) { paths.push_back(path); }
+  }
+  closedir(dir);
+
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+// Reads a list of filenames, one per line.  Blank lines and lines starting
+// with '#' are ignored.
+static std::vector<std::string> read_file_list(const std::string & list_path)
+{
+  std::istringstream stream(read_string_from_file_or_pipe(list_path));
+  std::vector<std::string> paths;
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+    {
+      line.erase(line.size() - 1);
+    }
+    if (line.empty() || line[0] == '#') { continue; }
+    paths.push_back(line);
+  }
+  return paths;
+}
+
+static void fix_one_file(batch_file & file,
+  uint32_t product, uint16_t firmware_version)
+{
+  try
+  {
+    std::string in_str = read_string_from_file(file.input_path);
+    jrk::settings settings = jrk::settings::read_from_string(in_str);
+
+    if (product)
+    {
+      settings.fix_and_change_product(product, firmware_version,
+        &file.warnings);
+    }
+    else
+    {
+      settings.fix(&file.warnings);
+    }
+
+    write_string_to_file_atomic(file.output_path, settings.to_string());
+    file.success = true;
+  }
+  catch (const std::exception & e)
+  {
+    file.error_message = e.what();
+  }
+}
+
+static void print_indented(std::ostream & out, const std::string & text)
+{
+  std::istringstream stream(text);
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    out << "  " << line << std::endl;
+  }
+}
+
+void fix_settings_batch(const std::string & input,
+  const std::string & output_dir,
+  uint32_t product, uint16_t firmware_version, unsigned int job_count)
+{
+  std::vector<std::string> input_paths;
+  if (is_directory(input))
+  {
+    input_paths = list_directory(input);
+  }
+  else
+  {
+    input_paths = read_file_list(input);
+  }
+
+  if (!is_directory(output_dir))
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The output directory '" + output_dir + "' does not exist.");
+  }
+
+  std::vector<batch_file> files(input_paths.size());
+  std::map<std::string, size_t> output_owner;
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    batch_file & file = files[i];
+    file.input_path = input_paths[i];
+    file.output_path = join_path(output_dir, base_name(file.input_path));
+
+    // Two inputs with the same name would overwrite each other's output.
+    auto r = output_owner.insert(std::make_pair(file.output_path, i));
+    if (!r.second)
+    {
+      file.error_message = "Output file " + file.output_path +
+        " would overwrite the output for " +
+        files[r.first->second].input_path + ".";
+    }
+  }
+
+  if (job_count == 0)
+  {
+    job_count = std::thread::hardware_concurrency();
+    if (job_count == 0) { job_count = 1; }
+  }
+  if (job_count > files.size()) { job_count = files.size(); }
+
+  // Each worker takes the next unclaimed file until there are none left.  The
+  // files are independent, so there is no other shared state.
+  std::atomic<size_t> next_index(0);
+  auto worker = [&]()
+  {
+    while (true)
+    {
+      size_t i = next_index++;
+      if (i >= files.size()) { break; }
+      if (!files[i].error_message.empty()) { continue; }
+      fix_one_file(files[i], product, firmware_version);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < job_count; i++)
+  {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread & thread : threads)
+  {
+    thread.join();
+  }
+
+  // Print a consolidated report in the order of the inputs.
+  size_t warning_count = 0;
+  size_t failure_count = 0;
+  for (const batch_file & file : files)
+  {
+    if (!file.success)
+    {
+      failure_count++;
+      std::cerr << file.input_path << ": Error:" << std::endl;
+      print_indented(std::cerr, file.error_message);
+    }
+    else if (!file.warnings.empty())
+    {
+      warning_count++;
+      std::cerr << file.input_path << ":" << std::endl;
+      print_indented(std::cerr, file.warnings);
+    }
+  }
+
+  std::cerr << "Processed " << files.size() << " settings files: "
+    << (files.size() - failure_count) << " written ("
+    << warning_count << " with warnings), "
+    << failure_count << " failed." << std::endl;
+
+  if (failure_count)
+  {
+    std::ostringstream message;
+    message << "Failed to fix " << failure_count << " settings files.";
+    throw exception_with_exit_code(EXIT_OPERATION_FAILED, message.str());
+  }
+}
@@ -0,0 +1,641 @@
+// Provisions Jrks on an assembly line.  Units are detected as they are
+// plugged in, and each one goes through a pipeline of stages: firmware
+// upgrade (optional), settings write, and verification.  Each stage has its
+// own thread, so one unit can be upgraded while the next has its settings
+// written and another is verified, and the station is limited by its slowest
+// stage instead of the sum of all of them.
+
+#include "cli.h"
+
+#include <bootloader.h>
+
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+
+// How often we look for units that were plugged in or unplugged.
+static const uint32_t detect_period_ms = 200;
+
+// How long we wait for a unit to come back after it restarts.
+static const uint32_t reconnect_timeout_ms = 10000;
+
+enum stage_id { firmware_stage, settings_stage, verify_stage, stage_count };
+
+static const char * const stage_names[stage_count] = {
+  "firmware", "settings", "verify"
+};
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void request_stop(int)
+{
+  stop_requested = 1;
+}
+
+static uint64_t elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+struct unit
+{
+  std::string serial_number;
+  std::chrono::steady_clock::time_point start_time;
+
+  // Empty if all the stages so far succeeded.
+  std::string error_message;
+  stage_id failed_stage = firmware_stage;
+
+  uint64_t stage_time[stage_count] = {};
+};
+
+struct stage_stats
+{
+  uint32_t count = 0;
+  uint64_t total = 0;
+  uint64_t max = 0;
+
+  double mean() const
+  {
+    return count ? (double)total / count : 0;
+  }
+};
+
+// A queue of units waiting for a stage, which the stage's thread waits on.
+class unit_queue
+{
+public:
+  void push(std::shared_ptr<unit> u)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    units.push_back(u);
+    condition.notify_one();
+  }
+
+  // Waits for a unit.  Returns null once the queue is closed and empty.
+  std::shared_ptr<unit> pop()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return closed || !units.empty(); });
+    return take();
+  }
+
+  // Returns null right away if there is no unit.
+  std::shared_ptr<unit> try_pop()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return take();
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    condition.notify_all();
+  }
+
+private:
+  std::shared_ptr<unit> take()
+  {
+    if (units.empty()) { return nullptr; }
+    std::shared_ptr<unit> u = units.front();
+    units.pop_front();
+    return u;
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::shared_ptr<unit>> units;
+  bool closed = false;
+};
+
+// Devices are listed from the main loop and from the stage threads.  The
+// listing functions are not documented to be thread-safe (they enumerate USB
+// devices and, on some platforms, the serial ports of each one), so all
+// listing goes through these functions, which take turns.
+static std::mutex list_mutex;
+
+static std::vector<jrk::device> list_jrks()
+{
+  std::lock_guard<std::mutex> lock(list_mutex);
+  return jrk::list_connected_devices();
+}
+
+static std::vector<bootloader_instance> list_bootloaders()
+{
+  std::lock_guard<std::mutex> lock(list_mutex);
+  return bootloader_list_connected_devices();
+}
+
+static bool find_device(const std::string & serial_number, jrk::device & found)
+{
+  for (const jrk::device & device : list_jrks())
+  {
+    if (device.get_serial_number() == serial_number)
+    {
+      found = device;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool find_bootloader(const std::string & serial_number,
+  bootloader_instance & found)
+{
+  for (const bootloader_instance & instance : list_bootloaders())
+  {
+    if (instance.get_serial_number() == serial_number)
+    {
+      found = instance;
+      return true;
+    }
+  }
+  return false;
+}
+
+static jrk::device wait_for_device(const std::string & serial_number)
+{
+  auto start = std::chrono::steady_clock::now();
+  jrk::device device;
+  while (!find_device(serial_number, device))
+  {
+    if (elapsed_ms(start) >= reconnect_timeout_ms)
+    {
+      throw std::runtime_error("The unit did not connect.");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(detect_period_ms));
+  }
+  return device;
+}
+
+static bootloader_instance wait_for_bootloader(const std::string & serial_number)
+{
+  auto start = std::chrono::steady_clock::now();
+  bootloader_instance instance;
+  while (!find_bootloader(serial_number, instance))
+  {
+    if (elapsed_ms(start) >= reconnect_timeout_ms)
+    {
+      throw std::runtime_error("The unit did not connect in bootloader mode.");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(detect_period_ms));
+  }
+  return instance;
+}
+
+class provisioning_pipeline
+{
+public:
+  provisioning_pipeline(const jrk::settings & settings,
+    const firmware_archive::data & firmware)
+    : settings(settings), firmware(firmware)
+  {
+    expected_image = settings.encode();
+  }
+
+  ~provisioning_pipeline()
+  {
+    finish();
+  }
+
+  void start()
+  {
+    for (int i = first_stage(); i < stage_count; i++)
+    {
+      threads.push_back(std::thread(&provisioning_pipeline::run_stage, this,
+        (stage_id)i));
+    }
+  }
+
+  void add(std::shared_ptr<unit> u)
+  {
+    queues[first_stage()].push(u);
+  }
+
+  std::shared_ptr<unit> get_finished_unit()
+  {
+    return finished.try_pop();
+  }
+
+  // Lets the units in the pipeline finish and stops the threads.
+  void finish()
+  {
+    queues[first_stage()].close();
+    for (std::thread & thread : threads) { thread.join(); }
+    threads.clear();
+    finished.close();
+  }
+
+  stage_stats get_stats(stage_id stage)
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats[stage];
+  }
+
+  bool has_stage(stage_id stage) const
+  {
+    return stage >= first_stage();
+  }
+
+private:
+  int first_stage() const
+  {
+    return firmware ? firmware_stage : settings_stage;
+  }
+
+  void run_stage(stage_id stage)
+  {
+    unit_queue & output = stage + 1 < stage_count ?
+      queues[stage + 1] : finished;
+
+    while (std::shared_ptr<unit> u = queues[stage].pop())
+    {
+      if (!u->error_message.empty())
+      {
+        output.push(u);
+        continue;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      try
+      {
+        switch (stage)
+        {
+        case firmware_stage: upgrade_firmware(*u); break;
+        case settings_stage: write_settings(*u); break;
+        case verify_stage: verify_settings(*u); break;
+        default: break;
+        }
+      }
+      catch (const std::exception & error)
+      {
+        u->error_message = error.what();
+        u->failed_stage = stage;
+      }
+      u->stage_time[stage] = elapsed_ms(start);
+
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stage_stats & s = stats[stage];
+        s.count++;
+        s.total += u->stage_time[stage];
+        if (u->stage_time[stage] > s.max) { s.max = u->stage_time[stage]; }
+      }
+
+      output.push(u);
+    }
+
+    output.close();
+  }
+
+  void upgrade_firmware(const unit & u)
+  {
+    bootloader_instance instance;
+    jrk::device device;
+    if (find_device(u.serial_number, device))
+    {
+      jrk::handle(device).start_bootloader();
+    }
+    instance = wait_for_bootloader(u.serial_number);
+
+    const firmware_archive::image * image =
+      firmware.find_image(instance.get_vendor_id(), instance.get_product_id());
+    if (image == NULL)
+    {
+      throw std::runtime_error(
+        "The firmware file does not contain any firmware for this unit.");
+    }
+
+    {
+      bootloader_handle handle(instance);
+      handle.set_status_listener(NULL);
+      handle.apply_image(*image);
+      handle.restart_device();
+    }
+
+    wait_for_device(u.serial_number);
+  }
+
+  void write_settings(const unit & u)
+  {
+    jrk::device device = wait_for_device(u.serial_number);
+    if (device.get_product() != settings.get_product())
+    {
+      throw std::runtime_error(std::string("The settings are for the ") +
+        jrk_look_up_product_name_ui(settings.get_product()) +
+        ", but the unit is a " +
+        jrk_look_up_product_name_ui(device.get_product()) + ".");
+    }
+
+    jrk::handle handle(device);
+    handle.set_eeprom_settings(settings);
+    handle.reinitialize();
+  }
+
+  // Reads the raw EEPROM settings bytes.  They are not decoded, because
+  // decoding and encoding again would turn the bytes of settings this
+  // software does not know about into zeros.
+  static jrk::settings_image read_eeprom_image(jrk::handle & handle)
+  {
+    jrk::settings_image image = {};
+    static_assert(sizeof(image.bytes) - 1 <= JRK_MAX_USB_RESPONSE_SIZE,
+      "The settings do not fit in one segment.");
+    handle.get_eeprom_setting_segment(1, sizeof(image.bytes) - 1,
+      image.bytes + 1);
+    return image;
+  }
+
+  // Every EEPROM settings byte was written from expected_image, with zeros
+  // for the settings this software does not know about, so every byte has to
+  // match.  A byte that differs means the write did not work.
+  void compare_eeprom_settings(const jrk::settings_image & image)
+  {
+    // Byte 0 is not a setting.
+    for (size_t i = 1; i < sizeof(image.bytes); i++)
+    {
+      if (image.bytes[i] != expected_image.bytes[i])
+      {
+        std::ostringstream message;
+        message << "EEPROM setting byte " << i << " is "
+          << (unsigned int)image.bytes[i] << " instead of "
+          << (unsigned int)expected_image.bytes[i] << ".";
+        throw std::runtime_error(message.str());
+      }
+    }
+  }
+
+  // The RAM settings are only checked to show that the unit was
+  // reinitialized and is running with the new settings.  The Jrk does not
+  // promise that every byte of RAM mirrors the EEPROM, so only settings that
+  // it uses from RAM while running are compared.
+  void compare_ram_settings(const jrk::settings & ram)
+  {
+    auto check = [](const char * name, uint32_t actual, uint32_t expected)
+    {
+      if (actual != expected)
+      {
+        std::ostringstream message;
+        message << "RAM setting " << name << " is " << actual
+          << " instead of " << expected << ".";
+        throw std::runtime_error(message.str());
+      }
+    };
+
+    check("input_mode", ram.get_input_mode(), settings.get_input_mode());
+    check("feedback_mode", ram.get_feedback_mode(),
+      settings.get_feedback_mode());
+    check("proportional_multiplier", ram.get_proportional_multiplier(),
+      settings.get_proportional_multiplier());
+    check("proportional_exponent", ram.get_proportional_exponent(),
+      settings.get_proportional_exponent());
+    check("integral_multiplier", ram.get_integral_multiplier(),
+      settings.get_integral_multiplier());
+    check("integral_exponent", ram.get_integral_exponent(),
+      settings.get_integral_exponent());
+    check("derivative_multiplier", ram.get_derivative_multiplier(),
+      settings.get_derivative_multiplier());
+    check("derivative_exponent", ram.get_derivative_exponent(),
+      settings.get_derivative_exponent());
+    check("pid_period", ram.get_pid_period(), settings.get_pid_period());
+    check("max_duty_cycle_forward", ram.get_max_duty_cycle_forward(),
+      settings.get_max_duty_cycle_forward());
+    check("max_duty_cycle_reverse", ram.get_max_duty_cycle_reverse(),
+      settings.get_max_duty_cycle_reverse());
+    check("max_acceleration_forward", ram.get_max_acceleration_forward(),
+      settings.get_max_acceleration_forward());
+    check("max_acceleration_reverse", ram.get_max_acceleration_reverse(),
+      settings.get_max_acceleration_reverse());
+    check("encoded_hard_current_limit_forward",
+      ram.get_encoded_hard_current_limit_forward(),
+      settings.get_encoded_hard_current_limit_forward());
+    check("encoded_hard_current_limit_reverse",
+      ram.get_encoded_hard_current_limit_reverse(),
+      settings.get_encoded_hard_current_limit_reverse());
+  }
+
+  void verify_settings(const unit & u)
+  {
+    jrk::handle handle(wait_for_device(u.serial_number));
+    compare_eeprom_settings(read_eeprom_image(handle));
+    compare_ram_settings(handle.get_ram_settings());
+  }
+
+  const jrk::settings & settings;
+  const firmware_archive::data & firmware;
+  jrk::settings_image expected_image;
+
+  unit_queue queues[stage_count];
+  unit_queue finished;
+  std::vector<std::thread> threads;
+
+  std::mutex stats_mutex;
+  stage_stats stats[stage_count];
+};
+
+// Returns the serial numbers of the units that are connected, as Jrks or as
+// bootloaders we have firmware for.
+static std::set<std::string> list_units(const firmware_archive::data & firmware)
+{
+  std::set<std::string> units;
+  for (const jrk::device & device : list_jrks())
+  {
+    units.insert(device.get_serial_number());
+  }
+
+  if (firmware)
+  {
+    for (const bootloader_instance & instance : list_bootloaders())
+    {
+      if (firmware.find_image(instance.get_vendor_id(),
+        instance.get_product_id()))
+      {
+        units.insert(instance.get_serial_number());
+      }
+    }
+  }
+  return units;
+}
+
+static void print_unit(const unit & u, const provisioning_pipeline & pipeline)
+{
+  double total = elapsed_ms(u.start_time) / 1000.0;
+  std::cout << u.serial_number << ": ";
+  if (u.error_message.empty())
+  {
+    std::cout << "Provisioned in " << total << " s (";
+    const char * separator = "";
+    for (int i = 0; i < stage_count; i++)
+    {
+      if (!pipeline.has_stage((stage_id)i)) { continue; }
+      std::cout << separator << stage_names[i] << " "
+        << u.stage_time[i] / 1000.0 << " s";
+      separator = ", ";
+    }
+    std::cout << ")." << std::endl;
+  }
+  else
+  {
+    std::cout << "Failed in " << stage_names[u.failed_stage] << " stage: "
+      << u.error_message << std::endl;
+  }
+}
+
+static void print_summary(provisioning_pipeline & pipeline,
+  uint32_t provisioned, uint32_t failed, uint64_t time)
+{
+  std::cout << std::endl;
+  std::cout << std::left << std::setw(10) << "Stage" << std::right
+    << std::setw(7) << "Units" << std::setw(10) << "Mean (s)"
+    << std::setw(10) << "Max (s)" << std::endl;
+
+  int slowest = -1;
+  double slowest_mean = 0;
+  for (int i = 0; i < stage_count; i++)
+  {
+    if (!pipeline.has_stage((stage_id)i)) { continue; }
+    stage_stats stats = pipeline.get_stats((stage_id)i);
+    std::cout << std::left << std::setw(10) << stage_names[i] << std::right
+      << std::setw(7) << stats.count
+      << std::setw(10) << stats.mean() / 1000
+      << std::setw(10) << stats.max / 1000.0 << std::endl;
+    if (stats.count && stats.mean() > slowest_mean)
+    {
+      slowest = i;
+      slowest_mean = stats.mean();
+    }
+  }
+
+  std::cout << std::endl;
+  std::cout << "Provisioned " << provisioned << " units, " << failed
+    << " failed, in " << time / 1000.0 << " s." << std::endl;
+  if (slowest >= 0)
+  {
+    std::cout << "The " << stage_names[slowest] << " stage is the slowest, "
+      "so the station can provision at most one unit every "
+      << slowest_mean / 1000 << " s." << std::endl;
+  }
+}
+
+void provision(const std::string & settings_filename,
+  const std::string & firmware_filename, uint32_t duration_s)
+{
+  std::string settings_string = read_string_from_file_or_pipe(settings_filename);
+  jrk::settings settings = jrk::settings::read_from_string(settings_string);
+
+  // Every unit gets exactly these settings, so check them once up front.
+  std::string warnings;
+  settings.fix(&warnings);
+  if (!warnings.empty())
+  {
+    std::cerr << warnings;
+    throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+      "The settings in " + settings_filename + " are not valid.  "
+      "Use --fix-settings to fix them.");
+  }
+
+  firmware_archive::data firmware;
+  if (!firmware_filename.empty())
+  {
+    firmware.read_from_string(read_string_from_file(firmware_filename));
+  }
+
+  // Units that are already connected are provisioned too: the station might
+  // have been started after the first unit was plugged in.
+  provisioning_pipeline pipeline(settings, firmware);
+  pipeline.start();
+
+  // Units in the pipeline, which might disappear for a while when they
+  // restart.
+  std::set<std::string> in_progress;
+
+  // Units that are done and have not been unplugged yet.
+  std::set<std::string> done;
+
+  uint32_t provisioned = 0;
+  uint32_t failed = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  stop_requested = 0;
+  std::signal(SIGINT, request_stop);
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "Waiting for units.  Press Ctrl+C to stop." << std::endl;
+
+  auto report_finished_units = [&]() {
+    while (std::shared_ptr<unit> u = pipeline.get_finished_unit())
+    {
+      print_unit(*u, pipeline);
+      if (u->error_message.empty()) { provisioned++; } else { failed++; }
+      in_progress.erase(u->serial_number);
+      done.insert(u->serial_number);
+    }
+  };
+
+  try
+  {
+    while (!stop_requested)
+    {
+      report_finished_units();
+
+      std::set<std::string> connected = list_units(firmware);
+      for (const std::string & serial_number : connected)
+      {
+        if (in_progress.count(serial_number) || done.count(serial_number))
+        {
+          continue;
+        }
+
+        std::shared_ptr<unit> u = std::make_shared<unit>();
+        u->serial_number = serial_number;
+        u->start_time = std::chrono::steady_clock::now();
+        in_progress.insert(serial_number);
+        pipeline.add(u);
+        std::cout << serial_number << ": Connected." << std::endl;
+      }
+
+      // Forget units that were unplugged so they can be provisioned again.
+      for (auto it = done.begin(); it != done.end(); )
+      {
+        if (connected.count(*it)) { ++it; } else { it = done.erase(it); }
+      }
+
+      if (duration_s && elapsed_ms(start) >= (uint64_t)duration_s * 1000)
+      {
+        break;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(detect_period_ms));
+    }
+  }
+  catch (...)
+  {
+    std::signal(SIGINT, SIG_DFL);
+    throw;
+  }
+
+  // A second Ctrl+C stops the program without waiting for the units.
+  std::signal(SIGINT, SIG_DFL);
+
+  if (!in_progress.empty())
+  {
+    std::cout << "Finishing the units in progress." << std::endl;
+  }
+  pipeline.finish();
+  report_finished_units();
+
+  print_summary(pipeline, provisioned, failed, elapsed_ms(start));
+
+  if (failed)
+  {
+    throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+      std::to_string(failed) + (failed == 1 ? " unit" : " units") +
+      " failed.");
+  }
+}
@@ -0,0 +1,167 @@
+// Streams the variables of every selected device as CSV, reading each device
+// more often while it is moving and less often while it is idle.
+//
+// While streaming, commands can be typed on standard input:
+//
+//   stop                 Stops every device.
+//   stop SERIAL          Stops the device with the specified serial number.
+//   target SERIAL VALUE  Sets the target of the device.
+//
+// The commands go through jrk::shared_handle, so they are sent as soon as the
+// read in progress finishes instead of waiting behind the other reads.
+
+#include "cli.h"
+
+#include <jrk_shared_handle.hpp>
+
+struct stream_device
+{
+  std::string serial_number;
+  std::unique_ptr<jrk::shared_handle> handle;
+};
+
+typedef std::vector<stream_device> stream_device_list;
+
+static void handle_command(stream_device_list & devices,
+  const std::string & line)
+{
+  std::istringstream stream(line);
+  std::string command, serial_number;
+  stream >> command >> serial_number;
+  if (command.empty()) { return; }
+
+  uint16_t target = 0;
+  if (command == "target")
+  {
+    uint32_t value;
+    if (serial_number.empty() || !(stream >> value) || value > 4095)
+    {
+      throw std::runtime_error("Usage: target SERIAL VALUE (0 to 4095).");
+    }
+    target = value;
+  }
+  else if (command != "stop")
+  {
+    throw std::runtime_error("Unknown command: " + command + ".");
+  }
+
+  bool found = false;
+  for (stream_device & device : devices)
+  {
+    if (!serial_number.empty() && device.serial_number != serial_number)
+    {
+      continue;
+    }
+    found = true;
+
+    if (command == "stop")
+    {
+      device.handle->stop_motor();
+    }
+    else
+    {
+      device.handle->set_target(target);
+    }
+  }
+
+  if (!found)
+  {
+    throw std::runtime_error("No device with serial number " +
+      serial_number + ".");
+  }
+}
+
+// Runs in its own thread.  It holds a reference to the devices so they stay
+// open if streaming ends while it is waiting for input.
+static void handle_commands(std::shared_ptr<stream_device_list> devices)
+{
+  std::string line;
+  while (std::getline(std::cin, line))
+  {
+    try
+    {
+      handle_command(*devices, line);
+    }
+    catch (const std::exception & error)
+    {
+      std::cerr << "Error: " << error.what() << std::endl;
+    }
+  }
+}
+
+void stream_variables(device_selector & selector, uint32_t budget,
+  uint32_t duration_s)
+{
+  std::vector<jrk::device> list = selector.list_devices();
+  if (list.size() == 0)
+  {
+    // Let the selector report that nothing was found.
+    selector.select_device();
+  }
+
+  auto devices = std::make_shared<stream_device_list>();
+  for (const jrk::device & device : list)
+  {
+    stream_device d;
+    d.serial_number = device.get_serial_number();
+    d.handle.reset(new jrk::shared_handle(device));
+    devices->push_back(std::move(d));
+  }
+
+  jrk::poll_scheduler scheduler = jrk::poll_scheduler::create(devices->size());
+  scheduler.set_budget(budget);
+
+  // Clearing these flags lets the scheduler see new errors, and keeps the
+  // chopping count meaningful for each line.
+  uint16_t flags = (1 << JRK_GET_VARIABLES_FLAG_CLEAR_ERROR_FLAGS_OCCURRED) |
+    (1 << JRK_GET_VARIABLES_FLAG_CLEAR_CURRENT_CHOPPING_OCCURRENCE_COUNT);
+
+  std::thread(handle_commands, devices).detach();
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::cout << "time,serial_number,period,target,feedback,scaled_feedback,"
+    "error,duty_cycle,current,current_chopping_occurrence_count,"
+    "error_flags_halting" << std::endl;
+
+  while (true)
+  {
+    uint64_t due;
+    size_t index = scheduler.next(&due);
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(due));
+
+    if (duration_s && due >= (uint64_t)duration_s * 1000) { break; }
+
+    stream_device & device = (*devices)[index];
+
+    // One device failing (e.g. because it was unplugged) should not stop the
+    // stream for the others.  The scheduler reads it again later.
+    jrk::variables vars;
+    try
+    {
+      vars = device.handle->get_variables(flags);
+    }
+    catch (const std::exception & error)
+    {
+      std::cerr << "Error: " << device.serial_number << ": " << error.what()
+        << std::endl;
+    }
+
+    uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    scheduler.add_sample(index, vars, time);
+    if (!vars.is_present()) { continue; }
+
+    std::cout << time << ','
+      << device.serial_number << ','
+      << scheduler.get_period(index) << ','
+      << vars.get_target() << ','
+      << vars.get_feedback() << ','
+      << vars.get_scaled_feedback() << ','
+      << vars.get_error() << ','
+      << vars.get_duty_cycle() << ','
+      << vars.get_current() << ','
+      << (unsigned int)vars.get_current_chopping_occurrence_count() << ','
+      << vars.get_error_flags_halting() << std::endl;
+  }
+}
@@ -0,0 +1,164 @@
+// Tracks the accumulated usage of a device's motor in a usage file, and prints
+// it.
+
+#include "cli.h"
+
+#include <csignal>
+
+// How often we read the variables while tracking usage.
+static const uint32_t sample_period_ms = 50;
+
+// How often we save the usage file while tracking usage.
+static const uint32_t save_period_ms = 10000;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void request_stop(int)
+{
+  stop_requested = 1;
+}
+
+// Returns the path of the usage file for a device.  Each device gets its own
+// file, named after its serial number, so a whole fleet can share a
+// directory.
+static std::string usage_filename(const std::string & dir,
+  const std::string & serial_number)
+{
+  std::string name = serial_number + ".usage";
+  if (dir.empty()) { return name; }
+  char last = dir[dir.size() - 1];
+  if (last == '/' || last == '\\') { return dir + name; }
+  return dir + "/" + name;
+}
+
+// Loads the usage file for a device, or returns zero usage if there is no
+// file yet.
+static jrk::usage load_usage(const std::string & filename,
+  const std::string & serial_number)
+{
+  std::ifstream file(filename);
+  if (!file)
+  {
+    return jrk::usage::create(serial_number);
+  }
+
+  jrk::usage usage = jrk::usage::read_from_string(
+    read_string_from_file(filename));
+  if (usage.get_serial_number() != serial_number)
+  {
+    throw std::runtime_error(filename + ": The usage file is for device " +
+      usage.get_serial_number() + ", not " + serial_number + ".");
+  }
+  return usage;
+}
+
+void track_usage(device_selector & selector, const std::string & dir,
+  uint32_t duration_s)
+{
+  jrk::device device = selector.select_device();
+  jrk::handle handle(device);
+  std::string serial_number = device.get_serial_number();
+  std::string filename = usage_filename(dir, serial_number);
+  jrk::usage usage = load_usage(filename, serial_number);
+
+  stop_requested = 0;
+  std::signal(SIGINT, request_stop);
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t last_save_time = 0;
+
+  try
+  {
+    while (!stop_requested)
+    {
+      jrk::variables vars = handle.get_variables(0);
+      uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      usage.add_sample(vars, time);
+
+      if (duration_s && time >= (uint64_t)duration_s * 1000) { break; }
+
+      if (time - last_save_time >= save_period_ms)
+      {
+        write_string_to_file_atomic(filename, usage.to_string());
+        last_save_time = time;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(sample_period_ms));
+    }
+  }
+  catch (...)
+  {
+    // Keep what we accumulated before losing the device.
+    std::signal(SIGINT, SIG_DFL);
+    write_string_to_file_atomic(filename, usage.to_string());
+    throw;
+  }
+
+  std::signal(SIGINT, SIG_DFL);
+  write_string_to_file_atomic(filename, usage.to_string());
+}
+
+static std::string format_duration(uint64_t ms)
+{
+  uint64_t s = ms / 1000;
+  std::ostringstream stream;
+  stream << s / 3600 << ":"
+    << std::setfill('0') << std::setw(2) << s / 60 % 60 << ":"
+    << std::setw(2) << s % 60;
+  return stream.str();
+}
+
+static std::string format_fixed(double value, int precision)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(precision) << value;
+  return stream.str();
+}
+
+void print_usage(device_selector & selector, const std::string & dir,
+  const std::string & specified_serial_number)
+{
+  std::string serial_number = specified_serial_number;
+  if (serial_number.empty())
+  {
+    serial_number = selector.select_device().get_serial_number();
+  }
+
+  std::string filename = usage_filename(dir, serial_number);
+  std::ifstream file(filename);
+  if (!file)
+  {
+    throw std::runtime_error(filename + ": There is no usage file for "
+      "device " + serial_number + ".");
+  }
+  jrk::usage usage = load_usage(filename, serial_number);
+
+  // The output here is YAML, like the output of --status.
+  static const int left_column_width = 30;
+  auto left_column = std::setw(left_column_width);
+  std::cout << std::left << std::setfill(' ');
+
+  std::cout << left_column << "Serial number: "
+    << usage.get_serial_number() << std::endl;
+  std::cout << left_column << "Monitored time: "
+    << format_duration(usage.get_monitored_time()) << std::endl;
+  std::cout << left_column << "Run time: "
+    << format_duration(usage.get_run_time()) << std::endl;
+  std::cout << left_column << "Time at current limit: "
+    << format_duration(usage.get_current_limit_time()) << std::endl;
+  std::cout << left_column << "Energy: "
+    << format_fixed(usage.get_energy() / 3600e6, 3) << " Wh" << std::endl;
+  std::cout << left_column << "Charge: "
+    << format_fixed(usage.get_charge() / 3600e6, 3) << " Ah" << std::endl;
+
+  std::cout << "Time at duty cycle:" << std::endl;
+  for (uint8_t band = 0; band < JRK_USAGE_DUTY_CYCLE_BAND_COUNT; band++)
+  {
+    std::ostringstream label;
+    label << "  " << band * 100 / JRK_USAGE_DUTY_CYCLE_BAND_COUNT
+      << "% to " << (band + 1) * 100 / JRK_USAGE_DUTY_CYCLE_BAND_COUNT << "%: ";
+    std::cout << left_column << label.str()
+      << format_duration(usage.get_duty_cycle_band_time(band)) << std::endl;
+  }
+}
@@ -0,0 +1,477 @@
+#include "capture_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char capture_magic[8] = { 'J', 'R', 'K', 'C', 'A', 'P', '1', '\n' };
+
+// The magic number, channel count, and header size.
+static const size_t capture_fixed_header_size = 16;
+
+static void put_u32(uint8_t * p, uint32_t v)
+{
+  p[0] = v >> 0 & 0xFF;
+  p[1] = v >> 8 & 0xFF;
+  p[2] = v >> 16 & 0xFF;
+  p[3] = v >> 24 & 0xFF;
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+    (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_i64(uint8_t * p, int64_t v)
+{
+  put_u32(p, (uint64_t)v & 0xFFFFFFFF);
+  put_u32(p + 4, (uint64_t)v >> 32);
+}
+
+static int64_t get_i64(const uint8_t * p)
+{
+  return (int64_t)((uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32);
+}
+
+static void put_float(uint8_t * p, float f)
+{
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  put_u32(p, v);
+}
+
+static float get_float_at(const uint8_t * p)
+{
+  uint32_t v = get_u32(p);
+  float f;
+  memcpy(&f, &v, sizeof(f));
+  return f;
+}
+
+capture_writer::capture_writer(const std::string & filename,
+  const std::vector<capture_channel> & channels)
+  : filename(filename), channel_count(channels.size())
+{
+  std::vector<uint8_t> header(capture_fixed_header_size);
+  memcpy(header.data(), capture_magic, sizeof(capture_magic));
+  put_u32(&header[8], channel_count);
+  for (const capture_channel & channel : channels)
+  {
+    header.insert(header.end(), channel.name.begin(), channel.name.end());
+    header.push_back(0);
+    header.insert(header.end(),
+      channel.expression.begin(), channel.expression.end());
+    header.push_back(0);
+  }
+  while (header.size() % 8) { header.push_back(0); }
+  put_u32(&header[12], header.size());
+
+  record.resize(8 + 4 * channel_count);
+
+  // Remove the old file instead of truncating it, so a reader that has it
+  // mapped keeps seeing the old samples instead of crashing.  On Windows,
+  // this fails for a mapped file, and then so does fopen.
+  std::remove(filename.c_str());
+
+  file = fopen(filename.c_str(), "wb");
+  if (file == NULL)
+  {
+    int error_code = errno;
+    throw std::runtime_error(filename + ": " + strerror(error_code) + ".");
+  }
+
+  if (fwrite(header.data(), header.size(), 1, file) != 1)
+  {
+    fclose(file);
+    file = NULL;
+    throw std::runtime_error(filename + ": Failed to write to file.");
+  }
+}
+
+capture_writer::~capture_writer()
+{
+  if (file) { fclose(file); }
+}
+
+void capture_writer::write_sample(int64_t time, const double * values)
+{
+  put_i64(&record[0], time);
+  for (size_t i = 0; i < channel_count; i++)
+  {
+    put_float(&record[8 + 4 * i], values[i]);
+  }
+
+  if (fwrite(record.data(), record.size(), 1, file) != 1)
+  {
+    throw std::runtime_error(filename + ": Failed to write to file.");
+  }
+  sample_count++;
+}
+
+capture_reader::capture_reader(const std::string & filename)
+  : filename(filename)
+{
+  map_file();
+  try
+  {
+    parse_header();
+  }
+  catch (...)
+  {
+    unmap_file();
+    throw;
+  }
+
+  // Set up the decimation levels, without computing anything yet.
+  size_t count = sample_count;
+  size_t bucket_size = 1;
+  while (count > 1)
+  {
+    bucket_size *= DECIMATION_FACTOR;
+    count = (count + DECIMATION_FACTOR - 1) / DECIMATION_FACTOR;
+    level l;
+    l.bucket_size = bucket_size;
+    l.bucket_count = count;
+    levels.push_back(l);
+  }
+}
+
+capture_reader::~capture_reader()
+{
+  unmap_file();
+}
+
+#ifdef _WIN32
+
+void capture_reader::map_file()
+{
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ,
+    FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error(filename + ": Failed to open file.");
+  }
+  file_handle = file;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size))
+  {
+    unmap_file();
+    throw std::runtime_error(filename + ": Failed to get the file size.");
+  }
+  size = file_size.QuadPart;
+  if (size < capture_fixed_header_size)
+  {
+    unmap_file();
+    throw std::runtime_error(filename + ": Not a capture file.");
+  }
+
+  mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping_handle != NULL)
+  {
+    data = (const uint8_t *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (data == NULL)
+  {
+    unmap_file();
+    throw std::runtime_error(filename + ": Failed to map file.");
+  }
+}
+
+void capture_reader::unmap_file()
+{
+  if (data) { UnmapViewOfFile(data); }
+  if (mapping_handle) { CloseHandle(mapping_handle); }
+  if (file_handle) { CloseHandle(file_handle); }
+  data = NULL;
+  mapping_handle = NULL;
+  file_handle = NULL;
+}
+
+#else
+
+void capture_reader::map_file()
+{
+  fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    int error_code = errno;
+    throw std::runtime_error(filename + ": " + strerror(error_code) + ".");
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    int error_code = errno;
+    unmap_file();
+    throw std::runtime_error(filename + ": " + strerror(error_code) + ".");
+  }
+  size = st.st_size;
+  if (size < capture_fixed_header_size)
+  {
+    unmap_file();
+    throw std::runtime_error(filename + ": Not a capture file.");
+  }
+
+  void * p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED)
+  {
+    int error_code = errno;
+    unmap_file();
+    throw std::runtime_error(filename + ": " + strerror(error_code) + ".");
+  }
+  data = (const uint8_t *)p;
+}
+
+void capture_reader::unmap_file()
+{
+  if (data) { munmap((void *)data, size); }
+  if (fd >= 0) { close(fd); }
+  data = NULL;
+  fd = -1;
+}
+
+#endif
+
+void capture_reader::parse_header()
+{
+  if (memcmp(data, capture_magic, sizeof(capture_magic)))
+  {
+    throw std::runtime_error(filename + ": Not a capture file.");
+  }
+
+  channel_count = get_u32(data + 8);
+  header_size = get_u32(data + 12);
+  if (header_size > size || header_size < capture_fixed_header_size)
+  {
+    throw std::runtime_error(filename + ": The capture header is invalid.");
+  }
+
+  // Reads a NUL-terminated string that has to be inside the header.
+  size_t pos = capture_fixed_header_size;
+  auto read_string = [&]()
+  {
+    const uint8_t * end = (const uint8_t *)memchr(data + pos, 0,
+      header_size - pos);
+    if (end == NULL)
+    {
+      throw std::runtime_error(filename + ": The capture header is invalid.");
+    }
+    std::string s((const char *)data + pos, end - (data + pos));
+    pos = end - data + 1;
+    return s;
+  };
+
+  // Each channel takes at least two bytes of the header, so this also limits
+  // how much memory a bad channel count can make us allocate.
+  if (channel_count > (header_size - pos) / 2)
+  {
+    throw std::runtime_error(filename + ": The capture header is invalid.");
+  }
+
+  channels.resize(channel_count);
+  for (capture_channel & channel : channels)
+  {
+    channel.name = read_string();
+    channel.expression = read_string();
+  }
+
+  record_size = 8 + 4 * channel_count;
+  sample_count = (size - header_size) / record_size;
+}
+
+int64_t capture_reader::get_time(size_t sample) const
+{
+  return get_i64(data + header_size + sample * record_size);
+}
+
+float capture_reader::get_float(size_t sample, size_t channel) const
+{
+  return get_float_at(data + header_size + sample * record_size + 8 +
+    4 * channel);
+}
+
+double capture_reader::get_value(size_t sample, size_t channel) const
+{
+  return get_float(sample, channel);
+}
+
+int64_t capture_reader::get_start_time() const
+{
+  return sample_count ? get_time(0) : 0;
+}
+
+int64_t capture_reader::get_end_time() const
+{
+  return sample_count ? get_time(sample_count - 1) : 0;
+}
+
+// The times from a sample_timeline never decrease, so we can do a binary
+// search.
+size_t capture_reader::find_sample(int64_t time) const
+{
+  size_t low = 0;
+  size_t high = sample_count;
+  while (low < high)
+  {
+    size_t mid = low + (high - low) / 2;
+    if (get_time(mid) < time) { low = mid + 1; }
+    else { high = mid; }
+  }
+  return low;
+}
+
+size_t capture_reader::find_change(size_t channel, size_t first_sample) const
+{
+  if (channel >= channel_count) { return sample_count; }
+  for (size_t i = first_sample + 1; i < sample_count; i++)
+  {
+    float previous = get_float(i - 1, channel);
+    float value = get_float(i, channel);
+    if (value != previous && !(std::isnan(value) && std::isnan(previous)))
+    {
+      return i;
+    }
+  }
+  return sample_count;
+}
+
+// Computes one chunk of buckets of a level from the level below it.  NaN
+// values (channels that were not available) are skipped; a bucket with no
+// values gets NaN, which makes a gap in the plot.
+void capture_reader::build_chunk(size_t level_index, size_t chunk) const
+{
+  level & l = levels[level_index];
+  if (l.chunk_built.empty())
+  {
+    l.min.resize(l.bucket_count * channel_count);
+    l.max.resize(l.bucket_count * channel_count);
+    l.chunk_built.resize((l.bucket_count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+  }
+
+  size_t first = chunk * CHUNK_SIZE;
+  size_t last = std::min(first + CHUNK_SIZE, l.bucket_count);
+
+  size_t child_count = level_index == 0 ? sample_count :
+    levels[level_index - 1].bucket_count;
+  size_t child_first = first * DECIMATION_FACTOR;
+  size_t child_last = std::min(last * DECIMATION_FACTOR, child_count);
+
+  if (level_index != 0)
+  {
+    ensure_buckets(level_index - 1, child_first, child_last);
+  }
+
+  for (size_t bucket = first; bucket < last; bucket++)
+  {
+    size_t begin = bucket * DECIMATION_FACTOR;
+    size_t end = std::min(begin + DECIMATION_FACTOR, child_count);
+    for (size_t channel = 0; channel < channel_count; channel++)
+    {
+      float min = NAN;
+      float max = NAN;
+      for (size_t child = begin; child < end; child++)
+      {
+        float child_min, child_max;
+        if (level_index == 0)
+        {
+          child_min = child_max = get_float(child, channel);
+        }
+        else
+        {
+          const level & below = levels[level_index - 1];
+          child_min = below.min[child * channel_count + channel];
+          child_max = below.max[child * channel_count + channel];
+        }
+        if (std::isnan(child_min)) { continue; }
+        if (std::isnan(min) || child_min < min) { min = child_min; }
+        if (std::isnan(max) || child_max > max) { max = child_max; }
+      }
+      l.min[bucket * channel_count + channel] = min;
+      l.max[bucket * channel_count + channel] = max;
+    }
+  }
+
+  l.chunk_built[chunk] = true;
+}
+
+// Makes sure buckets first through last - 1 of a level are computed.
+void capture_reader::ensure_buckets(size_t level_index, size_t first,
+  size_t last) const
+{
+  if (first >= last) { return; }
+  level & l = levels[level_index];
+  for (size_t chunk = first / CHUNK_SIZE; chunk <= (last - 1) / CHUNK_SIZE; chunk++)
+  {
+    if (l.chunk_built.empty() || !l.chunk_built[chunk])
+    {
+      build_chunk(level_index, chunk);
+    }
+  }
+}
+
+void capture_reader::get_plot_points(size_t channel, int64_t start,
+  int64_t end, size_t max_points, std::vector<double> & times,
+  std::vector<double> & values) const
+{
+  times.clear();
+  values.clear();
+  if (sample_count == 0 || channel >= channel_count) { return; }
+
+  size_t first = find_sample(start);
+  if (first > 0) { first--; }
+  size_t last = find_sample(end + 1);
+  if (last < sample_count) { last++; }
+  size_t count = last - first;
+
+  if (count <= max_points || levels.empty())
+  {
+    for (size_t i = first; i < last; i++)
+    {
+      times.push_back(get_time(i));
+      values.push_back(get_float(i, channel));
+    }
+    return;
+  }
+
+  // Use the finest level where two points per bucket fit in max_points.
+  size_t level_index = 0;
+  while (level_index + 1 < levels.size() &&
+    count / levels[level_index].bucket_size * 2 > max_points)
+  {
+    level_index++;
+  }
+  const level & l = levels[level_index];
+
+  size_t first_bucket = first / l.bucket_size;
+  size_t last_bucket = (last - 1) / l.bucket_size + 1;
+  ensure_buckets(level_index, first_bucket, last_bucket);
+
+  // Draw each bucket as its minimum at the time of its first sample and its
+  // maximum at the time of its middle sample, which shows the envelope of
+  // the signal.
+  for (size_t bucket = first_bucket; bucket < last_bucket; bucket++)
+  {
+    size_t begin = bucket * l.bucket_size;
+    size_t middle = std::min(begin + l.bucket_size / 2, sample_count - 1);
+    times.push_back(get_time(begin));
+    values.push_back(l.min[bucket * channel_count + channel]);
+    times.push_back(get_time(middle));
+    values.push_back(l.max[bucket * channel_count + channel]);
+  }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Captures are files holding the values of the graph's channels for every
+// sample, so they can be reviewed later without a device.
+//
+// The file starts with a header that lists the channels, followed by
+// fixed-size records, one per sample.  Each record is the time of the sample
+// in milliseconds on the sample_timeline (a 64-bit integer) followed by one
+// 32-bit float per channel.  All numbers are little-endian.  Since the
+// records have a fixed size, a reader can find any sample without scanning
+// the file, and a capture that was cut off by a crash is still readable up to
+// its last complete record.
+
+struct capture_channel
+{
+  std::string name;
+
+  // The expression for a derived channel, or empty for a native channel.
+  std::string expression;
+};
+
+// Writes a capture file one sample at a time.  Throws std::runtime_error if
+// the file cannot be written.
+class capture_writer
+{
+public:
+  capture_writer(const std::string & filename,
+    const std::vector<capture_channel> & channels);
+  ~capture_writer();
+
+  capture_writer(const capture_writer &) = delete;
+  capture_writer & operator=(const capture_writer &) = delete;
+
+  // The values array must have one element per channel.  Values that are not
+  // available can be NaN.
+  void write_sample(int64_t time, const double * values);
+
+  const std::string & get_filename() const { return filename; }
+  uint64_t get_sample_count() const { return sample_count; }
+
+private:
+  std::string filename;
+  FILE * file = NULL;
+  size_t channel_count;
+  std::vector<uint8_t> record;
+  uint64_t sample_count = 0;
+};
+
+// Reads a capture file through a read-only memory mapping, so opening a
+// capture is instant no matter how long it is, and only the parts that are
+// actually displayed get read from the disk.  The samples never change after
+// the file is opened, so one reader can be shared by several views.
+//
+// The file must not be truncated while it is open.  The capture_writer
+// replaces files instead of truncating them, and Windows does not allow
+// truncating a mapped file, but on other systems, another program truncating
+// the file would make reading the missing part crash the process with
+// SIGBUS.
+//
+// To display a long span of time, the reader uses a pyramid of decimation
+// levels: each bucket of level k holds the minimum and maximum of
+// DECIMATION_FACTOR buckets of level k - 1, and level 0 is the samples
+// themselves.  The buckets are computed in chunks the first time they are
+// needed and then cached.
+//
+// Throws std::runtime_error if the file cannot be opened or is not a capture.
+class capture_reader
+{
+public:
+  static const size_t DECIMATION_FACTOR = 16;
+
+  explicit capture_reader(const std::string & filename);
+  ~capture_reader();
+
+  capture_reader(const capture_reader &) = delete;
+  capture_reader & operator=(const capture_reader &) = delete;
+
+  const std::string & get_filename() const { return filename; }
+  const std::vector<capture_channel> & get_channels() const { return channels; }
+  size_t get_sample_count() const { return sample_count; }
+
+  int64_t get_time(size_t sample) const;
+  double get_value(size_t sample, size_t channel) const;
+
+  // Returns the time of the first and last samples, or 0 if there are none.
+  int64_t get_start_time() const;
+  int64_t get_end_time() const;
+
+  // Returns the index of the first sample at or after the specified time.
+  size_t find_sample(int64_t time) const;
+
+  // Returns the index of the first sample after first_sample where the
+  // channel has a different value than the sample before it, or the sample
+  // count if there is none.
+  size_t find_change(size_t channel, size_t first_sample) const;
+
+  // Gets the points needed to draw the specified channel between the start
+  // and end times, including one sample on each side so the line reaches the
+  // edges.  If there are more than about max_points samples in that span, the
+  // points come from the minimum and maximum of groups of samples instead.
+  void get_plot_points(size_t channel, int64_t start, int64_t end,
+    size_t max_points, std::vector<double> & times,
+    std::vector<double> & values) const;
+
+private:
+  struct level
+  {
+    // The number of samples in each bucket.
+    size_t bucket_size;
+    size_t bucket_count;
+
+    // Indexed by bucket * channel_count + channel.  Empty until used.
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<bool> chunk_built;
+  };
+
+  static const size_t CHUNK_SIZE = 256;
+
+  void map_file();
+  void unmap_file();
+  void parse_header();
+  void build_chunk(size_t level_index, size_t chunk) const;
+  void ensure_buckets(size_t level_index, size_t first, size_t last) const;
+  float get_float(size_t sample, size_t channel) const;
+
+  std::string filename;
+  std::vector<capture_channel> channels;
+  size_t channel_count = 0;
+  size_t record_size = 0;
+  size_t header_size = 0;
+  size_t sample_count = 0;
+
+  const uint8_t * data = NULL;
+  size_t size = 0;
+#ifdef _WIN32
+  void * file_handle = NULL;
+  void * mapping_handle = NULL;
+#else
+  int fd = -1;
+#endif
+
+  // levels[0] is decimation level 1.  These are a cache, so they are mutable.
+  mutable std::vector<level> levels;
+};
@@ -0,0 +1,338 @@
+#include "derived_channel.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+static const char * const input_names[derived_channel::IN_COUNT] = {
+  "input",
+  "target",
+  "feedback",
+  "scaled_feedback",
+  "error",
+  "integral",
+  "duty_cycle_target",
+  "duty_cycle",
+  "raw_current",
+  "current",
+  "current_chopping",
+  "vin_voltage",
+  "pid_period_count",
+};
+
+const char * derived_channel::input_name(size_t index)
+{
+  if (index >= IN_COUNT) { return NULL; }
+  return input_names[index];
+}
+
+static bool is_identifier_start(char c)
+{
+  return std::isalpha((unsigned char)c) || c == '_';
+}
+
+static bool is_identifier_char(char c)
+{
+  return std::isalnum((unsigned char)c) || c == '_';
+}
+
+static int find_input(const std::string & name)
+{
+  for (size_t i = 0; i < derived_channel::IN_COUNT; i++)
+  {
+    if (name == input_names[i]) { return i; }
+  }
+  return -1;
+}
+
+bool derived_channel::valid_name(const std::string & name)
+{
+  if (name.empty() || !is_identifier_start(name[0])) { return false; }
+  for (char c : name)
+  {
+    if (!is_identifier_char(c)) { return false; }
+  }
+  return find_input(name) < 0;
+}
+
+// A recursive descent parser that generates the program as it goes:
+//
+//   expression = term { ("+" | "-") term }
+//   term = unary { ("*" | "/") unary }
+//   unary = "-" unary | primary
+//   primary = number | name | name "(" arguments ")" | "(" expression ")"
+class derived_channel::compiler
+{
+public:
+  compiler(derived_channel & channel) :
+    channel(channel), text(channel.expression) {}
+
+  void compile()
+  {
+    skip_space();
+    if (pos == text.size()) { fail("The expression is empty."); }
+    parse_expression();
+    skip_space();
+    if (pos != text.size()) { fail_here("Unexpected character"); }
+  }
+
+  size_t get_max_depth() const { return max_depth; }
+
+private:
+  derived_channel & channel;
+  const std::string & text;
+  size_t pos = 0;
+  size_t depth = 0;
+  size_t max_depth = 0;
+
+  [[noreturn]] void fail(const std::string & message)
+  {
+    throw std::runtime_error(message);
+  }
+
+  [[noreturn]] void fail_here(const std::string & message)
+  {
+    std::ostringstream stream;
+    stream << message << " at position " << (pos + 1) << " of the expression.";
+    fail(stream.str());
+  }
+
+  void skip_space()
+  {
+    while (pos < text.size() && std::isspace((unsigned char)text[pos])) { pos++; }
+  }
+
+  bool accept(char c)
+  {
+    skip_space();
+    if (pos < text.size() && text[pos] == c)
+    {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c)
+  {
+    if (!accept(c)) { fail_here(std::string("Expected '") + c + "'"); }
+  }
+
+  // Adds an instruction that pops pops values and pushes one.
+  void emit(opcode op, size_t pops, uint16_t arg = 0)
+  {
+    channel.code.push_back({ op, arg });
+    depth = depth - pops + 1;
+    if (depth > max_depth) { max_depth = depth; }
+  }
+
+  void parse_expression()
+  {
+    parse_term();
+    while (true)
+    {
+      if (accept('+')) { parse_term(); emit(OP_ADD, 2); }
+      else if (accept('-')) { parse_term(); emit(OP_SUBTRACT, 2); }
+      else { break; }
+    }
+  }
+
+  void parse_term()
+  {
+    parse_unary();
+    while (true)
+    {
+      if (accept('*')) { parse_unary(); emit(OP_MULTIPLY, 2); }
+      else if (accept('/')) { parse_unary(); emit(OP_DIVIDE, 2); }
+      else { break; }
+    }
+  }
+
+  void parse_unary()
+  {
+    if (accept('-'))
+    {
+      parse_unary();
+      emit(OP_NEGATE, 1);
+      return;
+    }
+    parse_primary();
+  }
+
+  void parse_primary()
+  {
+    skip_space();
+    if (pos == text.size()) { fail("The expression ended unexpectedly."); }
+
+    if (accept('('))
+    {
+      parse_expression();
+      expect(')');
+      return;
+    }
+
+    char c = text[pos];
+    if (std::isdigit((unsigned char)c) || c == '.')
+    {
+      const char * start = text.c_str() + pos;
+      char * end;
+      double value = std::strtod(start, &end);
+      if (end == start) { fail_here("Invalid number"); }
+      pos += end - start;
+      channel.constants.push_back(value);
+      emit(OP_CONSTANT, 0, channel.constants.size() - 1);
+      return;
+    }
+
+    if (!is_identifier_start(c)) { fail_here("Unexpected character"); }
+
+    size_t start = pos;
+    while (pos < text.size() && is_identifier_char(text[pos])) { pos++; }
+    std::string word = text.substr(start, pos - start);
+
+    if (accept('('))
+    {
+      parse_call(word);
+      return;
+    }
+
+    int input = find_input(word);
+    if (input < 0) { fail("Unknown name '" + word + "' in the expression."); }
+    emit(OP_INPUT, 0, input);
+  }
+
+  void parse_call(const std::string & function)
+  {
+    struct function_info { const char * name; opcode op; size_t arg_count; };
+    static const function_info functions[] = {
+      { "abs", OP_ABS, 1 },
+      { "sqrt", OP_SQRT, 1 },
+      { "min", OP_MIN, 2 },
+      { "max", OP_MAX, 2 },
+      { "deriv", OP_DERIV, 1 },
+      { "lowpass", OP_LOWPASS, 2 },
+    };
+
+    const function_info * info = NULL;
+    for (const function_info & f : functions)
+    {
+      if (function == f.name) { info = &f; }
+    }
+    if (info == NULL) { fail("Unknown function '" + function + "' in the expression."); }
+
+    for (size_t i = 0; i < info->arg_count; i++)
+    {
+      if (i != 0) { expect(','); }
+      parse_expression();
+    }
+    expect(')');
+
+    uint16_t arg = 0;
+    if (info->op == OP_DERIV || info->op == OP_LOWPASS)
+    {
+      // Each filter in the expression keeps its own state.
+      arg = channel.states.size();
+      channel.states.push_back(filter_state());
+    }
+    emit(info->op, info->arg_count, arg);
+  }
+};
+
+derived_channel::derived_channel(const std::string & name,
+  const std::string & expression)
+  : name(name), expression(expression)
+{
+  if (!valid_name(name))
+  {
+    throw std::runtime_error("Invalid derived channel name '" + name + "'.  "
+      "Names can only contain letters, digits, and underscores, cannot start "
+      "with a digit, and cannot be the same as an input.");
+  }
+
+  compiler c(*this);
+  c.compile();
+  stack.resize(c.get_max_depth());
+  reset_state();
+}
+
+void derived_channel::reset_state()
+{
+  for (filter_state & state : states)
+  {
+    state.primed = false;
+    state.last_input = 0;
+    state.value = 0;
+  }
+  has_last_time = false;
+}
+
+double derived_channel::evaluate(const double * inputs, int64_t time)
+{
+  // dt is in milliseconds and is 0 if the sample is not new.
+  double dt = has_last_time ? (double)(time - last_time) : 0;
+  if (dt < 0) { dt = 0; }
+  has_last_time = true;
+  last_time = time;
+
+  double * sp = stack.data();
+  for (const instruction & i : code)
+  {
+    switch (i.op)
+    {
+    case OP_CONSTANT: *sp++ = constants[i.arg]; break;
+    case OP_INPUT: *sp++ = inputs[i.arg]; break;
+    case OP_ADD: sp--; sp[-1] += sp[0]; break;
+    case OP_SUBTRACT: sp--; sp[-1] -= sp[0]; break;
+    case OP_MULTIPLY: sp--; sp[-1] *= sp[0]; break;
+    case OP_DIVIDE: sp--; sp[-1] = sp[0] == 0 ? 0 : sp[-1] / sp[0]; break;
+    case OP_NEGATE: sp[-1] = -sp[-1]; break;
+    case OP_ABS: sp[-1] = std::fabs(sp[-1]); break;
+    case OP_SQRT: sp[-1] = sp[-1] < 0 ? 0 : std::sqrt(sp[-1]); break;
+    case OP_MIN: sp--; if (sp[0] < sp[-1]) { sp[-1] = sp[0]; } break;
+    case OP_MAX: sp--; if (sp[0] > sp[-1]) { sp[-1] = sp[0]; } break;
+
+    case OP_DERIV:
+      {
+        filter_state & s = states[i.arg];
+        double x = sp[-1];
+        if (!s.primed)
+        {
+          s.primed = true;
+          s.value = 0;
+          s.last_input = x;
+        }
+        else if (dt > 0)
+        {
+          s.value = (x - s.last_input) * 1000 / dt;
+          s.last_input = x;
+        }
+        sp[-1] = s.value;
+        break;
+      }
+
+    case OP_LOWPASS:
+      {
+        filter_state & s = states[i.arg];
+        sp--;
+        double time_constant = sp[0];
+        double x = sp[-1];
+        if (!s.primed)
+        {
+          s.primed = true;
+          s.value = x;
+        }
+        else if (dt > 0)
+        {
+          double alpha = time_constant > 0 ? dt / (time_constant + dt) : 1;
+          s.value += alpha * (x - s.value);
+        }
+        sp[-1] = s.value;
+        break;
+      }
+    }
+  }
+
+  return stack.empty() ? 0 : stack[0];
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A channel whose value is computed from the variables read from the device
+// using an expression like "vin_voltage * current / 1000000" or
+// "lowpass(deriv(scaled_feedback), 50)".
+//
+// The expression is compiled once into a small stack-based program, which is
+// run for each sample without allocating memory.
+//
+// Expressions can use numbers, the names of the inputs listed below, the
+// operators + - * / and parentheses, and these functions:
+//
+//   abs(x), sqrt(x), min(x, y), max(x, y)
+//   deriv(x): rate of change of x per second
+//   lowpass(x, t): first-order low-pass filter of x with a time constant of
+//     t milliseconds
+class derived_channel
+{
+public:
+  // The values that expressions can refer to, in the order they are passed
+  // to evaluate().
+  enum input
+  {
+    IN_INPUT,
+    IN_TARGET,
+    IN_FEEDBACK,
+    IN_SCALED_FEEDBACK,
+    IN_ERROR,
+    IN_INTEGRAL,
+    IN_DUTY_CYCLE_TARGET,
+    IN_DUTY_CYCLE,
+    IN_RAW_CURRENT,
+    IN_CURRENT,
+    IN_CURRENT_CHOPPING,
+    IN_VIN_VOLTAGE,
+    IN_PID_PERIOD_COUNT,
+    IN_COUNT
+  };
+
+  // Returns the name used in expressions for the specified input, or NULL.
+  static const char * input_name(size_t index);
+
+  // Returns true if the name is allowed for a derived channel: it must look
+  // like an identifier and must not be the name of an input.
+  static bool valid_name(const std::string & name);
+
+  // Compiles the expression.  Throws std::runtime_error if the name or
+  // expression is invalid.
+  derived_channel(const std::string & name, const std::string & expression);
+
+  const std::string & get_name() const { return name; }
+  const std::string & get_expression() const { return expression; }
+
+  // Computes the value of the channel for one sample.  The inputs array must
+  // have IN_COUNT elements.  The time is in milliseconds, and is used by
+  // deriv() and lowpass().  If the time is the same as the last sample, the
+  // filters keep their previous values.
+  double evaluate(const double * inputs, int64_t time);
+
+  // Clears the state of deriv() and lowpass(), for example after connecting
+  // to a different device.
+  void reset_state();
+
+private:
+  enum opcode : uint8_t
+  {
+    OP_CONSTANT,
+    OP_INPUT,
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_NEGATE,
+    OP_ABS,
+    OP_SQRT,
+    OP_MIN,
+    OP_MAX,
+    OP_DERIV,
+    OP_LOWPASS,
+  };
+
+  // The argument is an index into constants, an input, or an index into
+  // states, depending on the opcode.
+  struct instruction
+  {
+    opcode op;
+    uint16_t arg;
+  };
+
+  struct filter_state
+  {
+    bool primed;
+    double last_input;
+    double value;
+  };
+
+  class compiler;
+
+  std::string name;
+  std::string expression;
+
+  std::vector<instruction> code;
+  std::vector<double> constants;
+  std::vector<filter_state> states;
+  std::vector<double> stack;
+
+  bool has_last_time = false;
+  int64_t last_time = 0;
+};
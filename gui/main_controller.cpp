@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cmath>
 #include <sstream>
+#include <stdexcept>
 
 // This is how often we fetch the variables from the device.
 static const uint32_t UPDATE_INTERVAL_MS = 50;
@@ -13,6 +14,11 @@ static const uint32_t UPDATE_INTERVAL_MS = 50;
 // Only update the device list once per second to save CPU time.
 static const uint32_t UPDATE_DEVICE_LIST_DIVIDER = 20;
 
+// The maximum number of USB transfers to do per update while applying or
+// reloading settings.  Each EEPROM write takes a few milliseconds, so this
+// keeps each update well under UPDATE_INTERVAL_MS.
+static const uint32_t SETTINGS_TRANSFERS_PER_UPDATE = 8;
+
 void main_controller::set_window(main_window * window)
 {
   this->window = window;
@@ -66,6 +72,8 @@ bool main_controller::disconnect_device()
 {
   if (!connected()) { return true; }
 
+  if (!finish_applying_settings("disconnect")) { return false; }
+
   if (settings_modified)
   {
     std::string question =
@@ -111,6 +119,13 @@ void main_controller::connect_device(const jrk::device & device)
   // Clear the variables read from the device because they don't apply anymore.
   variables.pointer_reset();
   current_chopping_count = 0;
+  chopping_tracker.clear();
+  diagnosis_window.clear();
+  timeline.reset();
+  for (derived_channel & channel : derived_channels)
+  {
+    channel.reset_state();
+  }
 
   // Clear the settings from the device because they don't apply anymore and
   // we'd like the manual target interface to get reinitialized.
@@ -164,6 +179,7 @@ void main_controller::disconnect_device_by_error(const std::string & error_messa
 
 void main_controller::really_disconnect()
 {
+  end_settings_operation();
   device_handle.close();
   settings_modified = false;
 }
@@ -185,10 +201,17 @@ void main_controller::reload_settings(bool ask)
     return;
   }
 
+  if (settings_operation_running()) { return; }
+
   try
   {
-    settings = device_handle.get_eeprom_settings();
-    handle_settings_loaded();
+    // Specify what product the settings are for so they get decoded
+    // correctly, the same way jrk_get_eeprom_settings() does.
+    const jrk::device & device = device_handle.get_device();
+    jrk::settings new_settings = jrk::settings::create();
+    new_settings.set_product(device.get_product());
+    new_settings.set_firmware_version(device.get_firmware_version());
+    start_settings_operation(settings_operation::reload, new_settings);
   }
   catch (const std::exception & e)
   {
@@ -332,6 +355,11 @@ void main_controller::update()
         // the USB connection.
       }
       handle_variables_changed();
+
+      if (settings_operation_running())
+      {
+        continue_settings_operation();
+      }
     }
     else
     {
@@ -368,6 +396,8 @@ void main_controller::update()
 
 bool main_controller::exit()
 {
+  if (!finish_applying_settings("exit")) { return false; }
+
   if (connected() && settings_modified)
   {
     std::string question =
@@ -489,10 +519,8 @@ void main_controller::handle_device_changed()
   }
 
   window->set_disconnect_enabled(connected());
-  window->set_open_save_settings_enabled(connected());
-  window->set_reload_settings_enabled(connected());
-  window->set_restore_defaults_enabled(connected());
   window->set_tab_pages_enabled(connected());
+  handle_settings_operation_changed();
 }
 
 void main_controller::handle_variables_changed()
@@ -547,9 +575,11 @@ void main_controller::handle_variables_changed()
 
   if (connected() && variables.is_present())
   {
-    window->update_graph(variables.get_up_time());
+    int64_t time = timeline.map(variables.get_up_time());
+    update_derived_channels(time);
+    window->update_graph(time);
     window->set_motor_status_message(jrk::diagnose(cached_settings, variables),
-      variables.get_error_flags_halting());
+      variables.get_error_flags_halting(), diagnosis_window.get_findings());
   }
 }
 
@@ -663,7 +693,8 @@ void main_controller::handle_settings_changed()
   window->update_input_tab_enables();
   window->update_feedback_related_enables();
 
-  window->set_apply_settings_enabled(connected() && settings_modified);
+  window->set_apply_settings_enabled(connected() && settings_modified &&
+    !settings_operation_running());
 }
 
 void main_controller::handle_settings_loaded()
@@ -684,6 +715,68 @@ void main_controller::handle_settings_loaded()
   settings_modified = false;
 }
 
+void main_controller::add_derived_channel(const std::string & name,
+  const std::string & expression)
+{
+  for (const derived_channel & channel : derived_channels)
+  {
+    if (channel.get_name() == name)
+    {
+      throw std::runtime_error(
+        "There is already a derived channel named '" + name + "'.");
+    }
+  }
+
+  derived_channels.push_back(derived_channel(name, expression));
+  derived_values.resize(derived_channels.size());
+}
+
+void main_controller::remove_derived_channel(const std::string & name)
+{
+  for (size_t i = 0; i < derived_channels.size(); i++)
+  {
+    if (derived_channels[i].get_name() == name)
+    {
+      derived_channels.erase(derived_channels.begin() + i);
+      derived_values.resize(derived_channels.size());
+      return;
+    }
+  }
+}
+
+// Computes the derived channels from the variables, using the same units as
+// the graph uses for the native channels.
+void main_controller::update_derived_channels(int64_t time)
+{
+  if (derived_channels.empty()) { return; }
+
+  double inputs[derived_channel::IN_COUNT] = { 0 };
+  inputs[derived_channel::IN_INPUT] = variables.get_input();
+  inputs[derived_channel::IN_TARGET] = variables.get_target();
+  if (cached_settings.get_feedback_mode() != JRK_FEEDBACK_MODE_NONE)
+  {
+    inputs[derived_channel::IN_FEEDBACK] = variables.get_feedback();
+    inputs[derived_channel::IN_SCALED_FEEDBACK] = variables.get_scaled_feedback();
+    inputs[derived_channel::IN_ERROR] = variables.get_error();
+    inputs[derived_channel::IN_INTEGRAL] = variables.get_integral();
+  }
+  inputs[derived_channel::IN_DUTY_CYCLE_TARGET] = variables.get_duty_cycle_target();
+  inputs[derived_channel::IN_DUTY_CYCLE] = variables.get_duty_cycle();
+  inputs[derived_channel::IN_RAW_CURRENT] =
+    jrk::calculate_raw_current_mv64(cached_settings, variables) / 64.0;
+  inputs[derived_channel::IN_CURRENT] = variables.get_current();
+  inputs[derived_channel::IN_CURRENT_CHOPPING] =
+    variables.get_current_chopping_occurrence_count() > 0;
+  inputs[derived_channel::IN_VIN_VOLTAGE] = variables.get_vin_voltage();
+  inputs[derived_channel::IN_PID_PERIOD_COUNT] = variables.get_pid_period_count();
+
+  for (size_t i = 0; i < derived_channels.size(); i++)
+  {
+    derived_values[i] = derived_channels[i].evaluate(inputs, time);
+  }
+  window->set_derived_channel_values(derived_values);
+}
+
 uint32_t main_controller::current_limit_code_to_ma(uint16_t code)
 {
   return jrk::current_limit_decode(settings, code);
@@ -1011,6 +1104,14 @@ bool main_controller::check_settings_applied_before_wizard()
 {
   if (!connected()) { return false; }
 
+  if (settings_operation_running())
+  {
+    window->show_info_message(
+      "This wizard cannot be used right now because settings are being "
+      "applied or reloaded.  Please wait for that to finish, then try again.");
+    return false;
+  }
+
   if (settings_modified)
   {
     window->show_info_message(
@@ -1562,6 +1663,8 @@ bool main_controller::apply_settings()
 {
   if (!connected()) { return false; }
 
+  if (settings_operation_running()) { return false; }
+
   try
   {
     assert(connected());
@@ -1576,9 +1679,7 @@ bool main_controller::apply_settings()
       window->confirm(warnings.append("\nAccept these changes and apply settings?")))
     {
       settings = fixed_settings;
-      device_handle.set_eeprom_settings(settings);
-      device_handle.reinitialize();
-      handle_settings_loaded();
+      start_settings_operation(settings_operation::apply, settings);
     }
   }
   catch (const std::exception & e)
@@ -1587,7 +1688,192 @@ bool main_controller::apply_settings()
     return false;
   }
   handle_settings_changed();
-  return true;
+  return settings_operation_running();
+}
+
+bool main_controller::finish_applying_settings(const char * action)
+{
+  if (settings_op != settings_operation::apply) { return true; }
+
+  std::string question =
+    std::string("Settings are still being applied to the device.  If you ") +
+    action + " now, the device's EEPROM may be left partly written, and the "
+    "device will use those partly-written settings the next time it starts "
+    "up.\n\n"
+    "Finish applying the settings first?";
+  if (!window->confirm(question))
+  {
+    return false;
+  }
+
+  while (settings_op == settings_operation::apply)
+  {
+    continue_settings_operation();
+  }
+
+  // If applying failed, the error was already shown, and the EEPROM may be
+  // partly written, so let the user decide what to do next.
+  return !settings_modified;
+}
+
+void main_controller::cancel_settings_operation()
+{
+  if (!settings_operation_running()) { return; }
+
+  bool partially_applied = settings_op == settings_operation::apply &&
+    settings_op_written_count != 0;
+
+  end_settings_operation();
+  handle_settings_changed();
+
+  if (partially_applied)
+  {
+    window->show_warning_message(
+      "Applying settings was canceled after some of them were written to the "
+      "device's EEPROM.  The device is still using its old settings, but it "
+      "will use the partially-written settings the next time it starts up.  "
+      "Click \"Apply settings\" again to finish applying your settings.");
+  }
+}
+
+void main_controller::start_settings_operation(settings_operation op,
+  const jrk::settings & new_settings)
+{
+  settings_op = op;
+  settings_op_settings = new_settings;
+  settings_op_eeprom_read = false;
+  settings_op_addresses.clear();
+  settings_op_written_count = 0;
+
+  if (op == settings_operation::apply)
+  {
+    settings_op_new_image = new_settings.encode();
+  }
+
+  handle_settings_operation_changed();
+}
+
+void main_controller::continue_settings_operation()
+{
+  assert(connected());
+  assert(settings_operation_running());
+
+  uint32_t transfer_count = 0;
+
+  try
+  {
+    if (!settings_op_eeprom_read)
+    {
+      // All of the settings fit in one transfer.  Byte 0 is not used.
+      jrk::settings_image & image = settings_op_eeprom_image;
+      device_handle.get_eeprom_setting_segment(
+        1, sizeof(image.bytes) - 1, image.bytes + 1);
+      settings_op_eeprom_read = true;
+      transfer_count++;
+
+      if (settings_op == settings_operation::apply)
+      {
+        // Only write the bytes that are different, which saves time and
+        // EEPROM wear.
+        for (size_t i = 1; i < sizeof(image.bytes); i++)
+        {
+          if (image.bytes[i] != settings_op_new_image.bytes[i])
+          {
+            settings_op_addresses.push_back(i);
+          }
+        }
+      }
+    }
+
+    if (settings_op == settings_operation::apply)
+    {
+      while (settings_op_written_count < settings_op_addresses.size() &&
+        transfer_count < SETTINGS_TRANSFERS_PER_UPDATE)
+      {
+        uint8_t address = settings_op_addresses[settings_op_written_count];
+        device_handle.set_eeprom_setting_byte(address,
+          settings_op_new_image.bytes[address]);
+        settings_op_written_count++;
+        transfer_count++;
+      }
+
+      if (settings_op_written_count < settings_op_addresses.size())
+      {
+        // There is more to write; continue in the next update.
+        handle_settings_operation_changed();
+        return;
+      }
+
+      device_handle.reinitialize();
+    }
+    else
+    {
+      settings_op_settings.decode(settings_op_eeprom_image);
+    }
+  }
+  catch (const std::exception & e)
+  {
+    // End the operation before showing the error so that it does not continue
+    // while the message box is open.
+    settings_operation op = settings_op;
+    end_settings_operation();
+    if (op == settings_operation::reload)
+    {
+      settings_modified = true;
+      show_exception(e,
+        "There was an error loading the settings from the device.");
+    }
+    else
+    {
+      show_exception(e);
+    }
+    handle_settings_changed();
+    return;
+  }
+
+  settings = settings_op_settings;
+  end_settings_operation();
+  handle_settings_loaded();
+  handle_settings_changed();
+}
+
+void main_controller::end_settings_operation()
+{
+  if (!settings_operation_running()) { return; }
+  settings_op = settings_operation::none;
+  settings_op_settings.pointer_reset();
+  settings_op_addresses.clear();
+  handle_settings_operation_changed();
+}
+
+void main_controller::handle_settings_operation_changed()
+{
+  bool idle = connected() && !settings_operation_running();
+  window->set_open_save_settings_enabled(idle);
+  window->set_reload_settings_enabled(idle);
+  window->set_restore_defaults_enabled(idle);
+  window->set_settings_pages_enabled(idle);
+
+  if (settings_op == settings_operation::apply)
+  {
+    // One step for reading the EEPROM, one for each byte written, and one for
+    // reinitializing.  The total is not known until the EEPROM is read.
+    uint32_t total = 0, done = 0;
+    if (settings_op_eeprom_read)
+    {
+      total = settings_op_addresses.size() + 2;
+      done = settings_op_written_count + 1;
+    }
+    window->show_settings_progress("Applying settings...", done, total);
+  }
+  else if (settings_op == settings_operation::reload)
+  {
+    window->show_settings_progress("Reloading settings...", 0, 0);
+  }
+  else
+  {
+    window->hide_settings_progress();
+  }
 }
 
 void main_controller::stop_motor_nocatch()
@@ -1646,9 +1932,22 @@ void main_controller::set_target(uint16_t target)
 void main_controller::clear_current_chopping_count()
 {
   current_chopping_count = 0;
+  chopping_tracker.clear();
   handle_variables_changed();
 }
 
+void main_controller::save_current_chopping_log(std::string filename)
+{
+  try
+  {
+    write_string_to_file(filename, chopping_tracker.to_string());
+  }
+  catch (const std::exception & e)
+  {
+    show_exception(e);
+  }
+}
+
 void main_controller::force_duty_cycle_target_nocatch(int16_t duty_cycle)
 {
   device_handle.force_duty_cycle_target(duty_cycle);
@@ -1754,4 +2053,14 @@ void main_controller::reload_variables()
       current_chopping_count = INT_MAX;
     }
   }
+
+  // The timeline returns the same time when handle_variables_changed() maps
+  // this up time again for the graph.
+  if (cached_settings.is_present())
+  {
+    chopping_tracker.set_pid_period(cached_settings.get_pid_period());
+  }
+  int64_t time = timeline.map(variables.get_up_time());
+  chopping_tracker.add_sample(variables, time);
+  diagnosis_window.add_sample(variables, time);
 }
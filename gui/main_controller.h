@@ -1,6 +1,8 @@
 #pragma once
 
 #include "jrk.hpp"
+#include "derived_channel.h"
+#include "sample_timeline.h"
 
 class main_window;
 
@@ -64,15 +66,25 @@ private:
   void show_exception(std::exception const & e, std::string const & context = "");
 
 public:
-  // This is called when the user wants to apply the settings.
-  // Returns true on success.
+  // This is called when the user wants to apply the settings.  The settings
+  // are written in the background by update().  Returns true if applying the
+  // settings was started.
   bool apply_settings();
 
+  // This is called when the user cancels applying or reloading settings.
+  void cancel_settings_operation();
+
+  // This is called before disconnecting or exiting.  If settings are being
+  // applied, it asks the user whether to finish applying them, and finishes
+  // if they agree.  Returns false if the caller should not go on.
+  bool finish_applying_settings(const char * action);
+
   void stop_motor_nocatch();
   void stop_motor();
   void run_motor();
   void set_target(uint16_t);
   void clear_current_chopping_count();
+  void save_current_chopping_log(std::string filename);
 
   void force_duty_cycle_target_nocatch(int16_t);
   void clear_errors_nocatch();
@@ -169,6 +181,12 @@ public:
 
   uint32_t current_limit_code_to_ma(uint16_t code);
 
+  // Adds a channel whose value is computed from each sample of the variables.
+  // Throws an exception if the name or expression is invalid.
+  void add_derived_channel(std::string const & name,
+    std::string const & expression);
+  void remove_derived_channel(std::string const & name);
+
 private:
   // This is called whenever it is possible that we have connected to a
   // different device.
@@ -180,6 +198,17 @@ private:
   void recalculate_motor_asymmetric();
   void recalculate_fbt_range();
 
+  // Applying and reloading settings are done a few USB transfers at a time
+  // from update(), so the window stays responsive and the variables keep
+  // updating while they run.
+  enum class settings_operation { none, apply, reload };
+
+  void start_settings_operation(settings_operation,
+    jrk::settings const & new_settings);
+  void continue_settings_operation();
+  void end_settings_operation();
+  void handle_settings_operation_changed();
+
 public:
 
   bool check_settings_applied_before_wizard();
@@ -228,9 +257,42 @@ private:
   // different from what is cached and on the device.
   bool settings_modified = false;
 
+  // Maps the device's up time to the time base used for the graph.
+  sample_timeline timeline;
+
+  // Derived channels, in the order they were added, and their latest values.
+  std::vector<derived_channel> derived_channels;
+  std::vector<double> derived_values;
+  void update_derived_channels(int64_t time);
+
   // Running sum of variables.get_current_chopping_occurrence_count().
   uint32_t current_chopping_count = 0;
 
+  // Reconstructs current chopping episodes from every variables read, so
+  // they can be saved for diagnosing current limits that are too low.
+  jrk::chopping_tracker chopping_tracker = jrk::chopping_tracker::create();
+
+  // Counts errors and other problems over the last minute, so the motor
+  // status can mention problems that come and go between updates.
+  jrk::diagnosis_window diagnosis_window = jrk::diagnosis_window::create();
+
+  // The settings operation in progress, if any.
+  settings_operation settings_op = settings_operation::none;
+
+  // The settings being applied, or the object that reloaded settings get
+  // decoded into.
+  jrk::settings settings_op_settings;
+
+  // The settings image being applied and the image read from EEPROM.
+  jrk::settings_image settings_op_new_image;
+  jrk::settings_image settings_op_eeprom_image;
+  bool settings_op_eeprom_read = false;
+
+  // The addresses of the EEPROM bytes that need to be written to apply the
+  // settings, and how many of them have been written so far.
+  std::vector<uint8_t> settings_op_addresses;
+  size_t settings_op_written_count = 0;
+
   // True if the last attempt to update the variables failed (typically due
   // to a USB error).
   bool variables_update_failed = false;
@@ -246,6 +308,12 @@ public:
   // Returns true if we are currently connected to a device.
   bool connected() const { return device_handle.is_present(); }
 
+  // Returns true if settings are being applied or reloaded.
+  bool settings_operation_running() const
+  {
+    return settings_op != settings_operation::none;
+  }
+
 private:
 
   main_window * window;
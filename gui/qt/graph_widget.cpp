@@ -1,14 +1,24 @@
 #include "graph_widget.h"
+#include "derived_channel.h"
 #include "file_util.h"
 #include "message_box.h"
+#include "spectrum_widget.h"
 
 #include <QColorDialog>
+#include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
 #include <QFontDatabase>
 #include <QGuiApplication>
+#include <QLineEdit>
 #include <QMessageBox>
 #include <QWidgetAction>
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
 graph_widget::graph_widget()
 {
   int id = QFontDatabase::addApplicationFont(":dejavu_sans");
@@ -27,6 +37,9 @@ void graph_widget::set_preview_mode(bool preview_mode)
 {
   this->preview_mode = preview_mode;
 
+  spectrum->setVisible(!preview_mode && show_spectrum_action->isChecked());
+  update_replay_controls();
+
   if (preview_mode)
   {
     reset_graph_interaction_axes();
@@ -69,12 +82,44 @@ void graph_widget::set_paused(bool paused)
   {
     graph_paused = paused;
     pause_run_button->setText(graph_paused ? "R&un" : "&Pause");
+
+    if (replay && graph_paused)
+    {
+      replay_timer->stop();
+    }
+    else if (replay)
+    {
+      // Start over if playback already reached the end.
+      if (display_time >= replay->get_end_time())
+      {
+        display_time = std::min(
+          replay->get_start_time() + domain->value() * 1000,
+          replay->get_end_time());
+      }
+      replay_clock.start();
+      replay_timer->start();
+    }
+    else if (graph_paused)
+    {
+      // Old samples keep getting removed while we are paused, so keep a copy
+      // of the ones that can be displayed.
+      paused_samples.copy_range(samples,
+        display_time - max_domain_ms - 1000, display_time);
+    }
+    else
+    {
+      paused_samples.clear();
+    }
+
     custom_plot->replot();
   }
 }
 
 void graph_widget::clear_graphs()
 {
+  samples.clear();
+  paused_samples.clear();
+
   for (auto plot : all_plots)
   {
     plot->graph->data()->clear();
@@ -83,31 +128,69 @@ void graph_widget::clear_graphs()
   custom_plot->replot();
 }
 
-void graph_widget::plot_data(uint32_t time)
+void graph_widget::plot_data(int64_t time)
 {
+  if (recorder) { record_sample(time); }
+
   current_time = time;
+
+  // While a capture or overlay is shown, live data is dropped.
+  if (replay || !overlay_runs.isEmpty()) { return; }
+
   if (!graph_paused) { display_time = time; }
 
-  for (auto plot : all_plots)
+  sample_values.resize(all_plots.size());
+  for (int i = 0; i < all_plots.size(); i++)
   {
-    plot->graph->addData(time, plot->plot_value);
+    sample_values[i] = all_plots[i]->plot_value;
   }
+  samples.add_sample(time, sample_values.data());
 
   remove_old_data();
 
+  if (spectrum->isVisible())
+  {
+    int channel = spectrum->get_channel();
+    if (channel >= 0 && channel < all_plots.size())
+    {
+      spectrum->add_sample(all_plots[channel]->plot_value, time);
+    }
+  }
+
   if (graph_paused) { return; }
 
+  if (spectrum->isVisible()) { spectrum->update_display(); }
+
   update_x_axis();
+  update_graph_data();
 
+  bool arrows_changed = false;
   for (auto plot : all_plots)
   {
     if (plot->display->isChecked())
     {
-      update_plot_overflow_arrows(*plot);
+      arrows_changed |= update_plot_overflow_arrows(*plot);
     }
   }
 
-  custom_plot->replot();
+  replot_data(arrows_changed);
+}
+
+void graph_widget::replot_data(bool arrows_changed)
+{
+  // Usually only the data and maybe the overflow arrows changed, so just redraw
+  // their layers and reuse the cached drawing of everything else.  Anything
+  // that changes the rest of the graph does a full replot, but we check here
+  // in case the buffers were invalidated by something else, like a resize.
+  if (custom_plot->hasInvalidatedPaintBuffers())
+  {
+    custom_plot->replot();
+  }
+  else
+  {
+    data_layer->replot();
+    if (arrows_changed) { arrow_layer->replot(); }
+  }
 }
 
 void graph_widget::set_checkbox_style(plot * plot, const QString & color)
@@ -187,6 +270,20 @@ void graph_widget::show_plot_menu(plot * plot, bool with_title)
   menu->addAction(reset_color_action);
   menu->addAction(reset_range_action);
 
+  if (!plot->expression.isEmpty())
+  {
+    QAction * remove_action = new QAction(this);
+    remove_action->setText("Remove derived channel");
+    menu->addSeparator();
+    menu->addAction(remove_action);
+
+    QString name = plot->id_string;
+    connect(remove_action, &QAction::triggered, [=]
+    {
+      remove_derived_plot(name);
+    });
+  }
+
   connect(select_action, &QAction::triggered, [=]()
   {
     reset_graph_interaction_axes();
@@ -220,6 +317,175 @@ void graph_widget::show_plot_menu(plot * plot, bool with_title)
   menu->popup(QCursor::pos());
 }
 
+void graph_widget::show_add_derived_channel_dialog()
+{
+  QDialog dialog(custom_plot);
+  dialog.setWindowTitle("Add derived channel");
+
+  QLineEdit * name = new QLineEdit();
+  QLineEdit * expression = new QLineEdit();
+  expression->setMinimumWidth(expression->fontMetrics().width('m') * 30);
+
+  QString inputs;
+  for (size_t i = 0; derived_channel::input_name(i); i++)
+  {
+    if (i != 0) { inputs += ", "; }
+    inputs += derived_channel::input_name(i);
+  }
+
+  QLabel * help = new QLabel(
+    "Expressions can use numbers, + - * / and parentheses, these inputs:\n" +
+    inputs + "\n\nand these functions:\n"
+    "abs(x), sqrt(x), min(x, y), max(x, y),\n"
+    "deriv(x): rate of change per second,\n"
+    "lowpass(x, t): low-pass filter with a time constant of t ms.\n\n"
+    "Example: lowpass(deriv(scaled_feedback), 50)");
+  help->setWordWrap(true);
+
+  QDialogButtonBox * buttons = new QDialogButtonBox(
+    QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+  QFormLayout * layout = new QFormLayout();
+  layout->addRow("Name:", name);
+  layout->addRow("Expression:", expression);
+  layout->addRow(help);
+  layout->addRow(buttons);
+  dialog.setLayout(layout);
+
+  if (dialog.exec() != QDialog::Accepted) { return; }
+
+  emit derived_channel_requested(name->text().trimmed(),
+    expression->text().trimmed());
+}
+
+void graph_widget::add_derived_plot(const QString & name,
+  const QString & expression)
+{
+  static const char * const colors[][2] = {
+    { "#8b4513", "#d2a07a" },
+    { "#2e8b57", "#6fdc9d" },
+    { "#4682b4", "#8fc1ea" },
+    { "#c71585", "#f06bc0" },
+    { "#556b2f", "#a6c76a" },
+    { "#708090", "#b8c4d0" },
+  };
+  const size_t color_count = sizeof(colors) / sizeof(colors[0]);
+  const char * const * color = colors[derived_plots.size() % color_count];
+
+  plot * p = new plot();
+  p->expression = expression;
+  setup_plot(*p, name, name, color[0], color[1], 4095,
+    sample_buffer::TYPE_FLOAT, true);
+  derived_plots.append(p);
+
+  if (dark_theme) { change_plot_colors(p, p->dark_color); }
+  set_line_visible();
+  update_spectrum_channels();
+
+  if (replay)
+  {
+    update_replay_channels();
+    show_replay_data();
+  }
+
+  if (!overlay_runs.isEmpty())
+  {
+    remove_overlay_graphs();
+    create_overlay_graphs();
+    show_overlay_data();
+  }
+}
+
+void graph_widget::remove_derived_plot(const QString & name)
+{
+  plot * p = NULL;
+  for (auto derived : derived_plots)
+  {
+    if (derived->id_string == name) { p = derived; }
+  }
+  if (p == NULL) { return; }
+
+  // Make sure the axis we are about to remove is not used for dragging or by
+  // an overlay graph.
+  reset_graph_interaction_axes();
+  remove_overlay_graphs();
+
+  custom_plot->removeGraph(p->graph);
+  custom_plot->removeItem(p->axis_label);
+  custom_plot->removeItem(p->axis_position_label);
+  custom_plot->removeItem(p->axis_scale_label);
+  for (auto arrow : p->overflow_arrows)
+  {
+    custom_plot->removeItem(arrow);
+  }
+  custom_plot->axisRect()->removeAxis(p->axis);
+
+  int removed_row, column, row_span, column_span;
+  controls_layout->getItemPosition(controls_layout->indexOf(p->display),
+    &removed_row, &column, &row_span, &column_span);
+
+  delete p->display;
+  delete p->position;
+  delete p->scale;
+
+  // QGridLayout cannot remove a row, so move the rows below the removed one
+  // up to keep it from leaving a gap.
+  for (int i = controls_layout->count() - 1; i >= 0; i--)
+  {
+    int item_row;
+    controls_layout->getItemPosition(i, &item_row, &column,
+      &row_span, &column_span);
+    if (item_row <= removed_row) { continue; }
+    QLayoutItem * item = controls_layout->takeAt(i);
+    controls_layout->addItem(item, item_row - 1, column,
+      row_span, column_span, item->alignment());
+  }
+  row--;
+
+  samples.remove_channel(p->index);
+  paused_samples.remove_channel(p->index);
+
+  derived_plots.removeOne(p);
+  all_plots.removeOne(p);
+  delete p;
+
+  // The index determines where the overflow arrows go.
+  for (int i = 0; i < all_plots.size(); i++)
+  {
+    all_plots[i]->index = i;
+    update_plot_overflow_arrows(*all_plots[i]);
+  }
+
+  create_overlay_graphs();
+  if (!overlay_runs.isEmpty()) { show_overlay_data(); }
+
+  custom_plot->replot();
+  update_spectrum_channels();
+  update_replay_channels();
+
+  emit derived_channel_removed(name);
+}
+
+void graph_widget::update_spectrum_channels()
+{
+  QStringList names;
+  for (auto plot : all_plots)
+  {
+    names.append(plot->display->text());
+  }
+  spectrum->set_channels(names);
+}
+
+void graph_widget::set_derived_values(const std::vector<double> & values)
+{
+  for (int i = 0; i < derived_plots.size() && (size_t)i < values.size(); i++)
+  {
+    derived_plots[i]->plot_value = values[i];
+  }
+}
+
 void graph_widget::pick_plot_color(plot * plot)
 {
   QColorDialog * color_dialog = new QColorDialog(custom_plot);
@@ -277,6 +543,71 @@ void graph_widget::setup_ui()
   connect(default_theme_action, &QAction::triggered, this,
     &graph_widget::switch_to_default);
 
+  show_spectrum_action = new QAction(this);
+  show_spectrum_action->setText(tr("Show &spectrum"));
+  show_spectrum_action->setCheckable(true);
+
+  // The graph window moves the spectrum into its own layout, but until then
+  // this widget owns it, so it is freed even if the window is never opened.
+  spectrum = new spectrum_widget(this);
+  spectrum->setVisible(false);
+  connect(show_spectrum_action, &QAction::toggled, [=](bool checked)
+  {
+    spectrum->clear();
+    spectrum->setVisible(checked && !preview_mode);
+  });
+
+  record_action = new QAction(this);
+  update_record_action();
+  connect(record_action, &QAction::triggered, this,
+    &graph_widget::start_or_stop_recording);
+
+  open_capture_action = new QAction(this);
+  open_capture_action->setText(tr("&Open capture..."));
+  connect(open_capture_action, &QAction::triggered, this,
+    &graph_widget::open_capture);
+
+  close_capture_action = new QAction(this);
+  close_capture_action->setText(tr("Return to &live data"));
+  close_capture_action->setEnabled(false);
+  connect(close_capture_action, &QAction::triggered, this,
+    &graph_widget::close_capture);
+
+  replay_timer = new QTimer(this);
+  replay_timer->setInterval(50);
+  connect(replay_timer, &QTimer::timeout, this, &graph_widget::replay_tick);
+
+  replay_label = new QLabel();
+  replay_scroll_bar = new QScrollBar(Qt::Horizontal);
+  replay_scroll_bar->setSingleStep(1000);
+  connect(replay_scroll_bar, &QScrollBar::valueChanged, this,
+    &graph_widget::replay_scrolled);
+
+  QHBoxLayout * replay_layout = new QHBoxLayout();
+  replay_layout->setContentsMargins(0, 0, 0, 0);
+  replay_layout->addWidget(replay_label);
+  replay_layout->addWidget(replay_scroll_bar, 1);
+  replay_controls = new QWidget(this);
+  replay_controls->setLayout(replay_layout);
+  replay_controls->setVisible(false);
+
+  add_overlay_captures_action = new QAction(this);
+  add_overlay_captures_action->setText(tr("Add captures to o&verlay..."));
+  connect(add_overlay_captures_action, &QAction::triggered, this,
+    &graph_widget::add_overlay_captures);
+
+  add_overlay_step_action = new QAction(this);
+  add_overlay_step_action->setText(tr("Add displayed s&tep to overlay"));
+  add_overlay_step_action->setEnabled(false);
+  connect(add_overlay_step_action, &QAction::triggered, this,
+    &graph_widget::add_overlay_step);
+
+  clear_overlay_action = new QAction(this);
+  clear_overlay_action->setText(tr("Clear overl&ay"));
+  clear_overlay_action->setEnabled(false);
+  connect(clear_overlay_action, &QAction::triggered, this,
+    &graph_widget::clear_overlay);
+
   pause_run_button = new QPushButton();
   pause_run_button->setObjectName("pause_run_button");
   pause_run_button->setText(tr("&Pause"));
@@ -284,11 +615,23 @@ void graph_widget::setup_ui()
   connect(pause_run_button, &QPushButton::clicked,
     this, &graph_widget::pause_or_run);
 
-  custom_plot = new QCustomPlot();
+  custom_plot = new graph_custom_plot();
   custom_plot->axisRect()->setAutoMargins(QCP::msNone);
   custom_plot->setAntialiasedElements(QCP::aePlottables);
   custom_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
 
+  // The plotted data and the overflow arrows change with every new sample, so
+  // they get buffered layers that can be redrawn on their own.  The axis
+  // labels go in a logical layer between them, which shares a cached buffer
+  // with the layers below it.
+  custom_plot->addLayer("data", custom_plot->layer("main"));
+  custom_plot->addLayer("labels", custom_plot->layer("data"));
+  custom_plot->addLayer("arrows", custom_plot->layer("labels"));
+  data_layer = custom_plot->layer("data");
+  data_layer->setMode(QCPLayer::lmBuffered);
+  arrow_layer = custom_plot->layer("arrows");
+  arrow_layer->setMode(QCPLayer::lmBuffered);
+
   connect(custom_plot, SIGNAL(mousePress(QMouseEvent*)),
     this, SLOT(mouse_press(QMouseEvent*)));
 
@@ -314,39 +657,41 @@ void graph_widget::setup_ui()
   bottom_control_layout->addWidget(pause_run_button, 0, Qt::AlignRight);
 
   setup_plot(input, "input", "Input",
-    "#00ffff", "#84ffff", 4095);
+    "#00ffff", "#84ffff", 4095, sample_buffer::TYPE_UINT16);
 
   setup_plot(target, "target", "Target",
-    "#0000ff", "#8282ff", 4095, true);
+    "#0000ff", "#8282ff", 4095, sample_buffer::TYPE_UINT16, true);
 
   // The original Jrk software used #ffc0cb for feedback, but that is kind of
   // hard to see when we use it as a text color.
   setup_plot(feedback, "feedback", "Feedback",
-    "#ff00aa", "#ff84d6", 4095);
+    "#ff00aa", "#ff84d6", 4095, sample_buffer::TYPE_UINT16);
 
   setup_plot(scaled_feedback, "scaled_feedback", "Scaled feedback",
-    "#ff0000", "#fc4646", 4095, true);
+    "#ff0000", "#fc4646", 4095, sample_buffer::TYPE_UINT16, true);
 
   setup_plot(error, "error", "Error",
-    "#9400d3", "#b970d8", 4095);
+    "#9400d3", "#b970d8", 4095, sample_buffer::TYPE_INT16);
 
   setup_plot(integral, "integral", "Integral",
-    "#ff8c00", "#ff8c00", 0x7fff);
+    "#ff8c00", "#ff8c00", 0x7fff, sample_buffer::TYPE_INT16);
 
   setup_plot(duty_cycle_target, "duty_cycle_target", "Duty cycle target",
-    "#32cd32", "#85ff85", 600);
+    "#32cd32", "#85ff85", 600, sample_buffer::TYPE_INT16);
 
   setup_plot(duty_cycle, "duty_cycle", "Duty cycle",
-    "#006400", "#4ea04e", 600);
+    "#006400", "#4ea04e", 600, sample_buffer::TYPE_INT16);
 
+  // The raw current has a fractional part.
   setup_plot(raw_current, "raw_current",
-    "Raw current (mV)", "#660066", "#bc00bc", 4095);
+    "Raw current (mV)", "#660066", "#bc00bc", 4095,
+    sample_buffer::TYPE_FLOAT);
 
   setup_plot(current, "current", "Current (mA)",
-    "#b8860b", "#e8ac7f", 100000);
+    "#b8860b", "#e8ac7f", 100000, sample_buffer::TYPE_INT32);
 
   setup_plot(current_chopping, "current_chopping",
-    "Current chopping", "#d500ff", "#ea82ff", 1);
+    "Current chopping", "#d500ff", "#ea82ff", 1, sample_buffer::TYPE_UINT8);
 
   QFrame * division_frame = new QFrame();
   division_frame->setFrameShadow(QFrame::Plain);
@@ -393,6 +738,7 @@ void graph_widget::setup_ui()
   // custom_plot->xAxis2->setVisible(true);
 
   set_line_visible();
+  update_spectrum_channels();
 
   custom_plot->axisRect()->setRangeDragAxes(0, 0);
   custom_plot->axisRect()->setRangeZoomAxes(0, 0);
@@ -421,6 +767,9 @@ QMenu * graph_widget::setup_options_menu(const QString & title, bool shortcuts)
   QAction * reset_all_ranges_action = new QAction(this);
   reset_all_ranges_action->setText("&Reset all positions and scales");
 
+  QAction * add_derived_channel_action = new QAction(this);
+  add_derived_channel_action->setText("Add &derived channel...");
+
   options_menu->addAction(save_settings_action);
   options_menu->addAction(load_settings_action);
   options_menu->addSeparator();
@@ -428,6 +777,17 @@ QMenu * graph_widget::setup_options_menu(const QString & title, bool shortcuts)
   options_menu->addAction(dark_theme_action);
   options_menu->addAction(reset_all_colors_action);
   options_menu->addAction(reset_all_ranges_action);
+  options_menu->addSeparator();
+  options_menu->addAction(add_derived_channel_action);
+  options_menu->addAction(show_spectrum_action);
+  options_menu->addSeparator();
+  options_menu->addAction(record_action);
+  options_menu->addAction(open_capture_action);
+  options_menu->addAction(close_capture_action);
+  options_menu->addSeparator();
+  options_menu->addAction(add_overlay_captures_action);
+  options_menu->addAction(add_overlay_step_action);
+  options_menu->addAction(clear_overlay_action);
 
   connect(save_settings_action, &QAction::triggered, this,
     &graph_widget::save_settings);
@@ -441,6 +801,9 @@ QMenu * graph_widget::setup_options_menu(const QString & title, bool shortcuts)
   connect(reset_all_ranges_action, &QAction::triggered, this,
     &graph_widget::reset_all_ranges);
 
+  connect(add_derived_channel_action, &QAction::triggered, this,
+    &graph_widget::show_add_derived_channel_dialog);
+
   return options_menu;
 }
 
@@ -455,9 +818,12 @@ QMenuBar * graph_widget::setup_menu_bar()
 void graph_widget::setup_plot(plot & plot,
   const QString & id_string, const QString & display_text,
   const QString & default_color, const QString & dark_color,
-  int typical_max_value, bool default_visible)
+  int typical_max_value, sample_buffer::value_type sample_type,
+  bool default_visible)
 {
   plot.index = all_plots.size();
+  samples.add_channel(sample_type);
+  paused_samples.add_channel(sample_type);
   plot.id_string = id_string;
   plot.default_scale = typical_max_value / 5.0;
 
@@ -493,6 +859,7 @@ void graph_widget::setup_plot(plot & plot,
   y_label_font.setPixelSize(35);
 
   plot.axis_label = new QCPItemText(custom_plot);
+  plot.axis_label->setLayer("labels");
   plot.axis_label->setClipToAxisRect(false);
   plot.axis_label->setPositionAlignment(Qt::AlignRight | Qt::AlignVCenter);
   plot.axis_label->setFont(y_label_font);
@@ -509,6 +876,7 @@ void graph_widget::setup_plot(plot & plot,
   axis_label_text.setPixelSize(11);
 
   plot.axis_position_label = new QCPItemText(custom_plot);
+  plot.axis_position_label->setLayer("labels");
   plot.axis_position_label->setClipToAxisRect(false);
   plot.axis_position_label->setFont(axis_label_text);
   plot.axis_position_label->setColor(default_color);
@@ -516,6 +884,7 @@ void graph_widget::setup_plot(plot & plot,
   plot.axis_position_label->setVisible(false);
 
   plot.axis_scale_label = new QCPItemText(custom_plot);
+  plot.axis_scale_label->setLayer("labels");
   plot.axis_scale_label->setClipToAxisRect(false);
   plot.axis_scale_label->setFont(axis_label_text);
   plot.axis_scale_label->setColor(default_color);
@@ -536,6 +905,7 @@ void graph_widget::setup_plot(plot & plot,
   controls_layout->addWidget(plot.scale, row, 2);
 
   plot.graph = custom_plot->addGraph(custom_plot->xAxis2, plot.axis);
+  plot.graph->setLayer(data_layer);
   plot.graph->setPen(QPen(QColor(plot.default_color), 1));
 
   // Briton says StepCenter mode helped with performance issues when dragging
@@ -599,21 +969,40 @@ void graph_widget::update_x_axis()
   custom_plot->xAxis2->setRange(display_time, domain_ms, Qt::AlignRight);
 }
 
-// Removes old data that we will not need to display later so that the graph
-// does not consume too much memory.
+// Removes old samples that we will not need to display later so that the
+// graph does not consume too much memory.  While the graph is paused, the
+// displayed samples are in paused_samples.
 //
-// Note: We are not doing anything to handle overflow of the uint32_t
-// time variable, so all data will disappear from the graph every
-// 49 days if you can keep your Jrk running that long.
-// (Add `time -= 30000;` in plot_data() to simulate this.)
+// The times come from a 64-bit sample_timeline, which does not wrap around
+// or go backwards when the device's up time does.
 void graph_widget::remove_old_data()
 {
-  double oldest_displayable_time = (double)display_time - max_domain_ms - 1000;
-  double oldest_later_displayable_time = (double)current_time - max_domain_ms - 1000;
+  samples.remove_before(current_time - max_domain_ms - 1000);
+}
+
+// Fills the graphs of the plots that are shown with the points needed to draw
+// the displayed time span.  The samples are only converted to doubles here,
+// and there are at most a few points per pixel.
+void graph_widget::update_graph_data()
+{
+  if (replay || !overlay_runs.isEmpty()) { return; }
+
+  const sample_buffer & source = graph_paused ? paused_samples : samples;
+  int64_t domain_ms = domain->value() * 1000;
+  size_t max_points = 2 * std::max(100, custom_plot->axisRect()->width());
+
   for (auto plot : all_plots)
   {
-    plot->graph->data()->removeBefore(oldest_displayable_time);
-    plot->graph->data()->remove(display_time, oldest_later_displayable_time);
+    if (!plot->display->isChecked())
+    {
+      plot->graph->data()->clear();
+      continue;
+    }
+
+    source.get_plot_points(plot->index, display_time - domain_ms,
+      display_time, max_points, plot_times, plot_values);
+    plot->graph->setData(QVector<double>::fromStdVector(plot_times),
+      QVector<double>::fromStdVector(plot_values), true);
   }
 }
 
@@ -716,9 +1105,12 @@ void graph_widget::update_plot_text_and_arrows(const plot & plot)
 }
 
 // Note: There is just barely enough space for the overflow arrows with our
-// current number of plots (11).  If we add more plots, we might need to make
-// the arrows smaller.
-void graph_widget::update_plot_overflow_arrows(const plot & plot)
+// 11 built-in plots.  Each derived plot moves the arrows closer together, so
+// with more than a few derived plots, the arrows of neighboring plots overlap.
+//
+// Returns true if any of the arrows changed, meaning that the arrow layer
+// needs to be redrawn.
+bool graph_widget::update_plot_overflow_arrows(const plot & plot)
 {
   bool plot_visible = plot.display->isChecked();
 
@@ -745,37 +1137,37 @@ void graph_widget::update_plot_overflow_arrows(const plot & plot)
     arrow_offset = 0.05 + 0.9 * plot.index / (all_plots.size() - 1);
   }
 
-  plot.overflow_arrows[0]->setVisible(out_top && arrow_count >= 1);
-  plot.overflow_arrows[1]->setVisible(out_bot && arrow_count >= 1);
-  plot.overflow_arrows[2]->setVisible(out_top && arrow_count >= 2);
-  plot.overflow_arrows[3]->setVisible(out_bot && arrow_count >= 2);
-  plot.overflow_arrows[4]->setVisible(out_top && arrow_count >= 3);
-  plot.overflow_arrows[5]->setVisible(out_bot && arrow_count >= 3);
-
   double top = plot.axis->range().upper;
   double bot = plot.axis->range().lower;
 
-  switch (arrow_count)
-  {
-  case 1:
-    plot.overflow_arrows[0]->position->setCoords(arrow_offset, top);
-    plot.overflow_arrows[1]->position->setCoords(arrow_offset, bot);
-    break;
-  case 2:
-    plot.overflow_arrows[0]->position->setCoords(arrow_offset / 2, top);
-    plot.overflow_arrows[1]->position->setCoords(arrow_offset / 2, bot);
-    plot.overflow_arrows[2]->position->setCoords((arrow_offset + 1) / 2, top);
-    plot.overflow_arrows[3]->position->setCoords((arrow_offset + 1) / 2, bot);
-    break;
-  case 3:
-    plot.overflow_arrows[0]->position->setCoords(arrow_offset / 3, top);
-    plot.overflow_arrows[1]->position->setCoords(arrow_offset / 3, bot);
-    plot.overflow_arrows[2]->position->setCoords((arrow_offset + 1) / 3, top);
-    plot.overflow_arrows[3]->position->setCoords((arrow_offset + 1) / 3, bot);
-    plot.overflow_arrows[4]->position->setCoords((arrow_offset + 2) / 3, top);
-    plot.overflow_arrows[5]->position->setCoords((arrow_offset + 2) / 3, bot);
-    break;
+  // The arrows come in pairs: even ones point up at the top of the graph and
+  // odd ones point down at the bottom.  Each pair that is used gets an equal
+  // share of the width of the graph.
+  bool changed = false;
+  for (int i = 0; i < plot.overflow_arrows.size(); i++)
+  {
+    QCPItemText * arrow = plot.overflow_arrows[i];
+    bool at_top = (i % 2) == 0;
+    int pair = i / 2;
+
+    bool visible = (at_top ? out_top : out_bot) && pair < arrow_count;
+    if (arrow->visible() != visible)
+    {
+      arrow->setVisible(visible);
+      changed = true;
+    }
+
+    if (pair < arrow_count)
+    {
+      QPointF coords((arrow_offset + pair) / arrow_count, at_top ? top : bot);
+      if (arrow->position->coords() != coords)
+      {
+        arrow->position->setCoords(coords);
+        changed = true;
+      }
+    }
   }
+  return changed;
 }
 
 void graph_widget::update_position_step_value(const plot & plot)
@@ -816,6 +1208,7 @@ void graph_widget::set_range(const plot & plot)
 QCPItemText * graph_widget::axis_arrow(const plot & plot, double degrees)
 {
   QCPItemText * label_instance = new QCPItemText(custom_plot);
+  label_instance->setLayer(arrow_layer);
   label_instance->setClipToAxisRect(false);
   label_instance->setPositionAlignment(Qt::AlignCenter);
   label_instance->setFont(x_label_font);
@@ -850,6 +1243,13 @@ void graph_widget::save_settings()
 
   settings_string.append("domain," + QString::number(domain->value()) + "\n");
 
+  // The derived channels have to be defined before their plot settings.
+  for (auto plot : derived_plots)
+  {
+    settings_string.append("derived," + plot->id_string + "," +
+      plot->expression + "\n");
+  }
+
   for (auto plot : all_plots)
   {
     QString plot_settings = QString("%1,%2,%3,%4,%5,%6\n")
@@ -901,6 +1301,12 @@ void graph_widget::load_settings()
 
   bool dark = false;
 
+  // Replace any derived channels with the ones from the file.
+  while (!derived_plots.isEmpty())
+  {
+    remove_derived_plot(derived_plots.last()->id_string);
+  }
+
   for (auto settings : all_plots_settings)
   {
     QStringList parts = settings.split(",", QString::SkipEmptyParts);
@@ -924,6 +1330,14 @@ void graph_widget::load_settings()
       continue;
     }
 
+    if (parts.count() >= 3 && parts[0] == "derived")
+    {
+      // The expression can contain commas.
+      emit derived_channel_requested(parts[1],
+        settings.section(',', 2).trimmed());
+      continue;
+    }
+
     for (auto plot : all_plots)
     {
       if (parts.count() < 6 || parts[0] != plot->id_string) { continue; }
@@ -1018,7 +1432,20 @@ void graph_widget::switch_to_default()
 
 void graph_widget::change_ranges(int domain)
 {
+  if (!overlay_runs.isEmpty())
+  {
+    show_overlay_data();
+    return;
+  }
+
+  if (replay)
+  {
+    show_replay_data();
+    return;
+  }
+
   update_x_axis();
+  update_graph_data();
   custom_plot->replot();
 }
 
@@ -1035,9 +1462,18 @@ void graph_widget::set_line_visible()
   {
     plot->graph->setVisible(plot->display->isChecked());
     plot->axis_label->setVisible(plot->display->isChecked());
+  }
+
+  // The graphs of hidden plots are empty, so fill in the graphs of plots
+  // that were just shown before updating their arrows.
+  update_graph_data();
+  for (auto plot : all_plots)
+  {
     update_plot_text_and_arrows(*plot);
   }
 
+  if (!overlay_runs.isEmpty()) { show_overlay_data(); }
+
   custom_plot->replot();
 }
 
@@ -1166,6 +1602,473 @@ void graph_widget::mouse_press(QMouseEvent * event)
   custom_plot->replot();
 }
 
+void graph_widget::update_record_action()
+{
+  record_action->setText(recorder ? tr("Stop &recording") :
+    tr("&Record capture..."));
+}
+
+void graph_widget::start_or_stop_recording()
+{
+  if (recorder)
+  {
+    recorder.reset();
+    update_record_action();
+    return;
+  }
+
+  QString filename = QFileDialog::getSaveFileName(custom_plot,
+    "Record Capture", "jrk_capture.jrkcap", "Jrk captures (*.jrkcap)");
+
+  if (filename.isEmpty()) { return; }
+
+  // The capture has the channels that exist now.  If a derived channel is
+  // removed while recording, its values are recorded as NaN.
+  std::vector<capture_channel> channels;
+  recorded_ids.clear();
+  for (auto plot : all_plots)
+  {
+    capture_channel channel;
+    channel.name = plot->id_string.toStdString();
+    channel.expression = plot->expression.toStdString();
+    channels.push_back(channel);
+    recorded_ids.append(plot->id_string);
+  }
+
+  try
+  {
+    recorder.reset(new capture_writer(filename.toStdString(), channels));
+  }
+  catch (const std::exception & e)
+  {
+    show_exception(e, "", custom_plot);
+    return;
+  }
+
+  recorded_values.resize(channels.size());
+  update_record_action();
+}
+
+void graph_widget::record_sample(int64_t time)
+{
+  for (int i = 0; i < recorded_ids.size(); i++)
+  {
+    recorded_values[i] = NAN;
+    for (auto plot : all_plots)
+    {
+      if (plot->id_string == recorded_ids[i])
+      {
+        recorded_values[i] = plot->plot_value;
+        break;
+      }
+    }
+  }
+
+  try
+  {
+    recorder->write_sample(time, recorded_values.data());
+  }
+  catch (const std::exception & e)
+  {
+    recorder.reset();
+    update_record_action();
+    show_exception(e, "Recording stopped.", custom_plot);
+  }
+}
+
+void graph_widget::open_capture()
+{
+  QString filename = QFileDialog::getOpenFileName(custom_plot,
+    "Open Capture", "", "Jrk captures (*.jrkcap)");
+
+  if (filename.isEmpty()) { return; }
+
+  std::unique_ptr<capture_reader> reader;
+  try
+  {
+    reader.reset(new capture_reader(filename.toStdString()));
+  }
+  catch (const std::exception & e)
+  {
+    show_exception(e, "", custom_plot);
+    return;
+  }
+
+  if (reader->get_sample_count() == 0)
+  {
+    show_error_message("The capture has no samples.", custom_plot);
+    return;
+  }
+
+  replay_timer->stop();
+  replay = std::move(reader);
+
+  // Define any derived channels from the capture that we do not have, so they
+  // get plots.  Their recorded values are shown, not recomputed.
+  for (const capture_channel & channel : replay->get_channels())
+  {
+    if (channel.expression.empty()) { continue; }
+    QString name = QString::fromStdString(channel.name);
+    bool found = std::any_of(all_plots.begin(), all_plots.end(),
+      [&](const plot * plot) { return plot->id_string == name; });
+    if (!found)
+    {
+      emit derived_channel_requested(name,
+        QString::fromStdString(channel.expression));
+    }
+  }
+
+  update_replay_channels();
+
+  // Allow zooming out to see the whole capture.  The domain is converted to
+  // milliseconds in an int, which limits it to about 24 days.
+  int64_t duration_s =
+    (replay->get_end_time() - replay->get_start_time()) / 1000 + 1;
+  domain->setRange(1, (int)std::min<int64_t>(INT_MAX / 1000,
+    std::max<int64_t>(max_domain_ms / 1000, duration_s)));
+
+  display_time = std::min(replay->get_start_time() + domain->value() * 1000,
+    replay->get_end_time());
+  set_paused(true);
+  close_capture_action->setEnabled(true);
+  add_overlay_step_action->setEnabled(true);
+  show_replay_data();
+}
+
+void graph_widget::close_capture()
+{
+  if (!replay) { return; }
+
+  replay_timer->stop();
+  replay.reset();
+  replay_channels.clear();
+  close_capture_action->setEnabled(false);
+  add_overlay_step_action->setEnabled(false);
+
+  domain->setRange(1, max_domain_ms / 1000);
+
+  // Go back to the live data.  The samples that arrived during the replay
+  // were dropped.
+  display_time = current_time;
+  set_paused(false);
+  update_replay_controls();
+
+  if (!overlay_runs.isEmpty())
+  {
+    show_overlay_data();
+    return;
+  }
+
+  update_x_axis();
+  update_graph_data();
+  custom_plot->replot();
+}
+
+void graph_widget::update_replay_channels()
+{
+  replay_channels.assign(all_plots.size(), -1);
+  if (!replay) { return; }
+
+  const std::vector<capture_channel> & channels = replay->get_channels();
+  for (int i = 0; i < all_plots.size(); i++)
+  {
+    std::string id = all_plots[i]->id_string.toStdString();
+    for (size_t j = 0; j < channels.size(); j++)
+    {
+      if (channels[j].name == id)
+      {
+        replay_channels[i] = j;
+        break;
+      }
+    }
+  }
+}
+
+static QString format_capture_time(int64_t ms)
+{
+  int64_t s = ms / 1000;
+  return QString("%1:%2:%3")
+    .arg(s / 3600)
+    .arg(s / 60 % 60, 2, 10, QChar('0'))
+    .arg(s % 60, 2, 10, QChar('0'));
+}
+
+void graph_widget::update_replay_controls()
+{
+  replay_controls->setVisible(replay && overlay_runs.isEmpty() &&
+    !preview_mode);
+  if (!replay) { return; }
+
+  int64_t start = replay->get_start_time();
+  int64_t duration = replay->get_end_time() - start;
+
+  {
+    QSignalBlocker blocker(replay_scroll_bar);
+    replay_scroll_bar->setRange(0, std::min<int64_t>(duration, INT_MAX));
+    replay_scroll_bar->setPageStep(domain->value() * 1000);
+    replay_scroll_bar->setValue(display_time - start);
+  }
+
+  replay_label->setText(format_capture_time(display_time - start) + " / " +
+    format_capture_time(duration));
+}
+
+// Fills the plots with the part of the capture that is displayed.  The
+// capture_reader returns at most a few points per pixel, so this takes about
+// the same time no matter how long the displayed time span is.
+void graph_widget::show_replay_data()
+{
+  if (!overlay_runs.isEmpty()) { return; }
+
+  int64_t domain_ms = domain->value() * 1000;
+  size_t max_points = 2 * std::max(100, custom_plot->axisRect()->width());
+
+  std::vector<double> times, values;
+  for (int i = 0; i < all_plots.size(); i++)
+  {
+    QCPGraph * graph = all_plots[i]->graph;
+    int channel = replay_channels[i];
+    if (channel < 0)
+    {
+      graph->data()->clear();
+      continue;
+    }
+
+    replay->get_plot_points(channel, display_time - domain_ms, display_time,
+      max_points, times, values);
+    graph->setData(QVector<double>::fromStdVector(times),
+      QVector<double>::fromStdVector(values), true);
+  }
+
+  update_x_axis();
+  update_replay_controls();
+
+  bool arrows_changed = false;
+  for (auto plot : all_plots)
+  {
+    if (plot->display->isChecked())
+    {
+      arrows_changed |= update_plot_overflow_arrows(*plot);
+    }
+  }
+
+  replot_data(arrows_changed);
+}
+
+void graph_widget::replay_tick()
+{
+  display_time += replay_clock.restart();
+  if (display_time >= replay->get_end_time())
+  {
+    display_time = replay->get_end_time();
+    set_paused(true);
+  }
+  show_replay_data();
+}
+
+void graph_widget::replay_scrolled(int value)
+{
+  display_time = replay->get_start_time() + value;
+  show_replay_data();
+}
+
+// Colors for overlay runs, chosen to be easy to tell apart.
+static const char * const overlay_colors[] = {
+  "#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd",
+  "#8c564b", "#e377c2", "#7f7f7f", "#bcbd22", "#17becf",
+};
+
+void graph_widget::add_overlay_captures()
+{
+  QStringList filenames = QFileDialog::getOpenFileNames(custom_plot,
+    "Add Captures to Overlay", "", "Jrk captures (*.jrkcap)");
+
+  for (const QString & filename : filenames)
+  {
+    std::shared_ptr<const capture_reader> capture;
+    try
+    {
+      capture = std::make_shared<capture_reader>(filename.toStdString());
+    }
+    catch (const std::exception & e)
+    {
+      show_exception(e, "", custom_plot);
+      continue;
+    }
+
+    if (capture->get_sample_count() == 0) { continue; }
+
+    add_overlay_run(capture, capture->get_start_time(),
+      QFileInfo(filename).fileName());
+  }
+}
+
+// Adds the first step in the displayed part of the capture being replayed.
+void graph_widget::add_overlay_step()
+{
+  if (!replay) { return; }
+
+  int64_t domain_ms = domain->value() * 1000;
+  add_overlay_run(replay, display_time - domain_ms,
+    QFileInfo(QString::fromStdString(replay->get_filename())).fileName());
+}
+
+// Adds a run to the overlay.  The run is aligned at the first change of the
+// target at or after from_time, since that is where a step response starts.
+// If the target does not change, the run is aligned at from_time.
+void graph_widget::add_overlay_run(
+  const std::shared_ptr<const capture_reader> & capture,
+  int64_t from_time, const QString & name)
+{
+  int64_t trigger_time = std::max(from_time, capture->get_start_time());
+  const std::vector<capture_channel> & channels = capture->get_channels();
+  for (size_t i = 0; i < channels.size(); i++)
+  {
+    if (channels[i].name != target.id_string.toStdString()) { continue; }
+    size_t change = capture->find_change(i, capture->find_sample(from_time));
+    if (change < capture->get_sample_count())
+    {
+      trigger_time = capture->get_time(change);
+    }
+  }
+
+  overlay_run run;
+  run.capture = capture;
+  run.trigger_time = trigger_time;
+  run.name = name + " @ " +
+    format_capture_time(trigger_time - capture->get_start_time());
+  run.color = QColor(overlay_colors[overlay_runs.size() %
+    (sizeof(overlay_colors) / sizeof(overlay_colors[0]))]);
+
+  // Stop replaying and drop the data in the normal plots while the overlay
+  // is shown.
+  if (replay) { set_paused(true); }
+  for (auto plot : all_plots)
+  {
+    plot->graph->data()->clear();
+    update_plot_overflow_arrows(*plot);
+  }
+
+  remove_overlay_graphs();
+  overlay_runs.append(run);
+  create_overlay_graphs();
+
+  clear_overlay_action->setEnabled(true);
+  update_replay_controls();
+  show_overlay_data();
+}
+
+void graph_widget::clear_overlay()
+{
+  remove_overlay_graphs();
+  overlay_runs.clear();
+  create_overlay_graphs();
+  clear_overlay_action->setEnabled(false);
+
+  if (replay)
+  {
+    update_replay_controls();
+    show_replay_data();
+    return;
+  }
+
+  display_time = current_time;
+  update_x_axis();
+  update_graph_data();
+  custom_plot->replot();
+}
+
+void graph_widget::remove_overlay_graphs()
+{
+  for (overlay_run & run : overlay_runs)
+  {
+    for (QCPGraph * graph : run.graphs)
+    {
+      if (graph) { custom_plot->removeGraph(graph); }
+    }
+    run.graphs.clear();
+  }
+}
+
+// Creates a graph for each run and each plot whose channel is in the run's
+// capture, on the plot's axis so it uses the plot's position and scale.  The
+// legend shows one entry per run.
+void graph_widget::create_overlay_graphs()
+{
+  custom_plot->legend->clearItems();
+
+  for (overlay_run & run : overlay_runs)
+  {
+    const std::vector<capture_channel> & channels = run.capture->get_channels();
+    run.channels.assign(all_plots.size(), -1);
+
+    for (int i = 0; i < all_plots.size(); i++)
+    {
+      std::string id = all_plots[i]->id_string.toStdString();
+      for (size_t j = 0; j < channels.size(); j++)
+      {
+        if (channels[j].name == id) { run.channels[i] = j; }
+      }
+
+      QCPGraph * graph = NULL;
+      if (run.channels[i] >= 0)
+      {
+        graph = custom_plot->addGraph(custom_plot->xAxis2, all_plots[i]->axis);
+        graph->setLayer(data_layer);
+        graph->setPen(QPen(run.color, 1));
+        graph->setLineStyle(QCPGraph::lsStepCenter);
+        graph->removeFromLegend();
+      }
+      run.graphs.append(graph);
+    }
+
+    for (QCPGraph * graph : run.graphs)
+    {
+      if (graph == NULL) { continue; }
+      graph->setName(run.name);
+      graph->addToLegend();
+      break;
+    }
+  }
+
+  custom_plot->legend->setVisible(!overlay_runs.isEmpty());
+}
+
+// Draws the runs for the plots that are shown, from a little before the
+// trigger to the end of the time span.
+void graph_widget::show_overlay_data()
+{
+  int64_t domain_ms = domain->value() * 1000;
+  int64_t start = -domain_ms / 10;
+  int64_t end = start + domain_ms;
+  custom_plot->xAxis->setRange(start, end);
+  custom_plot->xAxis2->setRange(start, end);
+
+  size_t max_points = 2 * std::max(100, custom_plot->axisRect()->width());
+
+  std::vector<double> times, values;
+  for (const overlay_run & run : overlay_runs)
+  {
+    for (int i = 0; i < run.graphs.size(); i++)
+    {
+      QCPGraph * graph = run.graphs[i];
+      if (graph == NULL) { continue; }
+
+      bool visible = all_plots[i]->display->isChecked();
+      graph->setVisible(visible);
+      if (!visible) { continue; }
+
+      run.capture->get_plot_points(run.channels[i], run.trigger_time + start,
+        run.trigger_time + end, max_points, times, values);
+      for (double & time : times) { time -= run.trigger_time; }
+      graph->setData(QVector<double>::fromStdVector(times),
+        QVector<double>::fromStdVector(values), true);
+    }
+  }
+
+  custom_plot->replot();
+}
+
 void dynamic_decimal_spin_box::stepBy(int steps)
 {
   int val = qRound(value() * 100);
@@ -1,19 +1,36 @@
 #pragma once
 
+#include "capture_file.h"
 #include "qcustomplot.h"
+#include "sample_buffer.h"
 
 #include <QCheckBox>
 #include <QDoubleSpinBox>
+#include <QElapsedTimer>
 #include <QGridLayout>
 #include <QLabel>
 #include <QMenu>
 #include <QMenuBar>
 #include <QPushButton>
+#include <QScrollBar>
 #include <QString>
+#include <QTimer>
 #include <QWidget>
 
+#include <memory>
+#include <vector>
+
 class dynamic_decimal_spin_box;
 class big_hit_check_box;
+class spectrum_widget;
+
+// A QCustomPlot that lets us check whether its layers can be replotted
+// individually, or need a full replot first.
+class graph_custom_plot : public QCustomPlot
+{
+public:
+  using QCustomPlot::hasInvalidatedPaintBuffers;
+};
 
 class graph_widget : public QObject
 {
@@ -45,6 +62,9 @@ public:
     QCPItemText * axis_position_label;
     QCPItemText * axis_scale_label;
     QList<QCPItemText *> overflow_arrows;
+
+    // The expression for a derived channel, or empty for a native channel.
+    QString expression;
   };
 
   QList<plot *> all_plots;
@@ -61,9 +81,17 @@ public:
   plot current;
   plot current_chopping;
 
-  QCustomPlot * custom_plot;
+  graph_custom_plot * custom_plot;
   QGridLayout * controls_layout;
 
+  // Shows the spectrum of one channel.  This is only shown in the graph
+  // window, and only gets samples while it is visible.
+  spectrum_widget * spectrum;
+
+  // Shows the position in a capture being replayed and lets the user scrub
+  // through it.  This is only shown in the graph window, while replaying.
+  QWidget * replay_controls;
+
   bool preview_mode = true;
 
   QMenu * setup_options_menu(const QString &, bool shortcuts = false);
@@ -72,28 +100,112 @@ public:
   void set_preview_mode(bool preview_mode);
   void set_paused(bool paused);
   void clear_graphs();
-  void plot_data(uint32_t time);
+  // Adds a sample at the specified time on the sample_timeline, in
+  // milliseconds.
+  void plot_data(int64_t time);
 
   void set_checkbox_style(plot *, const QString &);
   void change_plot_colors(plot *, const QString &);
 
+  // Plots for derived channels, in the same order as the values passed to
+  // set_derived_values().
+  QList<plot *> derived_plots;
+
+  void add_derived_plot(const QString & name, const QString & expression);
+  void remove_derived_plot(const QString & name);
+  void set_derived_values(const std::vector<double> & values);
+
+signals:
+  // Emitted when the user wants to add a derived channel, from the options
+  // menu or by loading graph settings.  The receiver should validate it and
+  // call add_derived_plot().
+  void derived_channel_requested(const QString & name,
+    const QString & expression);
+
+  // Emitted after the plot for a derived channel was removed.
+  void derived_channel_removed(const QString & name);
+
 protected:
   bool eventFilter(QObject * o, QEvent * e);
 
 private:
   void show_plot_menu(plot *, bool with_title);
+  void show_add_derived_channel_dialog();
   void pick_plot_color(plot *);
   void setup_ui();
 
   QMenuBar * menu_bar = NULL;
   QAction * dark_theme_action;
   QAction * default_theme_action;
+  QAction * show_spectrum_action;
+  QAction * record_action;
+  QAction * open_capture_action;
+  QAction * close_capture_action;
+
+  void update_spectrum_channels();
+
+  // The capture being recorded, if any.  Every sample passed to plot_data()
+  // is written to it, including samples that are not displayed because the
+  // graph is paused or a capture is being replayed.
+  std::unique_ptr<capture_writer> recorder;
+  QStringList recorded_ids;
+  std::vector<double> recorded_values;
+
+  void record_sample(int64_t time);
+  void update_record_action();
+
+  // The capture being replayed, if any.  While a capture is open, the graph
+  // shows it instead of the live data, and the pause/run button controls
+  // playback.
+  std::shared_ptr<const capture_reader> replay;
+
+  // The capture channel for each plot in all_plots, or -1.
+  std::vector<int> replay_channels;
+
+  QTimer * replay_timer;
+  QElapsedTimer replay_clock;
+  QScrollBar * replay_scroll_bar;
+  QLabel * replay_label;
+
+  void update_replay_channels();
+  void update_replay_controls();
+  void show_replay_data();
+
+  // Runs drawn on top of each other to compare step responses, aligned so
+  // that each run's trigger is at time 0.  Each run shares a capture_reader,
+  // so adding a run does not copy any samples, and it is drawn from the same
+  // decimation as a replay.  While there are runs, the graph shows them
+  // instead of live or replayed data.
+  struct overlay_run
+  {
+    std::shared_ptr<const capture_reader> capture;
+    int64_t trigger_time;
+    QString name;
+    QColor color;
+
+    // For each plot in all_plots: the capture channel (or -1) and the graph
+    // (or NULL).
+    std::vector<int> channels;
+    QList<QCPGraph *> graphs;
+  };
+
+  QList<overlay_run> overlay_runs;
+  QAction * add_overlay_captures_action;
+  QAction * add_overlay_step_action;
+  QAction * clear_overlay_action;
+
+  void add_overlay_run(const std::shared_ptr<const capture_reader> & capture,
+    int64_t from_time, const QString & name);
+  void remove_overlay_graphs();
+  void create_overlay_graphs();
+  void show_overlay_data();
 
   // Used to add new plot
   void setup_plot(plot &,
     const QString & id_string, const QString & display_text,
     const QString & default_color, const QString & dark_color,
-    int typical_max_value, bool default_visible = false);
+    int typical_max_value, sample_buffer::value_type sample_type,
+    bool default_visible = false);
 
   QCPItemText * axis_arrow(const plot &, double degrees);
   QPushButton * pause_run_button;
@@ -102,24 +214,40 @@ private:
 
   void update_x_axis();
   void remove_old_data();
+  void update_graph_data();
+  void replot_data(bool arrows_changed);
+
+  // The live samples, with one channel for each plot in all_plots, in the
+  // same order.  The QCPGraph of each plot only holds the points needed to
+  // draw the displayed time span.
+  sample_buffer samples;
+  sample_buffer paused_samples;
+  std::vector<double> sample_values;
+  std::vector<double> plot_times;
+  std::vector<double> plot_values;
   void set_graph_interaction_axis(const plot &);
   void reset_graph_interaction_axes();
   void update_plot_text_and_arrows(const plot &);
-  void update_plot_overflow_arrows(const plot &);
+  bool update_plot_overflow_arrows(const plot &);
   void update_position_step_value(const plot &);
   void reset_plot_range(const plot &);
   void set_range(const plot &);
   void set_plot_grid_colors(int value);
 
+  // Layers with their own paint buffers, so they can be redrawn without
+  // redrawing the grid, axes, and labels.
+  QCPLayer * data_layer;
+  QCPLayer * arrow_layer;
+
   QFont y_label_font;
   QFont x_label_font;
 
   // time value corresponding to the right edge of the graph
-  uint32_t display_time;
+  int64_t display_time = 0;
 
   // time value corresponding to the latest data from the device.
   // Should equal display_time if we are not paused.
-  uint32_t current_time;
+  int64_t current_time = 0;
 
   int row = 1;
   bool graph_paused = false;
@@ -139,6 +267,14 @@ private slots:
   void reset_all_colors();
   void reset_all_ranges();
   void mouse_press(QMouseEvent *);
+  void start_or_stop_recording();
+  void open_capture();
+  void close_capture();
+  void replay_tick();
+  void replay_scrolled(int value);
+  void add_overlay_captures();
+  void add_overlay_step();
+  void clear_overlay();
 };
 
 // This subclass of QDoubleSpinBox is used to add more control to both the
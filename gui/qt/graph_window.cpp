@@ -1,6 +1,7 @@
 #include "graph_window.h"
 #include "main_window.h"
 #include "graph_widget.h"
+#include "spectrum_widget.h"
 
 graph_window::graph_window()
 {
@@ -28,6 +29,15 @@ void graph_window::receive_widget(graph_widget * widget)
 {
   this->widget = widget;
 
+  // The replay controls and spectrum stay in this window while the graph is
+  // in preview mode, so they only need to be added the first time.  They have
+  // to be in this layout before leaving preview mode shows them.
+  if (central_layout->indexOf(widget->spectrum) < 0)
+  {
+    central_layout->addWidget(widget->replay_controls, 1, 0, 1, 2);
+    central_layout->addWidget(widget->spectrum, 2, 0, 1, 2);
+  }
+
   widget->set_preview_mode(false);
 
   widget->controls_layout->setParent(0);
@@ -31,6 +31,7 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QProcessEnvironment>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QRadioButton>
 #include <QShortcut>
@@ -43,6 +44,7 @@
 #include <QFontMetrics>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 
 #ifdef QT_STATIC
 #include <QtPlugin>
@@ -63,8 +65,24 @@ Q_IMPORT_PLUGIN (QCocoaIntegrationPlugin);
 main_window::main_window(QWidget * parent)
   : QMainWindow(parent)
 {
+  auto env = QProcessEnvironment::systemEnvironment();
+  report_startup_times = !env.value("JRK2GUI_STARTUP_TIME").isEmpty();
+  startup_timer.start();
+
   setup_ui();
   graph_wind = 0;
+
+  report_startup_time("window built");
+}
+
+// If the JRK2GUI_STARTUP_TIME environment variable is set, prints how long it
+// has been since the window started being built, to help us keep startup fast
+// on slow computers.
+void main_window::report_startup_time(const char * milestone)
+{
+  if (!report_startup_times) { return; }
+  fprintf(stderr, "Startup: %s after %lld ms.\n", milestone,
+    (long long)startup_timer.elapsed());
 }
 
 void main_window::set_controller(main_controller * controller)
@@ -162,7 +180,7 @@ void main_window::set_up_time(uint32_t up_time)
 
 void main_window::set_input(uint16_t input, uint8_t input_mode)
 {
-  graph->input.plot_value = input;
+  if (graph) { graph->input.plot_value = input; }
 
   QString input_pretty = "";
 
@@ -184,13 +202,13 @@ void main_window::set_input(uint16_t input, uint8_t input_mode)
 
 void main_window::set_target(uint16_t target)
 {
-  graph->target.plot_value = target;
+  if (graph) { graph->target.plot_value = target; }
   target_value->setText(QString::number(target));
 }
 
 void main_window::set_feedback(uint16_t feedback, uint8_t feedback_mode)
 {
-  graph->feedback.plot_value = feedback;
+  if (graph) { graph->feedback.plot_value = feedback; }
 
   QString feedback_pretty = "";
 
@@ -206,35 +224,35 @@ void main_window::set_feedback(uint16_t feedback, uint8_t feedback_mode)
 
 void main_window::set_scaled_feedback(uint16_t scaled_feedback)
 {
-  graph->scaled_feedback.plot_value = scaled_feedback;
+  if (graph) { graph->scaled_feedback.plot_value = scaled_feedback; }
   manual_target_slider->set_scaled_feedback(scaled_feedback);
   scaled_feedback_value->setText(QString::number(scaled_feedback));
 }
 
 void main_window::set_feedback_not_applicable()
 {
-  graph->feedback.plot_value = 0;
+  if (graph) { graph->feedback.plot_value = 0; }
   feedback_value->setText(tr("N/A"));
 
-  graph->scaled_feedback.plot_value = 0;
+  if (graph) { graph->scaled_feedback.plot_value = 0; }
   scaled_feedback_value->setText(tr("N/A"));
 
-  graph->error.plot_value = 0;
+  if (graph) { graph->error.plot_value = 0; }
   error_value->setText("N/A");
 
-  graph->integral.plot_value = 0;
+  if (graph) { graph->integral.plot_value = 0; }
   integral_value->setText("N/A");
 }
 
 void main_window::set_error(int16_t error)
 {
-  graph->error.plot_value = error;
+  if (graph) { graph->error.plot_value = error; }
   error_value->setText(QString::number(error));
 }
 
 void main_window::set_integral(int16_t integral)
 {
-  graph->integral.plot_value = integral;
+  if (graph) { graph->integral.plot_value = integral; }
   integral_value->setText(QString::number(integral));
 }
 
@@ -247,13 +265,13 @@ static QString format_duty_cycle(int16_t duty_cycle)
 
 void main_window::set_duty_cycle_target(int16_t duty_cycle_target)
 {
-  graph->duty_cycle_target.plot_value = duty_cycle_target;
+  if (graph) { graph->duty_cycle_target.plot_value = duty_cycle_target; }
   duty_cycle_target_value->setText(format_duty_cycle(duty_cycle_target));
 }
 
 void main_window::set_duty_cycle(int16_t duty_cycle)
 {
-  graph->duty_cycle.plot_value = duty_cycle;
+  if (graph) { graph->duty_cycle.plot_value = duty_cycle; }
   manual_target_slider->set_duty_cycle(duty_cycle);
   duty_cycle_value->setText(format_duty_cycle(duty_cycle));
   emit duty_cycle_changed(duty_cycle);
@@ -262,19 +280,19 @@ void main_window::set_duty_cycle(int16_t duty_cycle)
 void main_window::set_raw_current_mv64(uint32_t current)
 {
   double current_mv = current / 64.0;
-  graph->raw_current.plot_value = current_mv;
+  if (graph) { graph->raw_current.plot_value = current_mv; }
   raw_current_value->setText(QString::number(current_mv, 'f', 2) + " mV");
 }
 
 void main_window::set_current(int32_t current)
 {
-  graph->current.plot_value = current;
+  if (graph) { graph->current.plot_value = current; }
   current_value->setText(QString::number(current) + " mA");
 }
 
 void main_window::set_current_chopping_now(bool chopping)
 {
-  graph->current_chopping.plot_value = chopping;
+  if (graph) { graph->current_chopping.plot_value = chopping; }
 }
 
 void main_window::set_current_chopping_count(uint32_t count)
@@ -372,6 +390,7 @@ void main_window::adjust_ui_for_product(uint32_t product)
   current_chopping_count_label->setVisible(current_chopping_sensing);
   current_chopping_count_value->setVisible(current_chopping_sensing);
   clear_current_chopping_count_action->setVisible(current_chopping_sensing);
+  save_current_chopping_log_action->setVisible(current_chopping_sensing);
   // Note: Would be nice to hide custom_plot->current_chopping plot too.
 
   soft_current_regulation_level_label->setVisible(soft_current_regulation);
@@ -440,8 +459,25 @@ void main_window::set_apply_settings_enabled(bool enabled)
     enabled ? apply_settings_label->toolTip() : "");
 }
 
+void main_window::show_settings_progress(const std::string & text,
+  uint32_t done, uint32_t total)
+{
+  settings_progress_bar->setFormat(QString::fromStdString(text));
+  settings_progress_bar->setRange(0, total);
+  settings_progress_bar->setValue(done);
+  settings_progress_bar->setVisible(true);
+  cancel_settings_button->setVisible(true);
+}
+
+void main_window::hide_settings_progress()
+{
+  settings_progress_bar->setVisible(false);
+  cancel_settings_button->setVisible(false);
+}
+
 void main_window::set_motor_status_message(
-  const std::string & message, uint16_t error_flag)
+  const std::string & message, uint16_t error_flag,
+  const std::string & findings)
 {
   // setStyleSheet() is expensive, so only call it if something actually
   // changed. Check if there's currently a stylesheet applied and decide
@@ -464,7 +500,18 @@ void main_window::set_motor_status_message(
   }
 
   QString message_qstr = QString::fromStdString(message);
-  motor_status_value->setText(message_qstr);
+  if (findings.empty())
+  {
+    motor_status_value->setText(message_qstr);
+    motor_status_value->setToolTip(QString());
+    return;
+  }
+
+  QString findings_qstr = QString::fromStdString(findings).trimmed();
+  motor_status_value->setText(message_qstr + "  Recently: " +
+    findings_qstr.section('\n', 0, 0));
+  motor_status_value->setToolTip(message_qstr + "\n\nRecently:\n" +
+    findings_qstr);
 }
 
 void main_window::set_apply_settings_button_stylesheet(int offset)
@@ -1133,6 +1180,11 @@ void main_window::set_tab_pages_enabled(bool enabled)
   manual_target_box->setEnabled(
     variables_box->isEnabled() && manual_target_enabled);
 
+  set_settings_pages_enabled(enabled);
+}
+
+void main_window::set_settings_pages_enabled(bool enabled)
+{
   for (int i = 1; i < tab_widget->count(); i++)
   {
     tab_widget->widget(i)->setEnabled(enabled);
@@ -1177,14 +1229,40 @@ bool main_window::motor_asymmetric_checked()
   return motor_asymmetric_checkbox->isChecked();
 }
 
-void main_window::update_graph(uint32_t up_time)
+void main_window::update_graph(int64_t time)
+{
+  if (graph) { graph->plot_data(time); }
+}
+
+void main_window::set_derived_channel_values(const std::vector<double> & values)
+{
+  if (graph) { graph->set_derived_values(values); }
+}
+
+void main_window::add_derived_channel(const QString & name,
+  const QString & expression)
+{
+  try
+  {
+    controller->add_derived_channel(name.toStdString(),
+      expression.toStdString());
+  }
+  catch (const std::exception & e)
+  {
+    show_error_message(e.what());
+    return;
+  }
+  graph->add_derived_plot(name, expression);
+}
+
+void main_window::remove_derived_channel(const QString & name)
 {
-  graph->plot_data(up_time);
+  controller->remove_derived_channel(name.toStdString());
 }
 
 void main_window::reset_graph()
 {
-  graph->clear_graphs();
+  if (graph) { graph->clear_graphs(); }
 }
 
 void main_window::set_u8_combobox(QComboBox * combo, uint8_t value)
@@ -1258,7 +1336,18 @@ void main_window::showEvent(QShowEvent * event)
   {
     start_event_reported = true;
     center_at_startup_if_needed();
-    controller->start();
+    report_startup_time("window shown");
+
+    QTimer::singleShot(0, this, [this]()
+    {
+      setup_settings_tabs();
+
+      // The new tabs might need a bigger window.
+      adjustSize();
+      center_at_startup_if_needed();
+
+      controller->start();
+    });
   }
 }
 
@@ -1277,12 +1366,19 @@ void main_window::closeEvent(QCloseEvent * event)
 
 bool main_window::eventFilter(QObject * object, QEvent * event)
 {
-  if (event->type() == QEvent::MouseButtonPress && object == graph->custom_plot
-    && graph->preview_mode)
+  if (event->type() == QEvent::MouseButtonPress && graph
+    && object == graph->custom_plot && graph->preview_mode)
   {
     open_graph_window();
     return true;
   }
+
+  // Build the graph after the window has been drawn with the preview frame
+  // for the first time.
+  if (event->type() == QEvent::Show && object == graph_preview_frame && !graph)
+  {
+    QTimer::singleShot(0, this, &main_window::setup_graph_widget);
+  }
   return QMainWindow::eventFilter(object, event);
 }
 
@@ -1303,6 +1399,8 @@ void main_window::restore_graph_preview()
 
 void main_window::open_graph_window()
 {
+  setup_graph_widget();
+
   if (graph_wind == NULL)
   {
     graph_wind = new graph_window();
@@ -1351,6 +1449,11 @@ void main_window::on_apply_settings_action_triggered()
   controller->apply_settings();
 }
 
+void main_window::on_cancel_settings_button_clicked()
+{
+  controller->cancel_settings_operation();
+}
+
 void main_window::on_upgrade_firmware_action_triggered()
 {
   controller->upgrade_firmware();
@@ -1376,6 +1479,19 @@ void main_window::on_clear_current_chopping_count_action_triggered()
   controller->clear_current_chopping_count();
 }
 
+void main_window::on_save_current_chopping_log_action_triggered()
+{
+  QString filename = QFileDialog::getSaveFileName(this,
+    tr("Save Current Chopping Log"), directory_hint + "/jrk_chopping.txt",
+    tr("Text files (*.txt)"));
+
+  if (!filename.isNull())
+  {
+    directory_hint = QFileInfo(filename).canonicalPath();
+    controller->save_current_chopping_log(filename.toStdString());
+  }
+}
+
 void main_window::on_set_target_button_clicked()
 {
   controller->set_target(manual_target_entry_value->value());
@@ -2023,19 +2139,10 @@ void main_window::setup_ui()
   main_window_layout = new QVBoxLayout();
   main_window_layout->setObjectName("main_window_layout");
 
+  // The other tabs are added by setup_settings_tabs() after the window is
+  // shown.
   tab_widget = new QTabWidget();
   tab_widget->addTab(setup_status_tab(), tr("Status"));
-  tab_widget->addTab(setup_input_tab(), tr("Input"));
-  tab_widget->addTab(setup_feedback_tab(), tr("Feedback"));
-  tab_widget->addTab(setup_pid_tab(), tr("PID"));
-  tab_widget->addTab(setup_motor_tab(), tr("Motor"));
-  tab_widget->addTab(setup_errors_tab(), tr("Errors"));
-  tab_widget->addTab(setup_advanced_tab(), tr("Advanced"));
-  tab_widget->addTab(setup_info_tab(), tr("Device info"));
-
-  // Let the user specify which tab to start on.  Handy for development.
-  auto env = QProcessEnvironment::systemEnvironment();
-  tab_widget->setCurrentIndex(env.value("JRK2GUI_TAB").toInt());
 
   stop_motor_button = new QPushButton();
   stop_motor_button->setObjectName("stop_motor_button");
@@ -2066,10 +2173,21 @@ void main_window::setup_ui()
   apply_settings_button->setText(tr("&Apply settings"));
   set_apply_settings_button_stylesheet(0);
 
+  settings_progress_bar = new QProgressBar();
+  settings_progress_bar->setTextVisible(true);
+  settings_progress_bar->setVisible(false);
+
+  cancel_settings_button = new QPushButton();
+  cancel_settings_button->setObjectName("cancel_settings_button");
+  cancel_settings_button->setText(tr("Cancel"));
+  cancel_settings_button->setVisible(false);
+
   QHBoxLayout *footer_layout = new QHBoxLayout();
   footer_layout->addWidget(stop_motor_button, 0, Qt::AlignLeft);
   footer_layout->addWidget(run_motor_button, 0, Qt::AlignLeft);
   footer_layout->addWidget(motor_status_value, 1);
+  footer_layout->addWidget(settings_progress_bar, 0, Qt::AlignRight);
+  footer_layout->addWidget(cancel_settings_button, 0, Qt::AlignRight);
   footer_layout->addWidget(apply_settings_label, 0, Qt::AlignRight);
   footer_layout->addWidget(apply_settings_button, 0, Qt::AlignRight);
 
@@ -2093,12 +2211,32 @@ void main_window::setup_ui()
     apply_settings_action, SLOT(trigger()));
 
   central_widget->setLayout(main_window_layout);
+}
+
+// Builds the tabs other than the "Status" tab.  This is done after the window
+// is shown so that it appears sooner on slow computers.  The controller is not
+// started until this is done, so it never sees the tabs missing.
+void main_window::setup_settings_tabs()
+{
+  tab_widget->addTab(setup_input_tab(), tr("Input"));
+  tab_widget->addTab(setup_feedback_tab(), tr("Feedback"));
+  tab_widget->addTab(setup_pid_tab(), tr("PID"));
+  tab_widget->addTab(setup_motor_tab(), tr("Motor"));
+  tab_widget->addTab(setup_errors_tab(), tr("Errors"));
+  tab_widget->addTab(setup_advanced_tab(), tr("Advanced"));
+  tab_widget->addTab(setup_info_tab(), tr("Device info"));
+
+  // Let the user specify which tab to start on.  Handy for development.
+  auto env = QProcessEnvironment::systemEnvironment();
+  tab_widget->setCurrentIndex(env.value("JRK2GUI_TAB").toInt());
 
   // Without this line, some unneeded current controls would be visible
   // in the "Motor" tab, making the window taller than necessary.
   adjust_ui_for_product(JRK_PRODUCT_UMC04A_30V);
 
   QMetaObject::connectSlotsByName(this);
+
+  report_startup_time("tabs built");
 }
 
 void main_window::setup_style_sheet()
@@ -2175,6 +2313,12 @@ void main_window::setup_menu_bar()
   clear_current_chopping_count_action->setText(
     tr("&Clear current chopping count"));
 
+  save_current_chopping_log_action = new QAction(this);
+  save_current_chopping_log_action->setObjectName(
+    "save_current_chopping_log_action");
+  save_current_chopping_log_action->setText(
+    tr("Save current c&hopping log..."));
+
   reload_settings_action = new QAction(this);
   reload_settings_action->setObjectName("reload_settings_action");
   reload_settings_action->setText(tr("Re&load settings from device"));
@@ -2223,6 +2367,7 @@ void main_window::setup_menu_bar()
   device_menu->addAction(stop_motor_action);
   device_menu->addAction(run_motor_action);
   device_menu->addAction(clear_current_chopping_count_action);
+  device_menu->addAction(save_current_chopping_log_action);
   device_menu->addSeparator();
   device_menu->addAction(reload_settings_action);
   device_menu->addAction(restore_defaults_action);
@@ -2291,29 +2436,59 @@ QWidget * main_window::setup_status_tab()
   return status_page_widget;
 }
 
+// Sets up the frame for the graph preview.  The graph itself is built later
+// by setup_graph_widget() because loading its font and creating its plots
+// takes a noticeable part of the startup time on slow computers.
 QWidget * main_window::setup_graph()
 {
-  graph = new graph_widget();
-  graph->setObjectName(QStringLiteral("graph"));
-  graph->set_preview_mode(true);
-  graph->custom_plot->installEventFilter(this);
-  graph->setParent(this);
+  graph = NULL;
 
-  window_menu->addMenu(graph->setup_options_menu("Graph options"));
+  // A placeholder that gets replaced by the graph's options menu.  The graph
+  // is built before the Window menu is shown, in case it was not built yet.
+  graph_options_placeholder = window_menu->addMenu("Graph options");
+  connect(window_menu, &QMenu::aboutToShow,
+    this, &main_window::setup_graph_widget);
 
   graph_preview_frame = new QFrame();
   graph_preview_frame->setFrameStyle(QFrame::Box | QFrame::Plain);
   graph_preview_frame->setLineWidth(1);
+  graph_preview_frame->installEventFilter(this);
 
   graph_preview_frame_layout = new QHBoxLayout();
   graph_preview_frame_layout->setContentsMargins(0, 0, 0, 0);
-  graph_preview_frame_layout->addWidget(graph->custom_plot, 1);
 
   graph_preview_frame->setLayout(graph_preview_frame_layout);
 
   return graph_preview_frame;
 }
 
+// Builds the graph if it has not been built yet.
+void main_window::setup_graph_widget()
+{
+  if (graph) { return; }
+
+  graph = new graph_widget();
+  graph->setObjectName(QStringLiteral("graph"));
+  graph->set_preview_mode(true);
+  graph->custom_plot->installEventFilter(this);
+  graph->setParent(this);
+
+  window_menu->insertMenu(graph_options_placeholder->menuAction(),
+    graph->setup_options_menu("Graph options"));
+  window_menu->removeAction(graph_options_placeholder->menuAction());
+  graph_options_placeholder->deleteLater();
+  graph_options_placeholder = NULL;
+
+  connect(graph, &graph_widget::derived_channel_requested,
+    this, &main_window::add_derived_channel);
+  connect(graph, &graph_widget::derived_channel_removed,
+    this, &main_window::remove_derived_channel);
+
+  graph_preview_frame_layout->addWidget(graph->custom_plot, 1);
+
+  report_startup_time("graph built");
+}
+
 QWidget * main_window::setup_variables_box()
 {
   variables_box = new QGroupBox();
@@ -10,6 +10,7 @@
 
 #include "jrk.hpp"
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QGroupBox>
 #include <QButtonGroup>
@@ -25,6 +26,7 @@ class QGroupBox;
 class QHBoxLayout;
 class QLineEdit;
 class QMenu;
+class QProgressBar;
 class QRadioButton;
 class QShortcut;
 class QShowEvent;
@@ -119,12 +121,21 @@ public:
   // disabled.
   void set_apply_settings_enabled(bool enabled);
 
+  // Shows the diagnosis of the motor status.  The findings argument holds
+  // the lines of jrk::diagnosis_window::get_findings(): the first one is shown
+  // after the message, and all of them are shown in the tooltip.
   void set_motor_status_message(const std::string & message,
-    uint16_t error_flag = 0);
+    uint16_t error_flag = 0, const std::string & findings = "");
 
   void set_apply_settings_button_stylesheet(int offset);
   void animate_apply_settings_button();
 
+  // Shows the progress of applying or reloading settings.  If total is 0,
+  // the progress bar just shows that something is happening.
+  void show_settings_progress(const std::string & text,
+    uint32_t done, uint32_t total);
+  void hide_settings_progress();
+
   void set_input_mode(uint8_t input_mode);
   void set_input_invert(bool input_invert);
   void set_input_analog_samples_exponent(uint8_t value);
@@ -220,6 +231,7 @@ public:
   void set_serial_device_number(uint8_t serial_device_number);
 
   void set_tab_pages_enabled(bool enabled);
+  void set_settings_pages_enabled(bool enabled);
   void set_open_save_settings_enabled(bool enabled);
   void set_disconnect_enabled(bool enabled);
   void set_reload_settings_enabled(bool enabled);
@@ -229,7 +241,8 @@ public:
 
   bool motor_asymmetric_checked();
 
-  void update_graph(uint32_t up_time);
+  void update_graph(int64_t time);
+  void set_derived_channel_values(const std::vector<double> & values);
 
   void reset_graph();
 
@@ -246,6 +259,10 @@ private:
   void set_check_box(QCheckBox * check, bool value);
 
   void center_at_startup_if_needed();
+  void report_startup_time(const char * milestone);
+
+  QElapsedTimer startup_timer;
+  bool report_startup_times = false;
 
 signals:
   void input_changed(uint16_t);
@@ -270,16 +287,21 @@ private slots:
   void on_update_timer_timeout();
   void restore_graph_preview();
   void open_graph_window();
+  void setup_graph_widget();
   void on_device_name_value_linkActivated();
   void on_documentation_action_triggered();
   void on_about_action_triggered();
   void on_device_list_value_currentIndexChanged(int index);
   void on_apply_settings_action_triggered();
+  void on_cancel_settings_button_clicked();
+  void add_derived_channel(const QString & name, const QString & expression);
+  void remove_derived_channel(const QString & name);
   void on_upgrade_firmware_action_triggered();
   void upgrade_firmware_complete();
   void on_run_motor_action_triggered();
   void on_stop_motor_action_triggered();
   void on_clear_current_chopping_count_action_triggered();
+  void on_save_current_chopping_log_action_triggered();
   void on_set_target_button_clicked();
   void on_center_target_button_clicked();
   void on_auto_set_target_check_stateChanged(int state);
@@ -382,6 +404,7 @@ private slots:
 
 private:
   void setup_ui();
+  void setup_settings_tabs();
   void setup_style_sheet();
   void setup_menu_bar();
 
@@ -424,6 +447,7 @@ private:
   graph_window * graph_wind;
   QFrame * graph_preview_frame;
   QHBoxLayout * graph_preview_frame_layout;
+  QMenu * graph_options_placeholder;
 
   QMenuBar * menu_bar;
   QMenu * file_menu;
@@ -435,6 +459,7 @@ private:
   QAction * stop_motor_action;
   QAction * run_motor_action;
   QAction * clear_current_chopping_count_action;
+  QAction * save_current_chopping_log_action;
   QAction * reload_settings_action;
   QAction * restore_defaults_action;
   QAction * apply_settings_action;
@@ -707,6 +732,8 @@ private:
   QLabel * apply_settings_label;
   QPushButton * apply_settings_button;
   uint32_t apply_settings_animation_count = 0;
+  QProgressBar * settings_progress_bar;
+  QPushButton * cancel_settings_button;
 
   // advanced tab
 
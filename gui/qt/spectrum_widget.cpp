@@ -0,0 +1,119 @@
+#include "spectrum_widget.h"
+#include "qcustomplot.h"
+
+#include <QComboBox>
+#include <QGridLayout>
+#include <QLabel>
+
+spectrum_widget::spectrum_widget(QWidget * parent) : QWidget(parent)
+{
+  channel_combo = new QComboBox();
+  connect(channel_combo,
+    static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+    this, &spectrum_widget::channel_changed);
+
+  peak_value = new QLabel();
+
+  band_value = new QLabel();
+  band_value->setWordWrap(true);
+
+  custom_plot = new QCustomPlot();
+  custom_plot->setMinimumHeight(150);
+  custom_plot->xAxis->setLabel(tr("Frequency (Hz)"));
+  custom_plot->yAxis->setLabel(tr("Amplitude"));
+  graph = custom_plot->addGraph();
+  graph->setLineStyle(QCPGraph::lsStepCenter);
+  graph->setBrush(QColor(31, 47, 147, 60));
+  graph->setPen(QPen(QColor(31, 47, 147)));
+
+  frequencies.resize(spectrum_analyzer::BIN_COUNT);
+  magnitudes.resize(spectrum_analyzer::BIN_COUNT);
+
+  QGridLayout * layout = new QGridLayout();
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->addWidget(new QLabel(tr("Spectrum of:")), 0, 0);
+  layout->addWidget(channel_combo, 0, 1);
+  layout->addWidget(peak_value, 0, 2);
+  layout->addWidget(band_value, 1, 0, 1, 4);
+  layout->addWidget(custom_plot, 2, 0, 1, 4);
+  layout->setColumnStretch(3, 1);
+  setLayout(layout);
+
+  update_display();
+}
+
+void spectrum_widget::set_channels(const QStringList & names)
+{
+  QString current = channel_combo->currentText();
+
+  {
+    QSignalBlocker blocker(channel_combo);
+    channel_combo->clear();
+    channel_combo->addItems(names);
+    int index = channel_combo->findText(current);
+    channel_combo->setCurrentIndex(index < 0 ? 0 : index);
+  }
+
+  if (channel_combo->currentText() != current) { channel_changed(); }
+}
+
+int spectrum_widget::get_channel() const
+{
+  return channel_combo->currentIndex();
+}
+
+void spectrum_widget::add_sample(double value, int64_t time)
+{
+  analyzer.add_sample(value, time);
+}
+
+void spectrum_widget::clear()
+{
+  analyzer.clear();
+  update_display();
+}
+
+void spectrum_widget::channel_changed()
+{
+  clear();
+}
+
+void spectrum_widget::update_display()
+{
+  analyzer.get_magnitudes(magnitudes.data());
+  double max_magnitude = 0;
+  for (size_t k = 0; k < spectrum_analyzer::BIN_COUNT; k++)
+  {
+    frequencies[k] = analyzer.get_bin_frequency(k);
+    if (k != 0 && magnitudes[k] > max_magnitude) { max_magnitude = magnitudes[k]; }
+  }
+  graph->setData(frequencies, magnitudes, true);
+
+  double nyquist = analyzer.get_sample_rate() / 2;
+  custom_plot->xAxis->setRange(0, nyquist > 0 ? nyquist : 1);
+
+  if (nyquist > 0)
+  {
+    band_value->setText(tr("Only frequencies up to %1 Hz can be shown.  "
+      "Faster oscillations appear at lower frequencies.")
+      .arg(nyquist, 0, 'f', 1));
+  }
+  else
+  {
+    band_value->setText(QString());
+  }
+  custom_plot->yAxis->setRange(0, max_magnitude > 0 ? max_magnitude * 1.1 : 1);
+
+  if (analyzer.get_sample_count() < spectrum_analyzer::WINDOW_SIZE)
+  {
+    peak_value->setText(tr("Collecting samples: %1 of %2")
+      .arg(analyzer.get_sample_count()).arg(spectrum_analyzer::WINDOW_SIZE));
+  }
+  else
+  {
+    peak_value->setText(tr("Peak: %1 Hz")
+      .arg(analyzer.get_peak_frequency(), 0, 'f', 2));
+  }
+
+  custom_plot->replot();
+}
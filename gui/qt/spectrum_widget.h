@@ -0,0 +1,56 @@
+#pragma once
+
+#include "spectrum_analyzer.h"
+
+#include <QStringList>
+#include <QVector>
+#include <QWidget>
+
+class QComboBox;
+class QCPGraph;
+class QCustomPlot;
+class QLabel;
+
+// Shows the spectrum of one of the graph's channels, to help find the
+// frequency of oscillations.
+//
+// The samples come from the graph, which is only updated each time the GUI
+// reads the variables (every 50 ms).  So the spectrum only covers 0 to 10 Hz,
+// and faster oscillations show up at the wrong frequency.  The widget says
+// this next to the peak frequency.
+class spectrum_widget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  spectrum_widget(QWidget * parent = NULL);
+
+  // Sets the names of the channels the user can choose from, keeping the
+  // current choice if it is still in the list.
+  void set_channels(const QStringList & names);
+
+  // Returns the index of the chosen channel in the list.
+  int get_channel() const;
+
+  void add_sample(double value, int64_t time);
+
+  // Redraws the spectrum and the peak frequency.
+  void update_display();
+
+  void clear();
+
+private slots:
+  void channel_changed();
+
+private:
+  spectrum_analyzer analyzer;
+
+  QComboBox * channel_combo;
+  QLabel * peak_value;
+  QLabel * band_value;
+  QCustomPlot * custom_plot;
+  QCPGraph * graph;
+
+  QVector<double> frequencies;
+  QVector<double> magnitudes;
+};
@@ -0,0 +1,281 @@
+#include "sample_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static size_t type_width(sample_buffer::value_type type)
+{
+  switch (type)
+  {
+  case sample_buffer::TYPE_UINT8: return 1;
+  case sample_buffer::TYPE_INT16: return 2;
+  case sample_buffer::TYPE_UINT16: return 2;
+  case sample_buffer::TYPE_INT32: return 4;
+  default: return 4;
+  }
+}
+
+template <typename T> static T clamp_to(double value)
+{
+  if (std::isnan(value)) { return 0; }
+  value = std::round(value);
+  if (value < (double)std::numeric_limits<T>::min())
+  {
+    return std::numeric_limits<T>::min();
+  }
+  if (value > (double)std::numeric_limits<T>::max())
+  {
+    return std::numeric_limits<T>::max();
+  }
+  return (T)value;
+}
+
+void sample_buffer::store(column & c, size_t index, double value)
+{
+  uint8_t * p = &c.data[index * c.width];
+  switch (c.type)
+  {
+  case TYPE_UINT8:
+    *p = clamp_to<uint8_t>(value);
+    break;
+  case TYPE_INT16:
+    {
+      int16_t v = clamp_to<int16_t>(value);
+      memcpy(p, &v, sizeof(v));
+      break;
+    }
+  case TYPE_UINT16:
+    {
+      uint16_t v = clamp_to<uint16_t>(value);
+      memcpy(p, &v, sizeof(v));
+      break;
+    }
+  case TYPE_INT32:
+    {
+      int32_t v = clamp_to<int32_t>(value);
+      memcpy(p, &v, sizeof(v));
+      break;
+    }
+  case TYPE_FLOAT:
+    {
+      float v = value;
+      memcpy(p, &v, sizeof(v));
+      break;
+    }
+  }
+}
+
+double sample_buffer::load(const column & c, size_t index)
+{
+  const uint8_t * p = &c.data[index * c.width];
+  switch (c.type)
+  {
+  case TYPE_UINT8:
+    return *p;
+  case TYPE_INT16:
+    {
+      int16_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  case TYPE_UINT16:
+    {
+      uint16_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  case TYPE_INT32:
+    {
+      int32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  case TYPE_FLOAT:
+    {
+      float v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  }
+  return 0;
+}
+
+size_t sample_buffer::add_channel(value_type type)
+{
+  column c;
+  c.type = type;
+  c.width = type_width(type);
+  c.data.resize(capacity * c.width);
+  for (size_t i = 0; i < capacity; i++)
+  {
+    store(c, i, type == TYPE_FLOAT ? NAN : 0);
+  }
+  columns.push_back(c);
+  return columns.size() - 1;
+}
+
+void sample_buffer::remove_channel(size_t channel)
+{
+  if (channel >= columns.size()) { return; }
+  columns.erase(columns.begin() + channel);
+}
+
+void sample_buffer::clear()
+{
+  head = 0;
+  count = 0;
+}
+
+// Doubles the capacity, moving the samples to the start of the arrays.
+void sample_buffer::grow()
+{
+  size_t new_capacity = capacity ? capacity * 2 : 256;
+
+  std::vector<uint32_t> new_times(new_capacity);
+  for (size_t i = 0; i < count; i++)
+  {
+    new_times[i] = times[physical_index(i)];
+  }
+  times.swap(new_times);
+
+  for (column & c : columns)
+  {
+    std::vector<uint8_t> new_data(new_capacity * c.width);
+    for (size_t i = 0; i < count; i++)
+    {
+      memcpy(&new_data[i * c.width], &c.data[physical_index(i) * c.width],
+        c.width);
+    }
+    c.data.swap(new_data);
+  }
+
+  capacity = new_capacity;
+  head = 0;
+}
+
+// Changes the base time so that the specified time fits in a 32-bit offset.
+// This only happens if the graph runs for weeks without clearing.  Samples
+// that are too old to be stored with the new time are removed.
+void sample_buffer::rebase(int64_t time)
+{
+  remove_before(time - UINT32_MAX);
+  int64_t new_base = count ? get_time(0) : time;
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t p = physical_index(i);
+    times[p] = (uint32_t)(base_time + times[p] - new_base);
+  }
+  base_time = new_base;
+}
+
+void sample_buffer::add_sample(int64_t time, const double * values)
+{
+  if (count == 0) { base_time = time; }
+  if (time - base_time > UINT32_MAX) { rebase(time); }
+
+  if (count == capacity) { grow(); }
+
+  size_t p = physical_index(count);
+  times[p] = (uint32_t)(time - base_time);
+  for (size_t i = 0; i < columns.size(); i++)
+  {
+    store(columns[i], p, values[i]);
+  }
+  count++;
+}
+
+void sample_buffer::remove_before(int64_t time)
+{
+  size_t n = find_sample(time);
+  head = physical_index(n);
+  count -= n;
+}
+
+void sample_buffer::copy_range(const sample_buffer & other, int64_t start,
+  int64_t end)
+{
+  clear();
+
+  size_t first = other.find_sample(start);
+  size_t last = other.find_sample(end + 1);
+  std::vector<double> values(other.columns.size());
+  for (size_t i = first; i < last; i++)
+  {
+    for (size_t c = 0; c < values.size(); c++)
+    {
+      values[c] = other.get_value(c, i);
+    }
+    add_sample(other.get_time(i), values.data());
+  }
+}
+
+int64_t sample_buffer::get_time(size_t sample) const
+{
+  return base_time + times[physical_index(sample)];
+}
+
+double sample_buffer::get_value(size_t channel, size_t sample) const
+{
+  return load(columns[channel], physical_index(sample));
+}
+
+size_t sample_buffer::find_sample(int64_t time) const
+{
+  size_t low = 0;
+  size_t high = count;
+  while (low < high)
+  {
+    size_t mid = low + (high - low) / 2;
+    if (get_time(mid) < time) { low = mid + 1; }
+    else { high = mid; }
+  }
+  return low;
+}
+
+void sample_buffer::get_plot_points(size_t channel, int64_t start,
+  int64_t end, size_t max_points, std::vector<double> & times,
+  std::vector<double> & values) const
+{
+  times.clear();
+  values.clear();
+  if (count == 0 || channel >= columns.size()) { return; }
+
+  size_t first = find_sample(start);
+  if (first > 0) { first--; }
+  size_t last = find_sample(end + 1);
+  if (last < count) { last++; }
+  size_t n = last - first;
+
+  if (n <= max_points || max_points < 2)
+  {
+    for (size_t i = first; i < last; i++)
+    {
+      times.push_back(get_time(i));
+      values.push_back(get_value(channel, i));
+    }
+    return;
+  }
+
+  // Each group becomes two points: its minimum at the time of its first
+  // sample and its maximum at the time of its middle sample.
+  size_t group_size = (n + max_points / 2 - 1) / (max_points / 2);
+  for (size_t begin = first; begin < last; begin += group_size)
+  {
+    size_t group_end = std::min(begin + group_size, last);
+    double min = NAN;
+    double max = NAN;
+    for (size_t i = begin; i < group_end; i++)
+    {
+      double v = get_value(channel, i);
+      if (std::isnan(v)) { continue; }
+      if (std::isnan(min) || v < min) { min = v; }
+      if (std::isnan(max) || v > max) { max = v; }
+    }
+    times.push_back(get_time(begin));
+    values.push_back(min);
+    times.push_back(get_time(begin + (group_end - begin) / 2));
+    values.push_back(max);
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Holds the recent samples of the graph's channels compactly.
+//
+// The samples are stored as a structure of arrays in a ring buffer: one array
+// of times, and one array per channel holding values in the channel's native
+// width (e.g. 2 bytes for a 16-bit variable from the device).  Times are
+// stored as 32-bit offsets from a 64-bit base time.  Values are converted to
+// doubles only when they are read, which is normally just for the decimated
+// points that get plotted.
+class sample_buffer
+{
+public:
+  enum value_type
+  {
+    TYPE_UINT8,
+    TYPE_INT16,
+    TYPE_UINT16,
+    TYPE_INT32,
+    TYPE_FLOAT,
+  };
+
+  // Adds a channel and returns its index.  The channel gets 0 for the
+  // samples that are already in the buffer, or NaN if it is TYPE_FLOAT.
+  size_t add_channel(value_type type);
+
+  // Removes a channel.  The channels after it move down by one.
+  void remove_channel(size_t channel);
+
+  size_t get_channel_count() const { return columns.size(); }
+
+  void clear();
+
+  // Adds a sample with a time in milliseconds that is not earlier than the
+  // previous sample.  The values array needs one value per channel; each
+  // value is rounded and clamped to fit the channel's type.
+  void add_sample(int64_t time, const double * values);
+
+  // Removes the samples before the specified time.
+  void remove_before(int64_t time);
+
+  // Copies the samples between the start and end times (inclusive) from
+  // another buffer with the same channels, replacing the contents of this
+  // buffer.
+  void copy_range(const sample_buffer & other, int64_t start, int64_t end);
+
+  size_t size() const { return count; }
+  int64_t get_time(size_t sample) const;
+  double get_value(size_t channel, size_t sample) const;
+
+  // Returns the index of the first sample at or after the specified time.
+  size_t find_sample(int64_t time) const;
+
+  // Gets the points needed to draw a channel between the start and end times,
+  // including one sample on each side so the line reaches the edges.  If
+  // there are more than max_points samples, the points are the minimum and
+  // maximum of groups of samples.  This works the same way as
+  // capture_reader::get_plot_points().
+  void get_plot_points(size_t channel, int64_t start, int64_t end,
+    size_t max_points, std::vector<double> & times,
+    std::vector<double> & values) const;
+
+private:
+  struct column
+  {
+    value_type type;
+    size_t width;
+    std::vector<uint8_t> data;
+  };
+
+  size_t physical_index(size_t sample) const
+  {
+    return (head + sample) & (capacity - 1);
+  }
+
+  void grow();
+  void rebase(int64_t time);
+  static void store(column & c, size_t index, double value);
+  static double load(const column & c, size_t index);
+
+  std::vector<column> columns;
+  std::vector<uint32_t> times;
+  int64_t base_time = 0;
+
+  // The capacity is always a power of two, or 0.
+  size_t capacity = 0;
+  size_t head = 0;
+  size_t count = 0;
+};
@@ -0,0 +1,68 @@
+#include "sample_timeline.h"
+
+#include <chrono>
+
+// If the device's up time advances this much less than the host's clock did,
+// we assume that the device was reset.  This has to be large enough to cover
+// the latency of reading variables from the device.
+static const int64_t RESET_TOLERANCE_MS = 1000;
+
+int64_t sample_timeline::host_time_ms()
+{
+  typedef std::chrono::steady_clock clock;
+  static const clock::time_point epoch = clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    clock::now() - epoch).count();
+}
+
+void sample_timeline::reset()
+{
+  anchored = false;
+  last_sample_was_reset = false;
+  reset_count = 0;
+}
+
+int64_t sample_timeline::map(uint32_t up_time)
+{
+  return map(up_time, host_time_ms());
+}
+
+int64_t sample_timeline::map(uint32_t up_time, int64_t host_time)
+{
+  last_sample_was_reset = false;
+
+  if (!anchored)
+  {
+    anchored = true;
+    last_up_time = up_time;
+    last_time = host_time;
+    last_host_time = host_time;
+    return last_time;
+  }
+
+  if (up_time == last_up_time)
+  {
+    return last_time;
+  }
+
+  // Unsigned subtraction handles the up time wrapping around.
+  int32_t device_elapsed = (int32_t)(uint32_t)(up_time - last_up_time);
+  int64_t host_elapsed = host_time - last_host_time;
+
+  if (device_elapsed < 0 || device_elapsed < host_elapsed - RESET_TOLERANCE_MS)
+  {
+    // The device's clock went backwards or fell behind, so it must have
+    // restarted.  Continue from the host's clock instead.
+    last_sample_was_reset = true;
+    reset_count++;
+    last_time += host_elapsed > 0 ? host_elapsed : 1;
+  }
+  else
+  {
+    last_time += device_elapsed;
+  }
+
+  last_up_time = up_time;
+  last_host_time = host_time;
+  return last_time;
+}
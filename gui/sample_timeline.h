@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+// Maps the 32-bit up time reported by a Jrk onto a 64-bit timeline based on
+// the host's monotonic clock.
+//
+// All timelines share the same epoch (the first time any of them is used), so
+// samples from different devices or different connections can be compared
+// directly.  Within a connection, the spacing between samples comes from the
+// device's up time, which is more accurate than the time when we happened to
+// read the variables.  The 32-bit up time wrapping around after 49 days does
+// not cause a discontinuity.  If the device's up time goes backwards or falls
+// behind the host's clock, we assume the device was reset and continue the
+// timeline from the host's clock.
+class sample_timeline
+{
+public:
+  // Returns the number of milliseconds since the timeline epoch.
+  static int64_t host_time_ms();
+
+  // Forgets the last up time, so the next sample starts a new segment of the
+  // timeline at the current host time.  Call this when connecting to a
+  // device.
+  void reset();
+
+  // Returns the time on the timeline, in milliseconds, that corresponds to
+  // the specified up time.  The up time should have been read from the device
+  // just now (or at the specified host time).  If the up time is the same as
+  // last time, we assume the variables were not updated and return the same
+  // time as last time.
+  int64_t map(uint32_t up_time);
+  int64_t map(uint32_t up_time, int64_t host_time);
+
+  // Returns true if the last call to map() detected that the device was reset.
+  bool device_was_reset() const { return last_sample_was_reset; }
+
+  // Returns the number of device resets detected since the last call to
+  // reset().
+  uint32_t get_reset_count() const { return reset_count; }
+
+private:
+  bool anchored = false;
+  bool last_sample_was_reset = false;
+  uint32_t reset_count = 0;
+  uint32_t last_up_time = 0;
+  int64_t last_time = 0;
+  int64_t last_host_time = 0;
+};
@@ -0,0 +1,183 @@
+#include "spectrum_analyzer.h"
+
+#include <cmath>
+
+static const size_t N = spectrum_analyzer::WINDOW_SIZE;
+
+namespace
+{
+  // Twiddle factors e^(-2*pi*i*k/N) and bit-reversed indices, computed once.
+  struct fft_tables
+  {
+    std::complex<double> twiddle[N];
+    size_t bit_reverse[N];
+
+    fft_tables()
+    {
+      const double pi = 3.14159265358979323846;
+      for (size_t k = 0; k < N; k++)
+      {
+        twiddle[k] = std::polar(1.0, -2 * pi * k / N);
+      }
+
+      size_t bits = 0;
+      while (((size_t)1 << bits) < N) { bits++; }
+      for (size_t i = 0; i < N; i++)
+      {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++)
+        {
+          if (i & ((size_t)1 << b)) { r |= (size_t)1 << (bits - 1 - b); }
+        }
+        bit_reverse[i] = r;
+      }
+    }
+  };
+
+  const fft_tables & tables()
+  {
+    static const fft_tables t;
+    return t;
+  }
+}
+
+spectrum_analyzer::spectrum_analyzer()
+{
+  clear();
+}
+
+void spectrum_analyzer::clear()
+{
+  for (size_t i = 0; i < N; i++)
+  {
+    samples[i] = 0;
+    times[i] = 0;
+    bins[i] = 0;
+  }
+  next = 0;
+  count = 0;
+  samples_since_recompute = 0;
+}
+
+void spectrum_analyzer::add_sample(double value, int64_t time)
+{
+  const fft_tables & t = tables();
+
+  // Sliding DFT: remove the oldest sample, add the new one, and rotate each
+  // bin by e^(2*pi*i*k/N) because every sample moves one step earlier in the
+  // window.
+  double delta = value - samples[next];
+  for (size_t k = 0; k < N; k++)
+  {
+    bins[k] = (bins[k] + delta) * std::conj(t.twiddle[k]);
+  }
+
+  samples[next] = value;
+  times[next] = time;
+  next = (next + 1) % N;
+  if (count < N) { count++; }
+
+  if (++samples_since_recompute == N)
+  {
+    recompute();
+  }
+}
+
+// Recomputes the bins from the samples with an iterative radix-2 FFT to get
+// rid of rounding errors accumulated by the sliding DFT.
+void spectrum_analyzer::recompute()
+{
+  const fft_tables & t = tables();
+
+  for (size_t i = 0; i < N; i++)
+  {
+    bins[t.bit_reverse[i]] = samples[(next + i) % N];
+  }
+
+  for (size_t size = 2; size <= N; size *= 2)
+  {
+    size_t half = size / 2;
+    size_t step = N / size;
+    for (size_t start = 0; start < N; start += size)
+    {
+      for (size_t j = 0; j < half; j++)
+      {
+        std::complex<double> a = bins[start + j];
+        std::complex<double> b = bins[start + j + half] * t.twiddle[j * step];
+        bins[start + j] = a + b;
+        bins[start + j + half] = a - b;
+      }
+    }
+  }
+
+  samples_since_recompute = 0;
+}
+
+double spectrum_analyzer::get_sample_rate() const
+{
+  if (count < 2) { return 0; }
+  size_t newest = (next + N - 1) % N;
+  size_t oldest = (next + N - count) % N;
+  double span_ms = (double)(times[newest] - times[oldest]);
+  if (span_ms <= 0) { return 0; }
+  return (count - 1) * 1000 / span_ms;
+}
+
+double spectrum_analyzer::get_bin_frequency(size_t bin) const
+{
+  return bin * get_sample_rate() / N;
+}
+
+// Returns bin k of the spectrum with the mean removed and a Hann window
+// applied.  Multiplying by the Hann window is the same as convolving the
+// spectrum with [-1/4, 1/2, -1/4], and removing the mean is the same as
+// zeroing bin 0.
+std::complex<double> spectrum_analyzer::windowed_bin(size_t k) const
+{
+  auto bin = [this](size_t i)
+  {
+    i %= N;
+    return i == 0 ? std::complex<double>(0) : bins[i];
+  };
+  return 0.5 * bin(k) - 0.25 * (bin(k + N - 1) + bin(k + 1));
+}
+
+void spectrum_analyzer::get_magnitudes(double * magnitudes) const
+{
+  // Scale so that a full-scale sine wave has a magnitude close to its
+  // amplitude (the Hann window has a gain of 1/2).
+  double scale = count ? 4.0 / N : 0;
+  for (size_t k = 0; k < BIN_COUNT; k++)
+  {
+    magnitudes[k] = std::abs(windowed_bin(k)) * scale;
+  }
+}
+
+double spectrum_analyzer::get_peak_frequency() const
+{
+  if (count < 2) { return 0; }
+
+  double magnitudes[BIN_COUNT];
+  get_magnitudes(magnitudes);
+
+  size_t peak = 1;
+  for (size_t k = 2; k < BIN_COUNT; k++)
+  {
+    if (magnitudes[k] > magnitudes[peak]) { peak = k; }
+  }
+  if (magnitudes[peak] == 0) { return 0; }
+
+  // Fit a parabola through the peak and its neighbors to estimate the
+  // frequency between bins.
+  double offset = 0;
+  if (peak + 1 < BIN_COUNT)
+  {
+    double a = magnitudes[peak - 1];
+    double b = magnitudes[peak];
+    double c = magnitudes[peak + 1];
+    double denominator = a - 2 * b + c;
+    if (denominator != 0) { offset = 0.5 * (a - c) / denominator; }
+  }
+
+  return (peak + offset) * get_sample_rate() / N;
+}
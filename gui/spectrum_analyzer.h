@@ -0,0 +1,64 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Keeps the spectrum of the last WINDOW_SIZE samples of a channel.
+//
+// The spectrum is updated incrementally with a sliding DFT: each new sample
+// costs one complex multiply per bin, using a precomputed twiddle table.
+// Because the sliding DFT accumulates rounding errors, the spectrum is
+// recomputed from scratch with an FFT each time the window has been
+// completely replaced.  A Hann window is applied when reading the magnitudes
+// and the mean is removed so that a large offset does not hide the peak.
+class spectrum_analyzer
+{
+public:
+  // Must be a power of two.
+  static const size_t WINDOW_SIZE = 128;
+
+  // The number of bins returned by get_magnitudes(), from 0 Hz to the
+  // Nyquist frequency.
+  static const size_t BIN_COUNT = WINDOW_SIZE / 2 + 1;
+
+  spectrum_analyzer();
+
+  void clear();
+
+  // Adds a sample.  The time is in milliseconds and is used to estimate the
+  // sample rate, since samples are not perfectly evenly spaced.
+  void add_sample(double value, int64_t time);
+
+  // Returns the number of samples in the window, up to WINDOW_SIZE.
+  size_t get_sample_count() const { return count; }
+
+  // Returns the estimated sample rate in Hz, or 0 if it is not known yet.
+  double get_sample_rate() const;
+
+  // Returns the frequency of the specified bin in Hz.
+  double get_bin_frequency(size_t bin) const;
+
+  // Fills the array with BIN_COUNT magnitudes.
+  void get_magnitudes(double * magnitudes) const;
+
+  // Returns the frequency of the highest peak in Hz (interpolated between
+  // bins), not counting the 0 Hz bin, or 0 if there is no data.
+  double get_peak_frequency() const;
+
+private:
+  std::complex<double> windowed_bin(size_t k) const;
+  void recompute();
+
+  double samples[WINDOW_SIZE];
+  int64_t times[WINDOW_SIZE];
+
+  // The index where the next sample goes, which is also the oldest sample.
+  size_t next = 0;
+  size_t count = 0;
+  size_t samples_since_recompute = 0;
+
+  // bins[k] is the DFT of the window with the oldest sample first.
+  std::complex<double> bins[WINDOW_SIZE];
+};
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <fstream>
@@ -12,6 +14,21 @@
 #include <stdexcept>
 #include <streambuf>
 #include <string>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+// Keep windows.h from defining min and max macros, which would break
+// std::min and std::max in the files that include this one.
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -83,6 +100,59 @@ namespace
     }
   }
 
+  // Returns the name of a file next to the specified file that does not
+  // exist yet.  The name includes the process ID and a counter, so other
+  // threads and processes writing the same file get different names, and it
+  // is checked so we never overwrite an unrelated file (like an input file
+  // that happens to be named "x.tmp").
+  inline std::string temp_filename_for(const std::string & filename)
+  {
+    static std::atomic<unsigned int> counter(0);
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = getpid();
+#endif
+    while (true)
+    {
+      std::string temp_filename = filename + ".tmp" + std::to_string(pid) +
+        "-" + std::to_string(counter++);
+      struct stat st;
+      if (stat(temp_filename.c_str(), &st) != 0) { return temp_filename; }
+    }
+  }
+
+  // Writes the string to a temporary file next to the specified file and
+  // then renames it, so readers never see a partially-written file.
+  inline void write_string_to_file_atomic(const std::string & filename,
+    const std::string & contents)
+  {
+    std::string temp_filename = temp_filename_for(filename);
+    {
+      std::ofstream file;
+      open_file_output(temp_filename, file);
+      file << contents;
+      file.close();
+      if (file.fail())
+      {
+        std::remove(temp_filename.c_str());
+        throw std::runtime_error("Failed to write to file.");
+      }
+    }
+
+#ifdef _WIN32
+    bool success = MoveFileExA(temp_filename.c_str(), filename.c_str(),
+      MOVEFILE_REPLACE_EXISTING);
+#else
+    bool success = std::rename(temp_filename.c_str(), filename.c_str()) == 0;
+#endif
+    if (!success)
+    {
+      std::remove(temp_filename.c_str());
+      throw std::runtime_error(filename + ": Failed to replace file.");
+    }
+  }
+
   inline void write_string_to_file_or_pipe(const std::string & filename,
     const std::string & contents)
   {
@@ -189,6 +189,52 @@ jrk_error * jrk_settings_copy(
 JRK_API
 void jrk_settings_free(jrk_settings *);
 
+/// Represents a pool of memory that settings objects can be allocated from.
+///
+/// Settings objects allocated from an arena are freed all at once when the
+/// arena is reset or freed, so it is much cheaper to create and destroy large
+/// numbers of them this way.  Calling jrk_settings_free() on a settings object
+/// from an arena does nothing, so they can be used anywhere a normal settings
+/// object can be used, as long as they are not used after the arena is reset
+/// or freed.
+typedef struct jrk_settings_arena jrk_settings_arena;
+
+/// Creates a new settings arena.
+///
+/// The arena allocates memory from the heap in blocks that hold block_capacity
+/// settings objects each.  If block_capacity is zero, a default is used.  An
+/// error is returned if block_capacity is so large that the size of a block
+/// would overflow.  The caller must free the arena later by calling
+/// jrk_settings_arena_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_arena_create(size_t block_capacity,
+  jrk_settings_arena ** arena);
+
+/// Frees all the settings objects that were allocated from the arena, but
+/// keeps some memory around so the arena can be used again.
+JRK_API
+void jrk_settings_arena_reset(jrk_settings_arena *);
+
+/// Frees the arena and all the settings objects that were allocated from it.
+/// It is OK to pass a NULL pointer to this function.
+JRK_API
+void jrk_settings_arena_free(jrk_settings_arena *);
+
+/// Like jrk_settings_create(), but allocates the settings from the specified
+/// arena.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_create_in_arena(jrk_settings_arena *,
+  jrk_settings ** settings);
+
+/// Like jrk_settings_copy(), but allocates the copy from the specified arena.
+///
+/// Note that jrk_settings_copy() always returns a normal settings object that
+/// must be freed with jrk_settings_free(), even if the source came from an
+/// arena.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_copy_in_arena(jrk_settings_arena *,
+  const jrk_settings * source, jrk_settings ** dest);
+
 /// Fixes the settings to have defaults.  Before calling this, you should
 /// specify what product the settings are for by calling
 /// jrk_settings_set_product().  If the product is not set to a valid non-zero
@@ -245,6 +291,33 @@ JRK_API JRK_WARN_UNUSED
 jrk_error * jrk_settings_read_from_string(const char * string,
   jrk_settings ** settings);
 
+/// Decodes a raw settings image into a settings object.
+///
+/// The buffer should hold JRK_SETTINGS_SIZE bytes laid out the same way as the
+/// settings in the Jrk's EEPROM, so that setting N (one of the JRK_SETTING_*
+/// macros) is at buf[N].  Byte 0 is not used.  To get a buffer like this from
+/// a device, read the settings starting at offset 1 into buf + 1 with
+/// jrk_get_eeprom_setting_segment() or jrk_get_ram_setting_segment().  Such
+/// a buffer can be saved and decoded later without a handle.
+///
+/// Some settings only exist for certain products, so you should call
+/// jrk_settings_set_product() on the settings object before calling this
+/// function.  This function does not fix the settings.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_decode(const uint8_t * buf, size_t len,
+  jrk_settings * settings);
+
+/// Encodes a settings object into a raw settings image, the inverse of
+/// jrk_settings_decode().
+///
+/// The buffer must be at least JRK_SETTINGS_SIZE bytes long.  The first
+/// JRK_SETTINGS_SIZE bytes of it are overwritten, and byte 0 is set to zero.
+/// This function does not fix the settings; you would typically call
+/// jrk_settings_fix() first.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_encode(const jrk_settings * settings,
+  uint8_t * buf, size_t len);
+
 /// Sets the product, which specifies what Jrk product these settings are for.
 /// The value should be one of the JRK_PRODUCT_* macros.
 ///
@@ -1584,6 +1657,14 @@ uint32_t jrk_settings_achievable_serial_baud_rate(const jrk_settings *, uint32_t
 /// Represents run-time variables that have been read from the jrk.
 typedef struct jrk_variables jrk_variables;
 
+/// Creates a new variables object with all variables set to zero.
+///
+/// This is typically used together with jrk_variables_decode().  If this
+/// function is successful, the caller must free the variables later by calling
+/// jrk_variables_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_variables_create(jrk_variables ** variables);
+
 /// Copies a jrk_variables object.  If this function is successful, the caller
 /// must free the settings later by calling jrk_settings_free().
 JRK_API JRK_WARN_UNUSED
@@ -1596,6 +1677,17 @@ jrk_error * jrk_variables_copy(
 JRK_API
 void jrk_variables_free(jrk_variables *);
 
+/// Decodes a raw buffer of variables into a variables object.
+///
+/// The buffer should hold at least JRK_VARIABLES_SIZE bytes, as returned by
+/// the Jrk's "Get variables" command starting at offset 0 (see
+/// jrk_get_variable_segment()).  This lets you capture raw buffers in one place
+/// and decode them later, possibly on a different thread or machine, without a
+/// handle.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_variables_decode(const uint8_t * buf, size_t len,
+  jrk_variables * variables);
+
 // Beginning of auto-generated variables getter prototypes.
 
 // Gets the input variable.
@@ -2149,6 +2241,43 @@ jrk_error * jrk_get_eeprom_settings(jrk_handle *, jrk_settings ** settings);
 JRK_API JRK_WARN_UNUSED
 jrk_error * jrk_set_eeprom_settings(jrk_handle *, const jrk_settings *);
 
+/// Like jrk_set_eeprom_settings(), but writes the settings as they are,
+/// without copying and fixing them first.
+///
+/// The caller must guarantee that the settings were already fixed for this
+/// device, typically by calling jrk_settings_fix_and_change_product() with the
+/// product and firmware version of the device.  This function returns an error
+/// if the product of the settings does not match the device.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_set_eeprom_settings_no_fix(jrk_handle *, const jrk_settings *);
+
+/// Reads the specified bytes of the EEPROM settings.
+///
+/// The index parameter specifies the address of the first byte to retrieve,
+/// and the length parameter specifies how many bytes to retrieve (at most
+/// JRK_MAX_USB_RESPONSE_SIZE).  The output parameter must point to a buffer
+/// large enough for the requested length.
+///
+/// For a higher-level version of this that just reads all the EEPROM
+/// settings, see jrk_get_eeprom_settings().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_get_eeprom_setting_segment(jrk_handle *,
+  size_t index, size_t length, uint8_t * output);
+
+/// Writes a single byte of the EEPROM settings.
+///
+/// This lets you write settings a few bytes at a time, for example to only
+/// write the bytes that differ from what is already in EEPROM, or to spread a
+/// long write out so that your program can do other things in between.  The
+/// byte is written as is, so it is up to you to make sure the settings are
+/// valid once you are done.  See jrk_settings_encode().
+///
+/// After you are done writing, call jrk_reinitialize() to make the new
+/// settings take effect.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_set_eeprom_setting_byte(jrk_handle *,
+  uint8_t address, uint8_t byte);
+
 /// Reads the jrk's RAM settings.
 ///
 /// The RAM settings are a copy of the jrk's settings that is stored
@@ -2199,6 +2328,12 @@ JRK_API JRK_WARN_UNUSED
 jrk_error * jrk_set_ram_settings(jrk_handle *,
   const jrk_settings *);
 
+/// Like jrk_set_ram_settings(), but writes the settings as they are, without
+/// copying and fixing them first.  See jrk_set_eeprom_settings_no_fix().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_set_ram_settings_no_fix(jrk_handle *,
+  const jrk_settings *);
+
 /// Reads the specified bytes of the RAM settings.
 ///
 /// See jrk_get_ram_settings() for information about what the
@@ -2330,6 +2465,763 @@ jrk_error * jrk_diagnose(
 
 #define JRK_DIAGNOSE_FLAG_FEEDBACK_WIZARD 1
 
+/// The conditions counted by jrk_diagnosis_window.  Conditions 0 through 15
+/// are the errors, numbered like the JRK_ERROR_* macros (for example,
+/// JRK_ERROR_FEEDBACK_DISCONNECT), and the rest are listed below.
+#define JRK_DIAGNOSIS_CONDITION_PID_PERIOD_EXCEEDED 16
+#define JRK_DIAGNOSIS_CONDITION_CURRENT_CHOPPING 17
+#define JRK_DIAGNOSIS_CONDITION_DEVICE_RESET 18
+#define JRK_DIAGNOSIS_CONDITION_COUNT 19
+
+/// Represents a diagnosis of problems that come and go, which jrk_diagnose()
+/// cannot see because it only looks at one sample of the variables.  It
+/// counts how many times each condition started during a sliding window of
+/// time, like the last minute:
+///
+/// - An error is counted when it is in the error_flags_occurred variable and
+///   was not stopping the motor in the previous sample.  The "Awaiting
+///   command" error is not counted.
+/// - JRK_DIAGNOSIS_CONDITION_PID_PERIOD_EXCEEDED is counted for each sample
+///   where the pid_period_exceeded variable is set.
+/// - JRK_DIAGNOSIS_CONDITION_CURRENT_CHOPPING is counted when current
+///   chopping starts.
+/// - JRK_DIAGNOSIS_CONDITION_DEVICE_RESET is counted when the up_time
+///   variable goes backwards.
+///
+/// The window is divided into 60 buckets, so each sample takes a constant
+/// amount of time and the window moves forward in steps of 1/60 of its
+/// length.
+///
+/// Every read of the variables should clear the error flags and the current
+/// chopping occurrence count, and be passed to the window.  The first sample
+/// is only used as a reference for the next one.
+typedef struct jrk_diagnosis_window jrk_diagnosis_window;
+
+/// Creates a new diagnosis window.  The window argument is the length of the
+/// window in milliseconds.  If it is zero, a default of 60000 is used.
+///
+/// The caller must free the window later with jrk_diagnosis_window_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_diagnosis_window_create(uint32_t window,
+  jrk_diagnosis_window ** diagnosis_window);
+
+/// Frees a diagnosis window.  It is OK to pass a NULL pointer to this
+/// function.
+JRK_API
+void jrk_diagnosis_window_free(jrk_diagnosis_window *);
+
+/// Forgets all samples.
+JRK_API
+void jrk_diagnosis_window_clear(jrk_diagnosis_window *);
+
+/// Adds a sample of the variables to the window.  The time argument is the
+/// time when the variables were read, in milliseconds.
+JRK_API
+void jrk_diagnosis_window_add_sample(jrk_diagnosis_window *,
+  const jrk_variables *, uint64_t time);
+
+/// Gets the number of times a condition was counted in the window.
+/// See JRK_DIAGNOSIS_CONDITION_COUNT.
+JRK_API
+uint32_t jrk_diagnosis_window_get_count(const jrk_diagnosis_window *,
+  uint8_t condition);
+
+/// Gets the findings of the window as a string, with one sentence per line
+/// for each condition that was counted, such as "Feedback disconnect 14
+/// times in the last 60 s."  The most frequent conditions come first.  The
+/// string is empty if nothing was counted.
+///
+/// If this function is successful, the string must be freed by the caller
+/// using jrk_string_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_diagnosis_window_get_findings(const jrk_diagnosis_window *,
+  char ** findings);
+
+/// Looks up a user-friendly name for a condition counted by
+/// jrk_diagnosis_window.
+JRK_API
+const char * jrk_look_up_diagnosis_condition_name_ui(uint8_t condition);
+
+
+//// Settings drift monitoring //////////////////////////////////////////////////
+
+/// Represents a monitor that periodically checks the settings of one or more
+/// Jrks to see if they have drifted away from what they should be.
+///
+/// Each call to jrk_settings_monitor_step() only reads a small window of the
+/// EEPROM and RAM settings of a device, and the next call for the same device
+/// reads the next window, so the cost of checking all the settings is spread
+/// out over several steps.  The monitor keeps its state for each device by
+/// serial number.
+typedef struct jrk_settings_monitor jrk_settings_monitor;
+
+/// Creates a new settings monitor.
+///
+/// The window_size argument is the number of bytes of settings that each step
+/// reads from EEPROM and from RAM.  If it is zero, a default of 16 bytes is
+/// used.  The maximum is JRK_MAX_USB_RESPONSE_SIZE, in which case each step
+/// checks all of the settings.
+///
+/// The caller must free the monitor later with jrk_settings_monitor_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_monitor_create(size_t window_size,
+  jrk_settings_monitor ** monitor);
+
+/// Frees a settings monitor.  It is OK to pass a NULL pointer to this
+/// function.
+JRK_API
+void jrk_settings_monitor_free(jrk_settings_monitor *);
+
+/// Sets the golden settings for the device with the specified serial number.
+///
+/// The monitor keeps a copy of the settings in the same form as they are
+/// stored in the device's EEPROM, so the caller can free the settings after
+/// this function returns.  The settings should already be fixed (see
+/// jrk_settings_fix_and_change_product()), or else the monitor will report
+/// drift for every setting that was changed when the settings were written.
+///
+/// Pass NULL for the golden settings to stop comparing the EEPROM of that
+/// device to golden settings.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_monitor_set_golden(jrk_settings_monitor *,
+  const char * serial_number, const jrk_settings * golden);
+
+/// Checks the next window of settings on the specified device.
+///
+/// The EEPROM settings in the window are compared to the golden settings for
+/// the device (if any were set with jrk_settings_monitor_set_golden()), and
+/// the RAM settings in the window are compared to the EEPROM settings.
+///
+/// The report argument is an optional pointer to pointer to a string.  If it
+/// is supplied and this function is successful, the function will return a
+/// string with one line for each setting that differs, or an empty string if
+/// there were no differences.  The line says which comparison failed and gives
+/// the name of the setting as it appears in settings files.  The string must
+/// be freed by the caller using jrk_string_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_settings_monitor_step(jrk_settings_monitor *,
+  jrk_handle *, char ** report);
+
+/// Returns the number of calls to jrk_settings_monitor_step() needed to check
+/// all of the settings of a device once.
+JRK_API
+size_t jrk_settings_monitor_get_steps_per_pass(const jrk_settings_monitor *);
+
+
+//// Usage accounting //////////////////////////////////////////////////////////
+
+/// The number of duty cycle bands tracked by jrk_usage.  Band N covers duty
+/// cycle magnitudes from N*60 up to (N+1)*60 (i.e. N*10% up to (N+1)*10%),
+/// and the last band includes 600 (100%).
+#define JRK_USAGE_DUTY_CYCLE_BAND_COUNT 10
+
+/// The longest interval between two samples, in milliseconds, that
+/// jrk_usage_add_sample() will count.  A longer interval means that nobody
+/// was watching the device, so the interval is skipped.
+#define JRK_USAGE_MAX_INTERVAL 1000
+
+/// Represents the accumulated usage of the motor on one Jrk: how long it
+/// was driven, how much energy and charge it used, how long it spent at its
+/// current limit, and how long it spent in each duty cycle band.
+///
+/// The totals are updated by jrk_usage_add_sample() from each set of
+/// variables as they are read, at a constant cost per sample, so there is no
+/// need to keep logs to compute them later.  Each interval between two
+/// samples is counted using the values from the earlier sample.  The usage
+/// can be saved with jrk_usage_to_string() and loaded again with
+/// jrk_usage_read_from_string(), so it can keep accumulating across runs.
+typedef struct jrk_usage jrk_usage;
+
+/// Creates a new usage object with all totals at zero for the device with
+/// the specified serial number.
+///
+/// The caller must free the object later with jrk_usage_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_usage_create(const char * serial_number, jrk_usage ** usage);
+
+/// Copies a usage object.  If this function is successful, the caller must
+/// free the copy later with jrk_usage_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_usage_copy(const jrk_usage * source, jrk_usage ** dest);
+
+/// Frees a usage object.  It is OK to pass a NULL pointer to this function.
+JRK_API
+void jrk_usage_free(jrk_usage *);
+
+/// Gets the serial number of the device the usage belongs to.
+JRK_API
+const char * jrk_usage_get_serial_number(const jrk_usage *);
+
+/// Adds a sample of the variables of the device to the totals.
+///
+/// The time argument is the time when the variables were read, in
+/// milliseconds, from a clock on the computer that does not go backwards
+/// (the Jrk's up time is not suitable because it resets with the device).
+/// The variables should include the error_flags_halting, vin_voltage,
+/// current, duty_cycle, and current_chopping_consecutive_count variables.
+JRK_API
+void jrk_usage_add_sample(jrk_usage *, const jrk_variables *, uint64_t time);
+
+/// Makes the next call to jrk_usage_add_sample() start a new series of
+/// samples instead of counting the interval since the last sample.  Call this
+/// if you lose contact with the device.
+JRK_API
+void jrk_usage_interrupt(jrk_usage *);
+
+/// Gets the total time covered by the samples, in milliseconds.
+JRK_API
+uint64_t jrk_usage_get_monitored_time(const jrk_usage *);
+
+/// Gets the time the motor was driven with a non-zero duty cycle, in
+/// milliseconds.
+JRK_API
+uint64_t jrk_usage_get_run_time(const jrk_usage *);
+
+/// Gets the time the motor spent at its current limit, in milliseconds.  This
+/// is the time during which current chopping was active or the soft
+/// overcurrent error was stopping the motor.
+JRK_API
+uint64_t jrk_usage_get_current_limit_time(const jrk_usage *);
+
+/// Gets the time the duty cycle spent in the specified band, in milliseconds.
+/// See JRK_USAGE_DUTY_CYCLE_BAND_COUNT.
+JRK_API
+uint64_t jrk_usage_get_duty_cycle_band_time(const jrk_usage *, uint8_t band);
+
+/// Gets the energy delivered to the Jrk's VIN pin while driving the motor, in
+/// microjoules, computed from the VIN voltage and the motor current.
+JRK_API
+uint64_t jrk_usage_get_energy(const jrk_usage *);
+
+/// Gets the charge that went through the motor, in microcoulombs.  Divide by
+/// 3600000000 to get amp-hours.
+JRK_API
+uint64_t jrk_usage_get_charge(const jrk_usage *);
+
+/// Gets the totals as a string, also known as a usage file.  If this function
+/// is successful, the string must be freed by the caller using
+/// jrk_string_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_usage_to_string(const jrk_usage *, char ** string);
+
+/// Parses a usage file and returns a new usage object with the totals from
+/// it.  The caller must free the object later with jrk_usage_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_usage_read_from_string(const char * string,
+  jrk_usage ** usage);
+
+
+//// Anomaly detection /////////////////////////////////////////////////////////
+
+/// The channels watched by jrk_anomaly_detector.  The alerts returned by
+/// jrk_anomaly_detector_add_sample() have bit (1 << N) set for channel N.
+
+/// The VIN voltage, in millivolts.  An alert usually means the supply sagged.
+#define JRK_ANOMALY_CHANNEL_VIN_VOLTAGE 0
+
+/// The motor current, in milliamps.
+#define JRK_ANOMALY_CHANNEL_CURRENT 1
+
+/// The error (scaled feedback minus target).
+#define JRK_ANOMALY_CHANNEL_ERROR 2
+
+/// The second difference of the feedback between samples, which is zero
+/// while the feedback is steady or changing at a constant rate.
+#define JRK_ANOMALY_CHANNEL_FEEDBACK_NOISE 3
+
+/// The difference between the current and a linear fit of the current
+/// against the duty cycle magnitude.  An alert usually means the load
+/// changed, for example because friction rose.
+#define JRK_ANOMALY_CHANNEL_CURRENT_RESIDUAL 4
+
+/// The number of channels.
+#define JRK_ANOMALY_CHANNEL_COUNT 5
+
+/// Represents a detector that watches the variables of one Jrk for values
+/// that are unusual compared to its recent behavior.
+///
+/// For each channel, the detector keeps an exponentially-weighted moving
+/// average (EWMA) and variance, and computes the z-score of each new value
+/// against them.  For the current residual channel, it learns a linear fit
+/// of the current against the duty cycle magnitude over the learning period,
+/// and then computes the z-score of an EWMA of the residuals, so it detects
+/// a drift away from the fit.  The learning period for the fit lasts until
+/// the duty cycle magnitude has varied enough (a standard deviation of at
+/// least 30) to give the fit a meaningful slope, so the current residual
+/// channel does not raise alerts while the motor has only been idle.
+///
+/// The detector takes a constant amount of memory and a constant amount of
+/// time per sample, and it does not keep any of the samples.
+typedef struct jrk_anomaly_detector jrk_anomaly_detector;
+
+/// Creates a new anomaly detector.
+///
+/// The caller must free the detector later with jrk_anomaly_detector_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_anomaly_detector_create(jrk_anomaly_detector ** detector);
+
+/// Frees an anomaly detector.  It is OK to pass a NULL pointer to this
+/// function.
+JRK_API
+void jrk_anomaly_detector_free(jrk_anomaly_detector *);
+
+/// Sets the time constant of the moving averages, in samples.  The weight of
+/// each new sample is 1/samples.  The default is 64.
+JRK_API
+void jrk_anomaly_detector_set_time_constant(jrk_anomaly_detector *,
+  uint32_t samples);
+
+/// Sets how large the magnitude of a z-score has to be to raise an alert.
+/// The default is 4.
+JRK_API
+void jrk_anomaly_detector_set_threshold(jrk_anomaly_detector *,
+  double threshold);
+
+/// Sets the number of samples the detector learns from before it raises
+/// alerts, which is also the minimum number of samples used for the current
+/// fit.
+/// The default is 1200 (one minute at 20 samples per second).  This only
+/// affects learning that has not finished yet.
+JRK_API
+void jrk_anomaly_detector_set_learning_samples(jrk_anomaly_detector *,
+  uint32_t samples);
+
+/// Sets the smallest standard deviation used to compute z-scores for the
+/// specified channel, in the units of the channel.  This keeps a channel that
+/// was perfectly steady while learning from raising an alert for every small
+/// change.  Pass 0 to use the default for the channel.
+JRK_API
+void jrk_anomaly_detector_set_min_std_dev(jrk_anomaly_detector *,
+  uint8_t channel, double min_std_dev);
+
+/// Forgets everything the detector learned so it starts learning again.  Call
+/// this after you intentionally change the system, such as by changing the
+/// settings or the load.
+JRK_API
+void jrk_anomaly_detector_restart(jrk_anomaly_detector *);
+
+/// Adds a sample of the variables to the detector and returns the channels
+/// that are raising alerts for that sample (bit N is channel N).
+JRK_API
+uint32_t jrk_anomaly_detector_add_sample(jrk_anomaly_detector *,
+  const jrk_variables *);
+
+/// Gets the moving average of a channel.
+JRK_API
+double jrk_anomaly_detector_get_mean(const jrk_anomaly_detector *,
+  uint8_t channel);
+
+/// Gets the standard deviation of a channel: the square root of its moving
+/// variance, or for the current residual channel, of the residual variance
+/// over the learning period.
+JRK_API
+double jrk_anomaly_detector_get_std_dev(const jrk_anomaly_detector *,
+  uint8_t channel);
+
+/// Gets the z-score of the last sample of a channel.
+JRK_API
+double jrk_anomaly_detector_get_z_score(const jrk_anomaly_detector *,
+  uint8_t channel);
+
+/// Gets the learned fit of the current in milliamps against the duty cycle
+/// magnitude (0 to 600).  Returns false (and sets the outputs to zero) if the
+/// detector is still learning.  Either output pointer can be NULL.
+JRK_API
+bool jrk_anomaly_detector_get_fit(const jrk_anomaly_detector *,
+  double * slope, double * intercept);
+
+/// Looks up the name of an anomaly channel, e.g. "vin_voltage".  Returns an
+/// empty string if the channel is not valid.
+JRK_API
+const char * jrk_look_up_anomaly_channel_name(uint8_t channel);
+
+
+//// Current chopping episodes /////////////////////////////////////////////////
+
+/// The number of bins in the duration histogram of jrk_chopping_tracker.
+/// Bin N counts episodes that lasted from 2^N up to 2^(N+1) - 1 PID periods,
+/// and the last bin also counts all longer episodes.
+#define JRK_CHOPPING_DURATION_BIN_COUNT 12
+
+/// The number of bins in the duty cycle histogram of jrk_chopping_tracker.
+/// Bin N counts episodes where the magnitude of the duty cycle was from
+/// N*10% up to (N+1)*10%, and the last bin includes 100%.
+#define JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT 10
+
+/// The episode started and ended between two samples, so its start time is
+/// the time of the earlier sample and its other values come from the later
+/// sample.  It might actually have been several short episodes.
+#define JRK_CHOPPING_EPISODE_FLAG_BETWEEN_SAMPLES 1
+
+/// The consecutive count was already at its maximum when the episode was
+/// first seen, so it started earlier than the start time says.
+#define JRK_CHOPPING_EPISODE_FLAG_STARTED_EARLIER 2
+
+/// Describes one episode of current chopping: a run of consecutive PID
+/// periods in which the Jrk's hardware current limit was chopping the motor
+/// current.
+typedef struct jrk_chopping_episode
+{
+  /// The time the episode started, in milliseconds, on the same clock as the
+  /// times passed to jrk_chopping_tracker_add_sample().  This is estimated
+  /// from the consecutive count and the PID period.
+  uint64_t start_time;
+
+  /// The length of the episode in PID periods.
+  uint32_t duration;
+
+  /// The highest raw_current and current (in milliamps) variables seen
+  /// during the episode.
+  uint16_t peak_raw_current;
+  uint16_t peak_current;
+
+  /// The duty cycle when the episode was first seen.
+  int16_t duty_cycle;
+
+  /// A combination of the JRK_CHOPPING_EPISODE_FLAG_* macros.
+  uint8_t flags;
+} jrk_chopping_episode;
+
+/// Represents a tracker that reconstructs current chopping episodes from the
+/// current_chopping_consecutive_count and
+/// current_chopping_occurrence_count variables of one Jrk.
+///
+/// The tracker keeps a log of the most recent episodes, a histogram of
+/// episode durations, and a histogram of the duty cycles the episodes
+/// happened at.  Each sample takes a constant amount of time.
+///
+/// To get accurate results, every read of the variables must clear the
+/// occurrence count (JRK_GET_VARIABLES_FLAG_CLEAR_CURRENT_CHOPPING_OCCURRENCE_COUNT)
+/// and be passed to the tracker, and the variables should be read more
+/// often than every 255 PID periods, because the counters stop at 255.
+typedef struct jrk_chopping_tracker jrk_chopping_tracker;
+
+/// Creates a new current chopping tracker.
+///
+/// The log_capacity argument is the number of episodes to keep in the log.
+/// If it is zero, a default of 256 is used.  Older episodes are dropped from
+/// the log, but are still counted in the histograms.
+///
+/// The caller must free the tracker later with jrk_chopping_tracker_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_chopping_tracker_create(size_t log_capacity,
+  jrk_chopping_tracker ** tracker);
+
+/// Frees a current chopping tracker.  It is OK to pass a NULL pointer to this
+/// function.
+JRK_API
+void jrk_chopping_tracker_free(jrk_chopping_tracker *);
+
+/// Sets the PID period of the device in milliseconds (see
+/// jrk_settings_get_pid_period()), which is used to estimate when episodes
+/// started.  The default is 10.
+JRK_API
+void jrk_chopping_tracker_set_pid_period(jrk_chopping_tracker *,
+  uint16_t pid_period);
+
+/// Forgets all episodes and clears the histograms.
+JRK_API
+void jrk_chopping_tracker_clear(jrk_chopping_tracker *);
+
+/// Adds a sample of the variables to the tracker.  The time argument is the
+/// time when the variables were read, in milliseconds.
+JRK_API
+void jrk_chopping_tracker_add_sample(jrk_chopping_tracker *,
+  const jrk_variables *, uint64_t time);
+
+/// Returns true if an episode was still going on at the last sample.  Such
+/// an episode is not in the log or histograms yet.
+JRK_API
+bool jrk_chopping_tracker_is_chopping(const jrk_chopping_tracker *);
+
+/// Gets the number of episodes that have ended since the tracker was created
+/// or cleared.
+JRK_API
+uint32_t jrk_chopping_tracker_get_episode_count(const jrk_chopping_tracker *);
+
+/// Gets the total duration of the episodes that have ended, in PID periods.
+JRK_API
+uint64_t jrk_chopping_tracker_get_total_duration(
+  const jrk_chopping_tracker *);
+
+/// Gets the number of episodes in the log.
+JRK_API
+size_t jrk_chopping_tracker_get_log_size(const jrk_chopping_tracker *);
+
+/// Gets an episode from the log.  Index 0 is the oldest episode.  Returns
+/// false if the index is out of range.
+JRK_API
+bool jrk_chopping_tracker_get_episode(const jrk_chopping_tracker *,
+  size_t index, jrk_chopping_episode * episode);
+
+/// Gets a bin of the duration histogram.
+/// See JRK_CHOPPING_DURATION_BIN_COUNT.
+JRK_API
+uint32_t jrk_chopping_tracker_get_duration_histogram(
+  const jrk_chopping_tracker *, uint8_t bin);
+
+/// Gets a bin of the duty cycle histogram.
+/// See JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT.
+JRK_API
+uint32_t jrk_chopping_tracker_get_duty_cycle_histogram(
+  const jrk_chopping_tracker *, uint8_t bin);
+
+/// Gets the histograms and the log as a string: a short summary followed by
+/// one CSV line per episode.  If this function is successful, the string must
+/// be freed by the caller using jrk_string_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_chopping_tracker_to_string(const jrk_chopping_tracker *,
+  char ** string);
+
+
+//// Adaptive polling //////////////////////////////////////////////////////////
+
+/// Represents a scheduler that decides when to read the variables of each of
+/// several Jrks, so that axes that are moving get read often and axes that
+/// are idle do not use up the bandwidth of the USB bus.
+///
+/// A device is considered active when its target changes, its error or duty
+/// cycle changes by more than the deadband, its error_flags_halting variable
+/// changes, or an error other than "Awaiting command" occurred.  Active
+/// devices are read at the minimum period.  Each sample from a device that is
+/// not active doubles its period, up to the maximum period.
+///
+/// If reading every device at its period would take more reads per second
+/// than the budget, the periods are stretched so that the total stays within
+/// the budget.  Each device still gets read at the maximum period if the
+/// budget allows it, and the rest of the budget is shared by the devices that
+/// want to be read faster than that.
+///
+/// Devices are identified by their index, from 0 to one less than the
+/// number of devices.  Every read should clear the error_flags_occurred
+/// variable (JRK_GET_VARIABLES_FLAG_CLEAR_ERROR_FLAGS_OCCURRED), or else the
+/// device will look active all the time.
+typedef struct jrk_poll_scheduler jrk_poll_scheduler;
+
+/// Creates a new poll scheduler for the specified number of devices.
+/// Every device starts at the minimum period and is due right away.
+///
+/// The caller must free the scheduler later with jrk_poll_scheduler_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_poll_scheduler_create(size_t device_count,
+  jrk_poll_scheduler ** scheduler);
+
+/// Frees a poll scheduler.  It is OK to pass a NULL pointer to this function.
+JRK_API
+void jrk_poll_scheduler_free(jrk_poll_scheduler *);
+
+/// Sets the shortest and longest periods between reads of a device, in
+/// milliseconds.  A value of zero selects the default: 10 ms for the minimum
+/// and 500 ms for the maximum.
+JRK_API
+void jrk_poll_scheduler_set_period_range(jrk_poll_scheduler *,
+  uint32_t min_period, uint32_t max_period);
+
+/// Sets the maximum total number of reads per second for all devices.  Zero
+/// means there is no limit.  The default is 200.
+JRK_API
+void jrk_poll_scheduler_set_budget(jrk_poll_scheduler *, uint32_t budget);
+
+/// Sets how much the error and duty cycle can change between two samples
+/// without the device being considered active.  The default is 2.
+JRK_API
+void jrk_poll_scheduler_set_deadband(jrk_poll_scheduler *, uint16_t deadband);
+
+/// Returns the index of the device that should be read next, and writes the
+/// time it should be read, in milliseconds, to the optional due pointer.
+JRK_API
+size_t jrk_poll_scheduler_next(const jrk_poll_scheduler *, uint64_t * due);
+
+/// Tells the scheduler that a device was read at the specified time, in
+/// milliseconds, and schedules its next read.  Pass NULL for the variables if
+/// the read failed; the device will be read again after the maximum period.
+JRK_API
+void jrk_poll_scheduler_add_sample(jrk_poll_scheduler *, size_t index,
+  const jrk_variables *, uint64_t time);
+
+/// Gets the current period of a device in milliseconds, including any
+/// stretching needed to stay within the budget.
+JRK_API
+uint32_t jrk_poll_scheduler_get_period(const jrk_poll_scheduler *,
+  size_t index);
+
+/// Gets the total number of reads per second that the scheduler is currently
+/// asking for.
+JRK_API
+double jrk_poll_scheduler_get_rate(const jrk_poll_scheduler *);
+
+
+//// Multi-drop serial bus /////////////////////////////////////////////////////
+
+/// Use 14-bit device numbers in the Pololu protocol.  This must match the
+/// serial_enable_14bit_device_number setting of every Jrk on the bus.
+#define JRK_SERIAL_BUS_FLAG_14BIT_DEVICE_NUMBER 1
+
+/// Add a CRC byte to every command.  This must match the serial_enable_crc
+/// setting of every Jrk on the bus.
+#define JRK_SERIAL_BUS_FLAG_CRC 2
+
+/// Statistics for one device on a jrk_serial_bus.
+typedef struct jrk_serial_bus_device_stats
+{
+  /// The number of variable reads sent to the device.
+  uint32_t reads;
+
+  /// The number of complete, valid responses received.
+  uint32_t responses;
+
+  /// The number of reads that got no complete response in time.
+  uint32_t timeouts;
+
+  /// The number of responses dropped because more bytes arrived right after
+  /// them, which means they could not be matched to the device reliably.
+  uint32_t bad_responses;
+
+  /// The number of timeouts since the last valid response.
+  uint32_t consecutive_timeouts;
+} jrk_serial_bus_device_stats;
+
+/// Represents a scheduler for several Jrks that share one serial line, such
+/// as an RS-485 bus, with the serial mode set to UART and a different
+/// serial_device_number for each Jrk.
+///
+/// The scheduler does not open the serial port itself.  Instead, the caller
+/// calls jrk_serial_bus_get_output() to get bytes to write to the port and
+/// passes the bytes it reads from the port to
+/// jrk_serial_bus_handle_input().  This way the scheduler works with any
+/// serial port library.
+///
+/// Each burst of output has the pending stop and target commands for all
+/// devices, which do not get responses, followed by one "Get variables"
+/// command.  The next burst is held back until the response arrives or
+/// times out, since only one device can answer at a time.  Variable reads go
+/// to each device in turn.  A device that times out repeatedly is only read
+/// once in a while so that it does not use up the line.
+///
+/// The Jrk does not add a CRC or its device number to its responses, so the
+/// only way to tell which device a response came from is that it answers the
+/// one read that is outstanding.  To keep a late response from being taken
+/// as the response to the next read, the scheduler waits for the line to be
+/// quiet for a turnaround time (see jrk_serial_bus_set_turnaround()) before
+/// each burst.  After a read times out, it waits for the timeout plus the
+/// turnaround time, and bytes that arrive in that time are discarded and
+/// restart the wait.  A response is only accepted once the line has been
+/// quiet for the turnaround time after it; if more bytes arrive first, the
+/// response is dropped and counted in bad_responses.
+///
+/// All times are in milliseconds, on any clock the caller likes.
+typedef struct jrk_serial_bus jrk_serial_bus;
+
+/// Creates a new serial bus scheduler.
+///
+/// The baud_rate argument is the baud rate of the line, which is used to
+/// compute timeouts and utilization.  The flags argument is a combination of
+/// the JRK_SERIAL_BUS_FLAG_* macros.
+///
+/// The caller must free the bus later with jrk_serial_bus_free().
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_serial_bus_create(uint32_t baud_rate, uint32_t flags,
+  jrk_serial_bus ** bus);
+
+/// Frees a serial bus scheduler.  It is OK to pass a NULL pointer to this
+/// function.
+JRK_API
+void jrk_serial_bus_free(jrk_serial_bus *);
+
+/// Adds a device with the specified serial device number to the bus.  The
+/// index of the device, which is used to identify it in the other
+/// functions, is written to the optional index pointer.  Devices are
+/// numbered from 0 in the order they were added.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_serial_bus_add_device(jrk_serial_bus *,
+  uint16_t device_number, size_t * index);
+
+/// Gets the number of devices on the bus.
+JRK_API
+size_t jrk_serial_bus_get_device_count(const jrk_serial_bus *);
+
+/// Sets how long to wait for a response after the response should have been
+/// transmitted, in milliseconds.  The default is 20.  This should be longer
+/// than the serial_response_delay of the devices plus any latency in the
+/// serial port.
+JRK_API
+void jrk_serial_bus_set_timeout(jrk_serial_bus *, uint32_t timeout);
+
+/// Sets how long the line must be quiet before the next burst is sent, in
+/// milliseconds.  The default is 3.  This should be longer than the time
+/// between bytes of one response, including any latency in the serial port.
+JRK_API
+void jrk_serial_bus_set_turnaround(jrk_serial_bus *, uint32_t turnaround);
+
+/// Sets the segment of the variables that each read gets, as an offset and a
+/// length like the arguments of jrk_get_variable_segment().  The length can
+/// be at most 15.  The default is the first 15 bytes, which include the
+/// input, target, feedback, scaled feedback, integral, duty cycle target,
+/// duty cycle, and current (low resolution) variables.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_serial_bus_set_read_segment(jrk_serial_bus *,
+  uint8_t offset, uint8_t length);
+
+/// Sets the target of a device.  The command goes out in the next burst.  If
+/// the target is set again before then, only the newest target is sent.
+JRK_API
+void jrk_serial_bus_set_target(jrk_serial_bus *, size_t index,
+  uint16_t target);
+
+/// Stops the motor of a device.  Stop commands go out before all other
+/// commands in the next burst, and cancel any target that has not been sent
+/// yet for the device.
+JRK_API
+void jrk_serial_bus_stop_motor(jrk_serial_bus *, size_t index);
+
+/// Gets the next burst of bytes to write to the serial port, and returns how
+/// many bytes were written to the buffer.  Returns 0 while waiting for a
+/// response or for the line to be quiet.  The buffer should be able to hold
+/// at least 7 bytes per device.  If it is smaller, the remaining commands are
+/// sent in later bursts.
+JRK_API
+size_t jrk_serial_bus_get_output(jrk_serial_bus *, uint64_t time,
+  uint8_t * buf, size_t size);
+
+/// Handles bytes that were read from the serial port.
+JRK_API
+void jrk_serial_bus_handle_input(jrk_serial_bus *, uint64_t time,
+  const uint8_t * buf, size_t size);
+
+/// Returns true if the bus is waiting for a response or for the line to be
+/// quiet, and writes the time when the wait will end (if no more bytes
+/// arrive) to the optional deadline pointer.  The caller can use this to
+/// decide how long to wait for input from the serial port.
+JRK_API
+bool jrk_serial_bus_is_waiting(const jrk_serial_bus *, uint64_t * deadline);
+
+/// Decodes the variables read so far from a device.  Variables outside of
+/// the read segment are zero.
+JRK_API JRK_WARN_UNUSED
+jrk_error * jrk_serial_bus_get_variables(const jrk_serial_bus *,
+  size_t index, jrk_variables * vars);
+
+/// Gets the time of the last valid response from a device, or 0 if there was
+/// none.
+JRK_API
+uint64_t jrk_serial_bus_get_update_time(const jrk_serial_bus *, size_t index);
+
+/// Gets the statistics for a device.  Returns false if the index is out of
+/// range.
+JRK_API
+bool jrk_serial_bus_get_device_stats(const jrk_serial_bus *, size_t index,
+  jrk_serial_bus_device_stats * stats);
+
+/// Gets the fraction of time the line was busy since the first call to
+/// jrk_serial_bus_get_output(), counting both directions and 10 bits per
+/// byte.  A value near 1 means the line is being driven at its capacity.
+JRK_API
+double jrk_serial_bus_get_utilization(const jrk_serial_bus *, uint64_t time);
+
+/// Gets the number of bytes received when no response was expected.
+JRK_API
+uint64_t jrk_serial_bus_get_unexpected_byte_count(const jrk_serial_bus *);
+
 #ifdef __cplusplus
 }
 #endif
@@ -70,6 +70,62 @@ namespace jrk
     return copy;
   }
 
+  /// Wrapper for jrk_settings_arena_free().
+  inline void pointer_free(jrk_settings_arena * p) noexcept
+  {
+    jrk_settings_arena_free(p);
+  }
+
+  /// Wrapper for jrk_settings_monitor_free().
+  inline void pointer_free(jrk_settings_monitor * p) noexcept
+  {
+    jrk_settings_monitor_free(p);
+  }
+
+  /// Wrapper for jrk_anomaly_detector_free().
+  inline void pointer_free(jrk_anomaly_detector * p) noexcept
+  {
+    jrk_anomaly_detector_free(p);
+  }
+
+  /// Wrapper for jrk_chopping_tracker_free().
+  inline void pointer_free(jrk_chopping_tracker * p) noexcept
+  {
+    jrk_chopping_tracker_free(p);
+  }
+
+  /// Wrapper for jrk_diagnosis_window_free().
+  inline void pointer_free(jrk_diagnosis_window * p) noexcept
+  {
+    jrk_diagnosis_window_free(p);
+  }
+
+  /// Wrapper for jrk_poll_scheduler_free().
+  inline void pointer_free(jrk_poll_scheduler * p) noexcept
+  {
+    jrk_poll_scheduler_free(p);
+  }
+
+  /// Wrapper for jrk_serial_bus_free().
+  inline void pointer_free(jrk_serial_bus * p) noexcept
+  {
+    jrk_serial_bus_free(p);
+  }
+
+  /// Wrapper for jrk_usage_free().
+  inline void pointer_free(jrk_usage * p) noexcept
+  {
+    jrk_usage_free(p);
+  }
+
+  /// Wrapper for jrk_usage_copy().
+  inline jrk_usage * pointer_copy(const jrk_usage * p)
+  {
+    jrk_usage * copy;
+    throw_if_needed(jrk_usage_copy(p, &copy));
+    return copy;
+  }
+
   /// Wrapper for jrk_device_free().
   inline void pointer_free(jrk_device * p) noexcept
   {
@@ -249,6 +305,1914 @@ namespace jrk
   }
   /// \endcond
 
+  /// \cond
+  namespace field_detail
+  {
+    inline uint16_t read_uint16_t(const uint8_t * p) noexcept
+    {
+      return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    inline int16_t read_int16_t(const uint8_t * p) noexcept
+    {
+      return static_cast<int16_t>(read_uint16_t(p));
+    }
+
+    inline uint32_t read_uint32_t(const uint8_t * p) noexcept
+    {
+      return static_cast<uint32_t>(p[0]) |
+        (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) |
+        (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    inline void write_uint16_t(uint8_t * p, uint16_t value) noexcept
+    {
+      p[0] = static_cast<uint8_t>(value);
+      p[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    inline void write_int16_t(uint8_t * p, int16_t value) noexcept
+    {
+      write_uint16_t(p, static_cast<uint16_t>(value));
+    }
+  }
+  /// \endcond
+
+  /// Compile-time descriptors for the settings stored in a settings image
+  /// (see settings_image).
+  ///
+  /// Each descriptor is an empty struct with a \c type typedef and static
+  /// functions: name(), address(), applies_to(product), and inline read() and
+  /// write() functions that access a raw image in the same way as
+  /// jrk_settings_decode() and jrk_settings_encode().  Settings that are
+  /// stored in different units than the C API uses (like serial_baud_rate)
+  /// are converted by read() and write(), so they use the same units as the
+  /// corresponding jrk_settings_get_*() functions.
+  namespace field
+  {
+    // Beginning of auto-generated settings C++ field descriptors.
+
+    /// Describes the input_mode setting.
+    struct input_mode
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "input_mode"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_MODE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_INPUT_MODE]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_INPUT_MODE] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the input_error_minimum setting.
+    struct input_error_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_error_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_ERROR_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_ERROR_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_ERROR_MINIMUM, value);
+      }
+    };
+
+    /// Describes the input_error_maximum setting.
+    struct input_error_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_error_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_ERROR_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_ERROR_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_ERROR_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the input_minimum setting.
+    struct input_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_MINIMUM, value);
+      }
+    };
+
+    /// Describes the input_maximum setting.
+    struct input_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the input_neutral_minimum setting.
+    struct input_neutral_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_neutral_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_NEUTRAL_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_NEUTRAL_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_NEUTRAL_MINIMUM, value);
+      }
+    };
+
+    /// Describes the input_neutral_maximum setting.
+    struct input_neutral_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input_neutral_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_NEUTRAL_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INPUT_NEUTRAL_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INPUT_NEUTRAL_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the output_minimum setting.
+    struct output_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "output_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OUTPUT_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_OUTPUT_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_OUTPUT_MINIMUM, value);
+      }
+    };
+
+    /// Describes the output_neutral setting.
+    struct output_neutral
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "output_neutral"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OUTPUT_NEUTRAL; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_OUTPUT_NEUTRAL);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_OUTPUT_NEUTRAL, value);
+      }
+    };
+
+    /// Describes the output_maximum setting.
+    struct output_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "output_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OUTPUT_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_OUTPUT_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_OUTPUT_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the input_invert setting.
+    struct input_invert
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "input_invert"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_INPUT_INVERT & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_INPUT_INVERT);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_INPUT_INVERT) & mask));
+      }
+    };
+
+    /// Describes the input_scaling_degree setting.
+    struct input_scaling_degree
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "input_scaling_degree"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_SCALING_DEGREE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_INPUT_SCALING_DEGREE]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_INPUT_SCALING_DEGREE] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the input_detect_disconnect setting.
+    struct input_detect_disconnect
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "input_detect_disconnect"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_INPUT_DETECT_DISCONNECT & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_INPUT_DETECT_DISCONNECT);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_INPUT_DETECT_DISCONNECT) & mask));
+      }
+    };
+
+    /// Describes the input_analog_samples_exponent setting.
+    struct input_analog_samples_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "input_analog_samples_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INPUT_ANALOG_SAMPLES_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_INPUT_ANALOG_SAMPLES_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_INPUT_ANALOG_SAMPLES_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the feedback_mode setting.
+    struct feedback_mode
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "feedback_mode"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_MODE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FEEDBACK_MODE]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FEEDBACK_MODE] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the feedback_error_minimum setting.
+    struct feedback_error_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "feedback_error_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_ERROR_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_FEEDBACK_ERROR_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_FEEDBACK_ERROR_MINIMUM, value);
+      }
+    };
+
+    /// Describes the feedback_error_maximum setting.
+    struct feedback_error_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "feedback_error_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_ERROR_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_FEEDBACK_ERROR_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_FEEDBACK_ERROR_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the feedback_minimum setting.
+    struct feedback_minimum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "feedback_minimum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_MINIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_FEEDBACK_MINIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_FEEDBACK_MINIMUM, value);
+      }
+    };
+
+    /// Describes the feedback_maximum setting.
+    struct feedback_maximum
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "feedback_maximum"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_MAXIMUM; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_FEEDBACK_MAXIMUM);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_FEEDBACK_MAXIMUM, value);
+      }
+    };
+
+    /// Describes the feedback_invert setting.
+    struct feedback_invert
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "feedback_invert"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_FEEDBACK_INVERT & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_FEEDBACK_INVERT);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_FEEDBACK_INVERT) & mask));
+      }
+    };
+
+    /// Describes the feedback_detect_disconnect setting.
+    struct feedback_detect_disconnect
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "feedback_detect_disconnect"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_FEEDBACK_DETECT_DISCONNECT & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_FEEDBACK_DETECT_DISCONNECT);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_FEEDBACK_DETECT_DISCONNECT) & mask));
+      }
+    };
+
+    /// Describes the feedback_dead_zone setting.
+    struct feedback_dead_zone
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "feedback_dead_zone"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_DEAD_ZONE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FEEDBACK_DEAD_ZONE]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FEEDBACK_DEAD_ZONE] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the feedback_analog_samples_exponent setting.
+    struct feedback_analog_samples_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "feedback_analog_samples_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FEEDBACK_ANALOG_SAMPLES_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FEEDBACK_ANALOG_SAMPLES_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FEEDBACK_ANALOG_SAMPLES_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the feedback_wraparound setting.
+    struct feedback_wraparound
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "feedback_wraparound"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_FEEDBACK_WRAPAROUND & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_FEEDBACK_WRAPAROUND);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_FEEDBACK_WRAPAROUND) & mask));
+      }
+    };
+
+    /// Describes the serial_mode setting.
+    struct serial_mode
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "serial_mode"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SERIAL_MODE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_SERIAL_MODE]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_SERIAL_MODE] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the serial_device_number setting.
+    struct serial_device_number
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "serial_device_number"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SERIAL_DEVICE_NUMBER; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_SERIAL_DEVICE_NUMBER);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_SERIAL_DEVICE_NUMBER, value);
+      }
+    };
+
+    /// Describes the never_sleep setting.
+    struct never_sleep
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "never_sleep"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_NEVER_SLEEP & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_NEVER_SLEEP);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_NEVER_SLEEP) & mask));
+      }
+    };
+
+    /// Describes the serial_enable_crc setting.
+    struct serial_enable_crc
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "serial_enable_crc"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_SERIAL_ENABLE_CRC & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_CRC);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_CRC) & mask));
+      }
+    };
+
+    /// Describes the serial_enable_14bit_device_number setting.
+    struct serial_enable_14bit_device_number
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "serial_enable_14bit_device_number"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_SERIAL_ENABLE_14BIT_DEVICE_NUMBER & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_14BIT_DEVICE_NUMBER);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_14BIT_DEVICE_NUMBER) & mask));
+      }
+    };
+
+    /// Describes the serial_disable_compact_protocol setting.
+    struct serial_disable_compact_protocol
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "serial_disable_compact_protocol"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_SERIAL_DISABLE_COMPACT_PROTOCOL & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_SERIAL_DISABLE_COMPACT_PROTOCOL);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_SERIAL_DISABLE_COMPACT_PROTOCOL) & mask));
+      }
+    };
+
+    /// Describes the proportional_multiplier setting.
+    struct proportional_multiplier
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "proportional_multiplier"; }
+      static constexpr uint8_t address() { return JRK_SETTING_PROPORTIONAL_MULTIPLIER; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_PROPORTIONAL_MULTIPLIER);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_PROPORTIONAL_MULTIPLIER, value);
+      }
+    };
+
+    /// Describes the proportional_exponent setting.
+    struct proportional_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "proportional_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_PROPORTIONAL_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_PROPORTIONAL_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_PROPORTIONAL_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the integral_multiplier setting.
+    struct integral_multiplier
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "integral_multiplier"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INTEGRAL_MULTIPLIER; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INTEGRAL_MULTIPLIER);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INTEGRAL_MULTIPLIER, value);
+      }
+    };
+
+    /// Describes the integral_exponent setting.
+    struct integral_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "integral_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INTEGRAL_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_INTEGRAL_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_INTEGRAL_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the derivative_multiplier setting.
+    struct derivative_multiplier
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "derivative_multiplier"; }
+      static constexpr uint8_t address() { return JRK_SETTING_DERIVATIVE_MULTIPLIER; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_DERIVATIVE_MULTIPLIER);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_DERIVATIVE_MULTIPLIER, value);
+      }
+    };
+
+    /// Describes the derivative_exponent setting.
+    struct derivative_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "derivative_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_DERIVATIVE_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_DERIVATIVE_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_DERIVATIVE_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the pid_period setting.
+    struct pid_period
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "pid_period"; }
+      static constexpr uint8_t address() { return JRK_SETTING_PID_PERIOD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_PID_PERIOD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_PID_PERIOD, value);
+      }
+    };
+
+    /// Describes the integral_divider_exponent setting.
+    struct integral_divider_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "integral_divider_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INTEGRAL_DIVIDER_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_INTEGRAL_DIVIDER_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_INTEGRAL_DIVIDER_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the integral_limit setting.
+    struct integral_limit
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "integral_limit"; }
+      static constexpr uint8_t address() { return JRK_SETTING_INTEGRAL_LIMIT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_INTEGRAL_LIMIT);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_INTEGRAL_LIMIT, value);
+      }
+    };
+
+    /// Describes the reset_integral setting.
+    struct reset_integral
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "reset_integral"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE3; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE3] >> JRK_OPTIONS_BYTE3_RESET_INTEGRAL & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE3_RESET_INTEGRAL);
+        buf[JRK_SETTING_OPTIONS_BYTE3] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE3] & ~mask) | ((value << JRK_OPTIONS_BYTE3_RESET_INTEGRAL) & mask));
+      }
+    };
+
+    /// Describes the pwm_frequency setting.
+    struct pwm_frequency
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "pwm_frequency"; }
+      static constexpr uint8_t address() { return JRK_SETTING_PWM_FREQUENCY; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_PWM_FREQUENCY]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_PWM_FREQUENCY] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the current_samples_exponent setting.
+    struct current_samples_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "current_samples_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_CURRENT_SAMPLES_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_CURRENT_SAMPLES_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_CURRENT_SAMPLES_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the hard_overcurrent_threshold setting.
+    struct hard_overcurrent_threshold
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "hard_overcurrent_threshold"; }
+      static constexpr uint8_t address() { return JRK_SETTING_HARD_OVERCURRENT_THRESHOLD; }
+      static constexpr bool applies_to(uint32_t product)
+      {
+        return product != JRK_PRODUCT_UMC06A;
+      }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_HARD_OVERCURRENT_THRESHOLD]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_HARD_OVERCURRENT_THRESHOLD] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the current_offset_calibration setting.
+    struct current_offset_calibration
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "current_offset_calibration"; }
+      static constexpr uint8_t address() { return JRK_SETTING_CURRENT_OFFSET_CALIBRATION; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_SETTING_CURRENT_OFFSET_CALIBRATION);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_int16_t(buf + JRK_SETTING_CURRENT_OFFSET_CALIBRATION, value);
+      }
+    };
+
+    /// Describes the current_scale_calibration setting.
+    struct current_scale_calibration
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "current_scale_calibration"; }
+      static constexpr uint8_t address() { return JRK_SETTING_CURRENT_SCALE_CALIBRATION; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_SETTING_CURRENT_SCALE_CALIBRATION);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_int16_t(buf + JRK_SETTING_CURRENT_SCALE_CALIBRATION, value);
+      }
+    };
+
+    /// Describes the motor_invert setting.
+    struct motor_invert
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "motor_invert"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE2; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE2] >> JRK_OPTIONS_BYTE2_MOTOR_INVERT & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE2_MOTOR_INVERT);
+        buf[JRK_SETTING_OPTIONS_BYTE2] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE2] & ~mask) | ((value << JRK_OPTIONS_BYTE2_MOTOR_INVERT) & mask));
+      }
+    };
+
+    /// Describes the max_duty_cycle_while_feedback_out_of_range setting.
+    struct max_duty_cycle_while_feedback_out_of_range
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_duty_cycle_while_feedback_out_of_range"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_DUTY_CYCLE_WHILE_FEEDBACK_OUT_OF_RANGE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_WHILE_FEEDBACK_OUT_OF_RANGE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_WHILE_FEEDBACK_OUT_OF_RANGE, value);
+      }
+    };
+
+    /// Describes the max_acceleration_forward setting.
+    struct max_acceleration_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_acceleration_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_ACCELERATION_FORWARD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_ACCELERATION_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_ACCELERATION_FORWARD, value);
+      }
+    };
+
+    /// Describes the max_acceleration_reverse setting.
+    struct max_acceleration_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_acceleration_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_ACCELERATION_REVERSE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_ACCELERATION_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_ACCELERATION_REVERSE, value);
+      }
+    };
+
+    /// Describes the max_deceleration_forward setting.
+    struct max_deceleration_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_deceleration_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_DECELERATION_FORWARD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_DECELERATION_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_DECELERATION_FORWARD, value);
+      }
+    };
+
+    /// Describes the max_deceleration_reverse setting.
+    struct max_deceleration_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_deceleration_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_DECELERATION_REVERSE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_DECELERATION_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_DECELERATION_REVERSE, value);
+      }
+    };
+
+    /// Describes the max_duty_cycle_forward setting.
+    struct max_duty_cycle_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_duty_cycle_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_DUTY_CYCLE_FORWARD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_FORWARD, value);
+      }
+    };
+
+    /// Describes the max_duty_cycle_reverse setting.
+    struct max_duty_cycle_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "max_duty_cycle_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_MAX_DUTY_CYCLE_REVERSE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_MAX_DUTY_CYCLE_REVERSE, value);
+      }
+    };
+
+    /// Describes the encoded_hard_current_limit_forward setting.
+    struct encoded_hard_current_limit_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "encoded_hard_current_limit_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_FORWARD; }
+      static constexpr bool applies_to(uint32_t product)
+      {
+        return product != JRK_PRODUCT_UMC06A;
+      }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_FORWARD, value);
+      }
+    };
+
+    /// Describes the encoded_hard_current_limit_reverse setting.
+    struct encoded_hard_current_limit_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "encoded_hard_current_limit_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_REVERSE; }
+      static constexpr bool applies_to(uint32_t product)
+      {
+        return product != JRK_PRODUCT_UMC06A;
+      }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_REVERSE, value);
+      }
+    };
+
+    /// Describes the soft_current_limit_forward setting.
+    struct soft_current_limit_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "soft_current_limit_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SOFT_CURRENT_LIMIT_FORWARD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_LIMIT_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_LIMIT_FORWARD, value);
+      }
+    };
+
+    /// Describes the soft_current_limit_reverse setting.
+    struct soft_current_limit_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "soft_current_limit_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SOFT_CURRENT_LIMIT_REVERSE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_LIMIT_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_LIMIT_REVERSE, value);
+      }
+    };
+
+    /// Describes the soft_current_regulation_level_forward setting.
+    struct soft_current_regulation_level_forward
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "soft_current_regulation_level_forward"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_FORWARD; }
+      static constexpr bool applies_to(uint32_t product)
+      {
+        return product == JRK_PRODUCT_UMC06A;
+      }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_FORWARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_FORWARD, value);
+      }
+    };
+
+    /// Describes the soft_current_regulation_level_reverse setting.
+    struct soft_current_regulation_level_reverse
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "soft_current_regulation_level_reverse"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_REVERSE; }
+      static constexpr bool applies_to(uint32_t product)
+      {
+        return product == JRK_PRODUCT_UMC06A;
+      }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_REVERSE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_REVERSE, value);
+      }
+    };
+
+    /// Describes the coast_when_off setting.
+    struct coast_when_off
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "coast_when_off"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE3; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE3] >> JRK_OPTIONS_BYTE3_COAST_WHEN_OFF & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE3_COAST_WHEN_OFF);
+        buf[JRK_SETTING_OPTIONS_BYTE3] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE3] & ~mask) | ((value << JRK_OPTIONS_BYTE3_COAST_WHEN_OFF) & mask));
+      }
+    };
+
+    /// Describes the error_enable setting.
+    struct error_enable
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "error_enable"; }
+      static constexpr uint8_t address() { return JRK_SETTING_ERROR_ENABLE; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_ERROR_ENABLE);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_ERROR_ENABLE, value);
+      }
+    };
+
+    /// Describes the error_latch setting.
+    struct error_latch
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "error_latch"; }
+      static constexpr uint8_t address() { return JRK_SETTING_ERROR_LATCH; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_ERROR_LATCH);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_ERROR_LATCH, value);
+      }
+    };
+
+    /// Describes the error_hard setting.
+    struct error_hard
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "error_hard"; }
+      static constexpr uint8_t address() { return JRK_SETTING_ERROR_HARD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_ERROR_HARD);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_ERROR_HARD, value);
+      }
+    };
+
+    /// Describes the vin_calibration setting.
+    struct vin_calibration
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "vin_calibration"; }
+      static constexpr uint8_t address() { return JRK_SETTING_VIN_CALIBRATION; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_SETTING_VIN_CALIBRATION);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_int16_t(buf + JRK_SETTING_VIN_CALIBRATION, value);
+      }
+    };
+
+    /// Describes the disable_i2c_pullups setting.
+    struct disable_i2c_pullups
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "disable_i2c_pullups"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_DISABLE_I2C_PULLUPS & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_DISABLE_I2C_PULLUPS);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_DISABLE_I2C_PULLUPS) & mask));
+      }
+    };
+
+    /// Describes the analog_sda_pullup setting.
+    struct analog_sda_pullup
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "analog_sda_pullup"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_ANALOG_SDA_PULLUP & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_ANALOG_SDA_PULLUP);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_ANALOG_SDA_PULLUP) & mask));
+      }
+    };
+
+    /// Describes the always_analog_sda setting.
+    struct always_analog_sda
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "always_analog_sda"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_SDA & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_SDA);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_SDA) & mask));
+      }
+    };
+
+    /// Describes the always_analog_fba setting.
+    struct always_analog_fba
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "always_analog_fba"; }
+      static constexpr uint8_t address() { return JRK_SETTING_OPTIONS_BYTE1; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_OPTIONS_BYTE1] >> JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_FBA & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_FBA);
+        buf[JRK_SETTING_OPTIONS_BYTE1] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_OPTIONS_BYTE1] & ~mask) | ((value << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_FBA) & mask));
+      }
+    };
+
+    /// Describes the fbt_method setting.
+    struct fbt_method
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "fbt_method"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_METHOD; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FBT_METHOD]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FBT_METHOD] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the fbt_timing_clock setting.
+    struct fbt_timing_clock
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "fbt_timing_clock"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_OPTIONS; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FBT_OPTIONS] >> JRK_FBT_OPTIONS_TIMING_CLOCK & JRK_FBT_OPTIONS_TIMING_CLOCK_MASK);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(JRK_FBT_OPTIONS_TIMING_CLOCK_MASK << JRK_FBT_OPTIONS_TIMING_CLOCK);
+        buf[JRK_SETTING_FBT_OPTIONS] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_FBT_OPTIONS] & ~mask) | ((value << JRK_FBT_OPTIONS_TIMING_CLOCK) & mask));
+      }
+    };
+
+    /// Describes the fbt_timing_polarity setting.
+    struct fbt_timing_polarity
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "fbt_timing_polarity"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_OPTIONS; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_SETTING_FBT_OPTIONS] >> JRK_FBT_OPTIONS_TIMING_POLARITY & 1) != 0;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        const uint8_t mask = static_cast<uint8_t>(1 << JRK_FBT_OPTIONS_TIMING_POLARITY);
+        buf[JRK_SETTING_FBT_OPTIONS] = static_cast<uint8_t>(
+          (buf[JRK_SETTING_FBT_OPTIONS] & ~mask) | ((value << JRK_FBT_OPTIONS_TIMING_POLARITY) & mask));
+      }
+    };
+
+    /// Describes the fbt_timing_timeout setting.
+    struct fbt_timing_timeout
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "fbt_timing_timeout"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_TIMING_TIMEOUT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_SETTING_FBT_TIMING_TIMEOUT);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + JRK_SETTING_FBT_TIMING_TIMEOUT, value);
+      }
+    };
+
+    /// Describes the fbt_samples setting.
+    struct fbt_samples
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "fbt_samples"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_SAMPLES; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FBT_SAMPLES]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FBT_SAMPLES] = static_cast<uint8_t>(value);
+      }
+    };
+
+    /// Describes the fbt_divider_exponent setting.
+    struct fbt_divider_exponent
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "fbt_divider_exponent"; }
+      static constexpr uint8_t address() { return JRK_SETTING_FBT_DIVIDER_EXPONENT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_SETTING_FBT_DIVIDER_EXPONENT]);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[JRK_SETTING_FBT_DIVIDER_EXPONENT] = static_cast<uint8_t>(value);
+      }
+    };
+
+    // End of auto-generated settings C++ field descriptors.
+
+    /// Describes the serial_baud_rate setting, which is stored in the image
+    /// as a baud rate generator value.  See jrk_settings_set_serial_baud_rate().
+    struct serial_baud_rate
+    {
+      typedef uint32_t type;
+      static constexpr const char * name() { return "serial_baud_rate"; }
+      static constexpr uint8_t address()
+      {
+        return JRK_SETTING_SERIAL_BAUD_RATE_GENERATOR;
+      }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        uint32_t brg = field_detail::read_uint16_t(buf + address());
+        return (JRK_BAUD_RATE_GENERATOR_FACTOR + ((brg + 1) >> 1)) / (brg + 1);
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        uint32_t brg = 0xFFFF;
+        if (value != 0)
+        {
+          brg = (JRK_BAUD_RATE_GENERATOR_FACTOR - (value >> 1)) / value;
+          if (brg > 0xFFFF) { brg = 0xFFFF; }
+        }
+        field_detail::write_uint16_t(buf + address(), brg);
+      }
+    };
+
+    /// Describes the serial_timeout setting, which is stored in the image in
+    /// units of JRK_SERIAL_TIMEOUT_UNITS.  See jrk_settings_set_serial_timeout().
+    struct serial_timeout
+    {
+      typedef uint32_t type;
+      static constexpr const char * name() { return "serial_timeout"; }
+      static constexpr uint8_t address() { return JRK_SETTING_SERIAL_TIMEOUT; }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + address())
+          * JRK_SERIAL_TIMEOUT_UNITS;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        field_detail::write_uint16_t(buf + address(),
+          value / JRK_SERIAL_TIMEOUT_UNITS);
+      }
+    };
+
+    /// Describes the brake_duration_forward setting, which is stored in the
+    /// image in units of JRK_BRAKE_DURATION_UNITS.  See
+    /// jrk_settings_set_brake_duration_forward().
+    struct brake_duration_forward
+    {
+      typedef uint32_t type;
+      static constexpr const char * name() { return "brake_duration_forward"; }
+      static constexpr uint8_t address()
+      {
+        return JRK_SETTING_BRAKE_DURATION_FORWARD;
+      }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return buf[address()] * JRK_BRAKE_DURATION_UNITS;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[address()] = static_cast<uint8_t>(value / JRK_BRAKE_DURATION_UNITS);
+      }
+    };
+
+    /// Describes the brake_duration_reverse setting, which is stored in the
+    /// image in units of JRK_BRAKE_DURATION_UNITS.  See
+    /// jrk_settings_set_brake_duration_reverse().
+    struct brake_duration_reverse
+    {
+      typedef uint32_t type;
+      static constexpr const char * name() { return "brake_duration_reverse"; }
+      static constexpr uint8_t address()
+      {
+        return JRK_SETTING_BRAKE_DURATION_REVERSE;
+      }
+      static constexpr bool applies_to(uint32_t) { return true; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return buf[address()] * JRK_BRAKE_DURATION_UNITS;
+      }
+      static void write(uint8_t * buf, type value) noexcept
+      {
+        buf[address()] = static_cast<uint8_t>(value / JRK_BRAKE_DURATION_UNITS);
+      }
+    };
+  }
+
+  /// Compile-time descriptors for the variables stored in a variables image
+  /// (see variables_image).  These are like the descriptors in jrk::field,
+  /// except that they only have a read() function.
+  namespace variable_field
+  {
+    // Beginning of auto-generated variables C++ field descriptors.
+
+    /// Describes the input variable.
+    struct input
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "input"; }
+      static constexpr uint8_t address() { return JRK_VAR_INPUT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_INPUT);
+      }
+    };
+
+    /// Describes the target variable.
+    struct target
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "target"; }
+      static constexpr uint8_t address() { return JRK_VAR_TARGET; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_TARGET);
+      }
+    };
+
+    /// Describes the feedback variable.
+    struct feedback
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "feedback"; }
+      static constexpr uint8_t address() { return JRK_VAR_FEEDBACK; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_FEEDBACK);
+      }
+    };
+
+    /// Describes the scaled_feedback variable.
+    struct scaled_feedback
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "scaled_feedback"; }
+      static constexpr uint8_t address() { return JRK_VAR_SCALED_FEEDBACK; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_SCALED_FEEDBACK);
+      }
+    };
+
+    /// Describes the integral variable.
+    struct integral
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "integral"; }
+      static constexpr uint8_t address() { return JRK_VAR_INTEGRAL; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_VAR_INTEGRAL);
+      }
+    };
+
+    /// Describes the duty_cycle_target variable.
+    struct duty_cycle_target
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "duty_cycle_target"; }
+      static constexpr uint8_t address() { return JRK_VAR_DUTY_CYCLE_TARGET; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_VAR_DUTY_CYCLE_TARGET);
+      }
+    };
+
+    /// Describes the duty_cycle variable.
+    struct duty_cycle
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "duty_cycle"; }
+      static constexpr uint8_t address() { return JRK_VAR_DUTY_CYCLE; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_VAR_DUTY_CYCLE);
+      }
+    };
+
+    /// Describes the current_low_res variable.
+    struct current_low_res
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "current_low_res"; }
+      static constexpr uint8_t address() { return JRK_VAR_CURRENT_LOW_RES; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_VAR_CURRENT_LOW_RES]);
+      }
+    };
+
+    /// Describes the pid_period_exceeded variable.
+    struct pid_period_exceeded
+    {
+      typedef bool type;
+      static constexpr const char * name() { return "pid_period_exceeded"; }
+      static constexpr uint8_t address() { return JRK_VAR_PID_PERIOD_EXCEEDED; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return (buf[JRK_VAR_PID_PERIOD_EXCEEDED] & 1) != 0;
+      }
+    };
+
+    /// Describes the pid_period_count variable.
+    struct pid_period_count
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "pid_period_count"; }
+      static constexpr uint8_t address() { return JRK_VAR_PID_PERIOD_COUNT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_PID_PERIOD_COUNT);
+      }
+    };
+
+    /// Describes the error_flags_halting variable.
+    struct error_flags_halting
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "error_flags_halting"; }
+      static constexpr uint8_t address() { return JRK_VAR_ERROR_FLAGS_HALTING; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_ERROR_FLAGS_HALTING);
+      }
+    };
+
+    /// Describes the error_flags_occurred variable.
+    struct error_flags_occurred
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "error_flags_occurred"; }
+      static constexpr uint8_t address() { return JRK_VAR_ERROR_FLAGS_OCCURRED; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_ERROR_FLAGS_OCCURRED);
+      }
+    };
+
+    /// Describes the vin_voltage variable.
+    struct vin_voltage
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "vin_voltage"; }
+      static constexpr uint8_t address() { return JRK_VAR_VIN_VOLTAGE; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_VIN_VOLTAGE);
+      }
+    };
+
+    /// Describes the current variable.
+    struct current
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "current"; }
+      static constexpr uint8_t address() { return JRK_VAR_CURRENT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_CURRENT);
+      }
+    };
+
+    /// Describes the device_reset variable.
+    struct device_reset
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "device_reset"; }
+      static constexpr uint8_t address() { return JRK_VAR_DEVICE_RESET; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_VAR_DEVICE_RESET]);
+      }
+    };
+
+    /// Describes the up_time variable.
+    struct up_time
+    {
+      typedef uint32_t type;
+      static constexpr const char * name() { return "up_time"; }
+      static constexpr uint8_t address() { return JRK_VAR_UP_TIME; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint32_t(buf + JRK_VAR_UP_TIME);
+      }
+    };
+
+    /// Describes the rc_pulse_width variable.
+    struct rc_pulse_width
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "rc_pulse_width"; }
+      static constexpr uint8_t address() { return JRK_VAR_RC_PULSE_WIDTH; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_RC_PULSE_WIDTH);
+      }
+    };
+
+    /// Describes the fbt_reading variable.
+    struct fbt_reading
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "fbt_reading"; }
+      static constexpr uint8_t address() { return JRK_VAR_FBT_READING; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_FBT_READING);
+      }
+    };
+
+    /// Describes the raw_current variable.
+    struct raw_current
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "raw_current"; }
+      static constexpr uint8_t address() { return JRK_VAR_RAW_CURRENT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_RAW_CURRENT);
+      }
+    };
+
+    /// Describes the encoded_hard_current_limit variable.
+    struct encoded_hard_current_limit
+    {
+      typedef uint16_t type;
+      static constexpr const char * name() { return "encoded_hard_current_limit"; }
+      static constexpr uint8_t address() { return JRK_VAR_ENCODED_HARD_CURRENT_LIMIT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_uint16_t(buf + JRK_VAR_ENCODED_HARD_CURRENT_LIMIT);
+      }
+    };
+
+    /// Describes the last_duty_cycle variable.
+    struct last_duty_cycle
+    {
+      typedef int16_t type;
+      static constexpr const char * name() { return "last_duty_cycle"; }
+      static constexpr uint8_t address() { return JRK_VAR_LAST_DUTY_CYCLE; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return field_detail::read_int16_t(buf + JRK_VAR_LAST_DUTY_CYCLE);
+      }
+    };
+
+    /// Describes the current_chopping_consecutive_count variable.
+    struct current_chopping_consecutive_count
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "current_chopping_consecutive_count"; }
+      static constexpr uint8_t address() { return JRK_VAR_CURRENT_CHOPPING_CONSECUTIVE_COUNT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_VAR_CURRENT_CHOPPING_CONSECUTIVE_COUNT]);
+      }
+    };
+
+    /// Describes the current_chopping_occurrence_count variable.
+    struct current_chopping_occurrence_count
+    {
+      typedef uint8_t type;
+      static constexpr const char * name() { return "current_chopping_occurrence_count"; }
+      static constexpr uint8_t address() { return JRK_VAR_CURRENT_CHOPPING_OCCURRENCE_COUNT; }
+      static type read(const uint8_t * buf) noexcept
+      {
+        return static_cast<uint8_t>(buf[JRK_VAR_CURRENT_CHOPPING_OCCURRENCE_COUNT]);
+      }
+    };
+
+    // End of auto-generated variables C++ field descriptors.
+  }
+
+  /// Calls the visitor once for every descriptor in jrk::field, passing it a
+  /// default-constructed descriptor object.  The visitor is typically a
+  /// generic lambda or a function object with a templated call operator.
+  ///
+  /// Settings that do not apply to every product are included; use
+  /// applies_to() to check them.
+  template <typename Visitor>
+  void for_each_settings_field(Visitor && visitor)
+  {
+    // Beginning of auto-generated settings C++ field visitor.
+
+    visitor(field::input_mode());
+    visitor(field::input_error_minimum());
+    visitor(field::input_error_maximum());
+    visitor(field::input_minimum());
+    visitor(field::input_maximum());
+    visitor(field::input_neutral_minimum());
+    visitor(field::input_neutral_maximum());
+    visitor(field::output_minimum());
+    visitor(field::output_neutral());
+    visitor(field::output_maximum());
+    visitor(field::input_invert());
+    visitor(field::input_scaling_degree());
+    visitor(field::input_detect_disconnect());
+    visitor(field::input_analog_samples_exponent());
+    visitor(field::feedback_mode());
+    visitor(field::feedback_error_minimum());
+    visitor(field::feedback_error_maximum());
+    visitor(field::feedback_minimum());
+    visitor(field::feedback_maximum());
+    visitor(field::feedback_invert());
+    visitor(field::feedback_detect_disconnect());
+    visitor(field::feedback_dead_zone());
+    visitor(field::feedback_analog_samples_exponent());
+    visitor(field::feedback_wraparound());
+    visitor(field::serial_mode());
+    visitor(field::serial_baud_rate());
+    visitor(field::serial_timeout());
+    visitor(field::serial_device_number());
+    visitor(field::never_sleep());
+    visitor(field::serial_enable_crc());
+    visitor(field::serial_enable_14bit_device_number());
+    visitor(field::serial_disable_compact_protocol());
+    visitor(field::proportional_multiplier());
+    visitor(field::proportional_exponent());
+    visitor(field::integral_multiplier());
+    visitor(field::integral_exponent());
+    visitor(field::derivative_multiplier());
+    visitor(field::derivative_exponent());
+    visitor(field::pid_period());
+    visitor(field::integral_divider_exponent());
+    visitor(field::integral_limit());
+    visitor(field::reset_integral());
+    visitor(field::pwm_frequency());
+    visitor(field::current_samples_exponent());
+    visitor(field::hard_overcurrent_threshold());
+    visitor(field::current_offset_calibration());
+    visitor(field::current_scale_calibration());
+    visitor(field::motor_invert());
+    visitor(field::max_duty_cycle_while_feedback_out_of_range());
+    visitor(field::max_acceleration_forward());
+    visitor(field::max_acceleration_reverse());
+    visitor(field::max_deceleration_forward());
+    visitor(field::max_deceleration_reverse());
+    visitor(field::max_duty_cycle_forward());
+    visitor(field::max_duty_cycle_reverse());
+    visitor(field::encoded_hard_current_limit_forward());
+    visitor(field::encoded_hard_current_limit_reverse());
+    visitor(field::brake_duration_forward());
+    visitor(field::brake_duration_reverse());
+    visitor(field::soft_current_limit_forward());
+    visitor(field::soft_current_limit_reverse());
+    visitor(field::soft_current_regulation_level_forward());
+    visitor(field::soft_current_regulation_level_reverse());
+    visitor(field::coast_when_off());
+    visitor(field::error_enable());
+    visitor(field::error_latch());
+    visitor(field::error_hard());
+    visitor(field::vin_calibration());
+    visitor(field::disable_i2c_pullups());
+    visitor(field::analog_sda_pullup());
+    visitor(field::always_analog_sda());
+    visitor(field::always_analog_fba());
+    visitor(field::fbt_method());
+    visitor(field::fbt_timing_clock());
+    visitor(field::fbt_timing_polarity());
+    visitor(field::fbt_timing_timeout());
+    visitor(field::fbt_samples());
+    visitor(field::fbt_divider_exponent());
+
+    // End of auto-generated settings C++ field visitor.
+  }
+
+  /// Calls the visitor once for every descriptor in jrk::variable_field.  See
+  /// for_each_settings_field().
+  template <typename Visitor>
+  void for_each_variables_field(Visitor && visitor)
+  {
+    // Beginning of auto-generated variables C++ field visitor.
+
+    visitor(variable_field::input());
+    visitor(variable_field::target());
+    visitor(variable_field::feedback());
+    visitor(variable_field::scaled_feedback());
+    visitor(variable_field::integral());
+    visitor(variable_field::duty_cycle_target());
+    visitor(variable_field::duty_cycle());
+    visitor(variable_field::current_low_res());
+    visitor(variable_field::pid_period_exceeded());
+    visitor(variable_field::pid_period_count());
+    visitor(variable_field::error_flags_halting());
+    visitor(variable_field::error_flags_occurred());
+    visitor(variable_field::vin_voltage());
+    visitor(variable_field::current());
+    visitor(variable_field::device_reset());
+    visitor(variable_field::up_time());
+    visitor(variable_field::rc_pulse_width());
+    visitor(variable_field::fbt_reading());
+    visitor(variable_field::raw_current());
+    visitor(variable_field::encoded_hard_current_limit());
+    visitor(variable_field::last_duty_cycle());
+    visitor(variable_field::current_chopping_consecutive_count());
+    visitor(variable_field::current_chopping_occurrence_count());
+
+    // End of auto-generated variables C++ field visitor.
+  }
+
+  /// A raw settings image, in the format used by jrk_settings_decode() and
+  /// jrk_settings_encode().  This is plain old data, so it can be copied and
+  /// compared cheaply, and its fields can be accessed with inline code that is
+  /// resolved at compile time:
+  ///
+  ///     jrk::settings_image image = settings.encode();
+  ///     uint16_t period = image.get<jrk::field::pid_period>();
+  struct settings_image
+  {
+    /// The raw bytes.  Byte N holds setting N (see the JRK_SETTING_* macros).
+    uint8_t bytes[JRK_SETTINGS_SIZE];
+
+    /// Reads the specified field from the image.
+    template <typename Field>
+    typename Field::type get() const noexcept
+    {
+      return Field::read(bytes);
+    }
+
+    /// Writes the specified field to the image, leaving any other settings
+    /// that share the same byte unchanged.
+    template <typename Field>
+    void set(typename Field::type value) noexcept
+    {
+      Field::write(bytes, value);
+    }
+  };
+
+  /// A raw variables image, in the format used by jrk_variables_decode().  See
+  /// settings_image.
+  struct variables_image
+  {
+    /// The raw bytes.  Byte N holds variable N (see the JRK_VAR_* macros).
+    uint8_t bytes[JRK_VARIABLES_SIZE];
+
+    /// Reads the specified field from the image.
+    template <typename Field>
+    typename Field::type get() const noexcept
+    {
+      return Field::read(bytes);
+    }
+  };
+
   /// Represets the settings for a jrk.  This object just stores plain old data;
   /// it does not have any pointers or handles for other resources.
   class settings : public unique_pointer_wrapper_with_copy<jrk_settings>
@@ -317,6 +2281,27 @@ namespace jrk
       return r;
     }
 
+    /// Wrapper for jrk_settings_decode().
+    void decode(const uint8_t * buf, size_t len)
+    {
+      throw_if_needed(jrk_settings_decode(buf, len, pointer));
+    }
+
+    /// Wrapper for jrk_settings_decode() that takes a settings_image.
+    void decode(const settings_image & image)
+    {
+      decode(image.bytes, sizeof(image.bytes));
+    }
+
+    /// Wrapper for jrk_settings_encode().
+    settings_image encode() const
+    {
+      settings_image image;
+      throw_if_needed(jrk_settings_encode(
+        pointer, image.bytes, sizeof(image.bytes)));
+      return image;
+    }
+
     /// Wrapper for jrk_settings_set_product().
     void set_product(uint32_t product) noexcept
     {
@@ -1282,6 +3267,50 @@ namespace jrk
     // End of auto-generated settings C++ accessors.
   };
 
+  /// Represents a pool of memory that settings objects can be allocated from.
+  /// The settings objects returned by this class must not be used after the
+  /// arena is reset or destroyed.
+  class settings_arena : public unique_pointer_wrapper<jrk_settings_arena>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit settings_arena(jrk_settings_arena * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_settings_arena_create().
+    static settings_arena create(size_t block_capacity = 0)
+    {
+      jrk_settings_arena * p;
+      throw_if_needed(jrk_settings_arena_create(block_capacity, &p));
+      return settings_arena(p);
+    }
+
+    /// Wrapper for jrk_settings_arena_reset().
+    void reset() noexcept
+    {
+      jrk_settings_arena_reset(pointer);
+    }
+
+    /// Wrapper for jrk_settings_create_in_arena().
+    settings create_settings()
+    {
+      jrk_settings * p;
+      throw_if_needed(jrk_settings_create_in_arena(pointer, &p));
+      return settings(p);
+    }
+
+    /// Wrapper for jrk_settings_copy_in_arena().
+    settings copy_settings(const settings & source)
+    {
+      jrk_settings * p;
+      throw_if_needed(jrk_settings_copy_in_arena(
+        pointer, source.get_pointer(), &p));
+      return settings(p);
+    }
+  };
+
   /// Represents the variables read from a jrk.  This object just stores plain
   /// old data; it does not have any pointer or handles for other resources.
   class variables : public unique_pointer_wrapper_with_copy<jrk_variables>
@@ -1293,6 +3322,26 @@ namespace jrk
     {
     }
 
+    /// Wrapper for jrk_variables_create().
+    static variables create()
+    {
+      jrk_variables * p;
+      throw_if_needed(jrk_variables_create(&p));
+      return variables(p);
+    }
+
+    /// Wrapper for jrk_variables_decode().
+    void decode(const uint8_t * buf, size_t len)
+    {
+      throw_if_needed(jrk_variables_decode(buf, len, pointer));
+    }
+
+    /// Wrapper for jrk_variables_decode() that takes a variables_image.
+    void decode(const variables_image & image)
+    {
+      decode(image.bytes, sizeof(image.bytes));
+    }
+
     // Beginning of auto-generated variables C++ getters.
 
     /// Wrapper for jrk_variables_get_input().
@@ -1641,6 +3690,13 @@ namespace jrk
       throw_if_needed(jrk_set_eeprom_settings(pointer, settings.get_pointer()));
     }
 
+    /// Wrapper for jrk_set_eeprom_settings_no_fix().
+    void set_eeprom_settings_no_fix(const settings & settings)
+    {
+      throw_if_needed(jrk_set_eeprom_settings_no_fix(
+        pointer, settings.get_pointer()));
+    }
+
     /// Wrapper for jrk_get_ram_settings().
     settings get_ram_settings()
     {
@@ -1655,6 +3711,26 @@ namespace jrk
       throw_if_needed(jrk_set_ram_settings(pointer, s.get_pointer()));
     }
 
+    /// Wrapper for jrk_set_ram_settings_no_fix().
+    void set_ram_settings_no_fix(const settings & s)
+    {
+      throw_if_needed(jrk_set_ram_settings_no_fix(pointer, s.get_pointer()));
+    }
+
+    /// Wrapper for jrk_get_eeprom_setting_segment().
+    void get_eeprom_setting_segment(size_t index, size_t length,
+      uint8_t * output)
+    {
+      throw_if_needed(jrk_get_eeprom_setting_segment(
+          pointer, index, length, output));
+    }
+
+    /// Wrapper for jrk_set_eeprom_setting_byte().
+    void set_eeprom_setting_byte(uint8_t address, uint8_t byte)
+    {
+      throw_if_needed(jrk_set_eeprom_setting_byte(pointer, address, byte));
+    }
+
     /// Wrapper for jrk_get_ram_setting_segment().
     void get_ram_setting_segment(size_t index, size_t length,
       uint8_t * output)
@@ -1747,5 +3823,542 @@ namespace jrk
     jrk_string_free(cstr);
     return diagnosis;
   }
+
+  /// Represents a diagnosis of conditions over a sliding window of time.
+  /// See jrk_diagnosis_window_create().
+  class diagnosis_window : public unique_pointer_wrapper<jrk_diagnosis_window>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit diagnosis_window(jrk_diagnosis_window * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_diagnosis_window_create().
+    static diagnosis_window create(uint32_t window = 0)
+    {
+      jrk_diagnosis_window * p;
+      throw_if_needed(jrk_diagnosis_window_create(window, &p));
+      return diagnosis_window(p);
+    }
+
+    /// Wrapper for jrk_diagnosis_window_clear().
+    void clear() noexcept
+    {
+      jrk_diagnosis_window_clear(pointer);
+    }
+
+    /// Wrapper for jrk_diagnosis_window_add_sample().
+    void add_sample(const variables & vars, uint64_t time) noexcept
+    {
+      jrk_diagnosis_window_add_sample(pointer, vars.get_pointer(), time);
+    }
+
+    /// Wrapper for jrk_diagnosis_window_get_count().
+    uint32_t get_count(uint8_t condition) const noexcept
+    {
+      return jrk_diagnosis_window_get_count(pointer, condition);
+    }
+
+    /// Wrapper for jrk_diagnosis_window_get_findings().
+    std::string get_findings() const
+    {
+      char * cstr;
+      throw_if_needed(jrk_diagnosis_window_get_findings(pointer, &cstr));
+      std::string findings(cstr);
+      jrk_string_free(cstr);
+      return findings;
+    }
+  };
+
+  /// Represents a monitor that checks for drift in the settings of devices.
+  /// See jrk_settings_monitor_create().
+  class settings_monitor : public unique_pointer_wrapper<jrk_settings_monitor>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit settings_monitor(jrk_settings_monitor * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_settings_monitor_create().
+    static settings_monitor create(size_t window_size = 0)
+    {
+      jrk_settings_monitor * p;
+      throw_if_needed(jrk_settings_monitor_create(window_size, &p));
+      return settings_monitor(p);
+    }
+
+    /// Wrapper for jrk_settings_monitor_set_golden().
+    void set_golden(const std::string & serial_number, const settings & golden)
+    {
+      throw_if_needed(jrk_settings_monitor_set_golden(
+        pointer, serial_number.c_str(), golden.get_pointer()));
+    }
+
+    /// Wrapper for jrk_settings_monitor_step().  Returns a report of the
+    /// settings that differ, or an empty string.
+    std::string step(handle & handle)
+    {
+      char * cstr;
+      throw_if_needed(jrk_settings_monitor_step(
+        pointer, handle.get_pointer(), &cstr));
+      std::string report(cstr);
+      jrk_string_free(cstr);
+      return report;
+    }
+
+    /// Wrapper for jrk_settings_monitor_get_steps_per_pass().
+    size_t get_steps_per_pass() const noexcept
+    {
+      return jrk_settings_monitor_get_steps_per_pass(pointer);
+    }
+  };
+
+  /// Represents the accumulated usage of the motor on one device.
+  /// See jrk_usage_create().
+  class usage : public unique_pointer_wrapper_with_copy<jrk_usage>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit usage(jrk_usage * p = NULL) noexcept :
+      unique_pointer_wrapper_with_copy(p)
+    {
+    }
+
+    /// Wrapper for jrk_usage_create().
+    static usage create(const std::string & serial_number)
+    {
+      jrk_usage * p;
+      throw_if_needed(jrk_usage_create(serial_number.c_str(), &p));
+      return usage(p);
+    }
+
+    /// Wrapper for jrk_usage_read_from_string().
+    static usage read_from_string(const std::string & string)
+    {
+      jrk_usage * p;
+      throw_if_needed(jrk_usage_read_from_string(string.c_str(), &p));
+      return usage(p);
+    }
+
+    /// Wrapper for jrk_usage_to_string().
+    std::string to_string() const
+    {
+      char * str;
+      throw_if_needed(jrk_usage_to_string(pointer, &str));
+      std::string r(str);
+      jrk_string_free(str);
+      return r;
+    }
+
+    /// Wrapper for jrk_usage_get_serial_number().
+    std::string get_serial_number() const
+    {
+      return jrk_usage_get_serial_number(pointer);
+    }
+
+    /// Wrapper for jrk_usage_add_sample().
+    void add_sample(const variables & vars, uint64_t time) noexcept
+    {
+      jrk_usage_add_sample(pointer, vars.get_pointer(), time);
+    }
+
+    /// Wrapper for jrk_usage_interrupt().
+    void interrupt() noexcept
+    {
+      jrk_usage_interrupt(pointer);
+    }
+
+    /// Wrapper for jrk_usage_get_monitored_time().
+    uint64_t get_monitored_time() const noexcept
+    {
+      return jrk_usage_get_monitored_time(pointer);
+    }
+
+    /// Wrapper for jrk_usage_get_run_time().
+    uint64_t get_run_time() const noexcept
+    {
+      return jrk_usage_get_run_time(pointer);
+    }
+
+    /// Wrapper for jrk_usage_get_current_limit_time().
+    uint64_t get_current_limit_time() const noexcept
+    {
+      return jrk_usage_get_current_limit_time(pointer);
+    }
+
+    /// Wrapper for jrk_usage_get_duty_cycle_band_time().
+    uint64_t get_duty_cycle_band_time(uint8_t band) const noexcept
+    {
+      return jrk_usage_get_duty_cycle_band_time(pointer, band);
+    }
+
+    /// Wrapper for jrk_usage_get_energy().
+    uint64_t get_energy() const noexcept
+    {
+      return jrk_usage_get_energy(pointer);
+    }
+
+    /// Wrapper for jrk_usage_get_charge().
+    uint64_t get_charge() const noexcept
+    {
+      return jrk_usage_get_charge(pointer);
+    }
+  };
+
+  /// Represents a detector that watches the variables of one device for
+  /// unusual values.  See jrk_anomaly_detector_create().
+  class anomaly_detector : public unique_pointer_wrapper<jrk_anomaly_detector>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit anomaly_detector(jrk_anomaly_detector * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_anomaly_detector_create().
+    static anomaly_detector create()
+    {
+      jrk_anomaly_detector * p;
+      throw_if_needed(jrk_anomaly_detector_create(&p));
+      return anomaly_detector(p);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_set_time_constant().
+    void set_time_constant(uint32_t samples) noexcept
+    {
+      jrk_anomaly_detector_set_time_constant(pointer, samples);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_set_threshold().
+    void set_threshold(double threshold) noexcept
+    {
+      jrk_anomaly_detector_set_threshold(pointer, threshold);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_set_learning_samples().
+    void set_learning_samples(uint32_t samples) noexcept
+    {
+      jrk_anomaly_detector_set_learning_samples(pointer, samples);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_set_min_std_dev().
+    void set_min_std_dev(uint8_t channel, double min_std_dev) noexcept
+    {
+      jrk_anomaly_detector_set_min_std_dev(pointer, channel, min_std_dev);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_restart().
+    void restart() noexcept
+    {
+      jrk_anomaly_detector_restart(pointer);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_add_sample().
+    uint32_t add_sample(const variables & vars) noexcept
+    {
+      return jrk_anomaly_detector_add_sample(pointer, vars.get_pointer());
+    }
+
+    /// Wrapper for jrk_anomaly_detector_get_mean().
+    double get_mean(uint8_t channel) const noexcept
+    {
+      return jrk_anomaly_detector_get_mean(pointer, channel);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_get_std_dev().
+    double get_std_dev(uint8_t channel) const noexcept
+    {
+      return jrk_anomaly_detector_get_std_dev(pointer, channel);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_get_z_score().
+    double get_z_score(uint8_t channel) const noexcept
+    {
+      return jrk_anomaly_detector_get_z_score(pointer, channel);
+    }
+
+    /// Wrapper for jrk_anomaly_detector_get_fit().
+    bool get_fit(double * slope, double * intercept) const noexcept
+    {
+      return jrk_anomaly_detector_get_fit(pointer, slope, intercept);
+    }
+  };
+
+  /// Represents a tracker that reconstructs current chopping episodes.
+  /// See jrk_chopping_tracker_create().
+  class chopping_tracker : public unique_pointer_wrapper<jrk_chopping_tracker>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit chopping_tracker(jrk_chopping_tracker * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_chopping_tracker_create().
+    static chopping_tracker create(size_t log_capacity = 0)
+    {
+      jrk_chopping_tracker * p;
+      throw_if_needed(jrk_chopping_tracker_create(log_capacity, &p));
+      return chopping_tracker(p);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_set_pid_period().
+    void set_pid_period(uint16_t pid_period) noexcept
+    {
+      jrk_chopping_tracker_set_pid_period(pointer, pid_period);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_clear().
+    void clear() noexcept
+    {
+      jrk_chopping_tracker_clear(pointer);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_add_sample().
+    void add_sample(const variables & vars, uint64_t time) noexcept
+    {
+      jrk_chopping_tracker_add_sample(pointer, vars.get_pointer(), time);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_is_chopping().
+    bool is_chopping() const noexcept
+    {
+      return jrk_chopping_tracker_is_chopping(pointer);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_get_episode_count().
+    uint32_t get_episode_count() const noexcept
+    {
+      return jrk_chopping_tracker_get_episode_count(pointer);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_get_total_duration().
+    uint64_t get_total_duration() const noexcept
+    {
+      return jrk_chopping_tracker_get_total_duration(pointer);
+    }
+
+    /// Gets the episodes in the log, oldest first.
+    std::vector<jrk_chopping_episode> get_episodes() const
+    {
+      size_t size = jrk_chopping_tracker_get_log_size(pointer);
+      std::vector<jrk_chopping_episode> episodes(size);
+      for (size_t i = 0; i < size; i++)
+      {
+        jrk_chopping_tracker_get_episode(pointer, i, &episodes[i]);
+      }
+      return episodes;
+    }
+
+    /// Wrapper for jrk_chopping_tracker_get_duration_histogram().
+    uint32_t get_duration_histogram(uint8_t bin) const noexcept
+    {
+      return jrk_chopping_tracker_get_duration_histogram(pointer, bin);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_get_duty_cycle_histogram().
+    uint32_t get_duty_cycle_histogram(uint8_t bin) const noexcept
+    {
+      return jrk_chopping_tracker_get_duty_cycle_histogram(pointer, bin);
+    }
+
+    /// Wrapper for jrk_chopping_tracker_to_string().
+    std::string to_string() const
+    {
+      char * str;
+      throw_if_needed(jrk_chopping_tracker_to_string(pointer, &str));
+      std::string r(str);
+      jrk_string_free(str);
+      return r;
+    }
+  };
+
+  /// Represents a scheduler for reading the variables of several devices.
+  /// See jrk_poll_scheduler_create().
+  class poll_scheduler : public unique_pointer_wrapper<jrk_poll_scheduler>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit poll_scheduler(jrk_poll_scheduler * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_poll_scheduler_create().
+    static poll_scheduler create(size_t device_count)
+    {
+      jrk_poll_scheduler * p;
+      throw_if_needed(jrk_poll_scheduler_create(device_count, &p));
+      return poll_scheduler(p);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_set_period_range().
+    void set_period_range(uint32_t min_period, uint32_t max_period) noexcept
+    {
+      jrk_poll_scheduler_set_period_range(pointer, min_period, max_period);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_set_budget().
+    void set_budget(uint32_t budget) noexcept
+    {
+      jrk_poll_scheduler_set_budget(pointer, budget);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_set_deadband().
+    void set_deadband(uint16_t deadband) noexcept
+    {
+      jrk_poll_scheduler_set_deadband(pointer, deadband);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_next().
+    size_t next(uint64_t * due = NULL) const noexcept
+    {
+      return jrk_poll_scheduler_next(pointer, due);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_add_sample().
+    void add_sample(size_t index, const variables & vars, uint64_t time) noexcept
+    {
+      jrk_poll_scheduler_add_sample(pointer, index, vars.get_pointer(), time);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_get_period().
+    uint32_t get_period(size_t index) const noexcept
+    {
+      return jrk_poll_scheduler_get_period(pointer, index);
+    }
+
+    /// Wrapper for jrk_poll_scheduler_get_rate().
+    double get_rate() const noexcept
+    {
+      return jrk_poll_scheduler_get_rate(pointer);
+    }
+  };
+
+  /// Represents a scheduler for several devices on one serial line.
+  /// See jrk_serial_bus_create().
+  class serial_bus : public unique_pointer_wrapper<jrk_serial_bus>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit serial_bus(jrk_serial_bus * p = NULL) noexcept :
+      unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for jrk_serial_bus_create().
+    static serial_bus create(uint32_t baud_rate, uint32_t flags = 0)
+    {
+      jrk_serial_bus * p;
+      throw_if_needed(jrk_serial_bus_create(baud_rate, flags, &p));
+      return serial_bus(p);
+    }
+
+    /// Wrapper for jrk_serial_bus_add_device().
+    size_t add_device(uint16_t device_number)
+    {
+      size_t index;
+      throw_if_needed(jrk_serial_bus_add_device(pointer, device_number, &index));
+      return index;
+    }
+
+    /// Wrapper for jrk_serial_bus_get_device_count().
+    size_t get_device_count() const noexcept
+    {
+      return jrk_serial_bus_get_device_count(pointer);
+    }
+
+    /// Wrapper for jrk_serial_bus_set_timeout().
+    void set_timeout(uint32_t timeout) noexcept
+    {
+      jrk_serial_bus_set_timeout(pointer, timeout);
+    }
+
+    /// Wrapper for jrk_serial_bus_set_turnaround().
+    void set_turnaround(uint32_t turnaround) noexcept
+    {
+      jrk_serial_bus_set_turnaround(pointer, turnaround);
+    }
+
+    /// Wrapper for jrk_serial_bus_set_read_segment().
+    void set_read_segment(uint8_t offset, uint8_t length)
+    {
+      throw_if_needed(jrk_serial_bus_set_read_segment(pointer, offset, length));
+    }
+
+    /// Wrapper for jrk_serial_bus_set_target().
+    void set_target(size_t index, uint16_t target) noexcept
+    {
+      jrk_serial_bus_set_target(pointer, index, target);
+    }
+
+    /// Wrapper for jrk_serial_bus_stop_motor().
+    void stop_motor(size_t index) noexcept
+    {
+      jrk_serial_bus_stop_motor(pointer, index);
+    }
+
+    /// Wrapper for jrk_serial_bus_get_output().
+    std::vector<uint8_t> get_output(uint64_t time)
+    {
+      std::vector<uint8_t> buf(7 * get_device_count() + 7);
+      buf.resize(jrk_serial_bus_get_output(pointer, time,
+        buf.data(), buf.size()));
+      return buf;
+    }
+
+    /// Wrapper for jrk_serial_bus_handle_input().
+    void handle_input(uint64_t time, const std::vector<uint8_t> & input) noexcept
+    {
+      jrk_serial_bus_handle_input(pointer, time, input.data(), input.size());
+    }
+
+    /// Wrapper for jrk_serial_bus_is_waiting().
+    bool is_waiting(uint64_t * deadline = NULL) const noexcept
+    {
+      return jrk_serial_bus_is_waiting(pointer, deadline);
+    }
+
+    /// Wrapper for jrk_serial_bus_get_variables().
+    variables get_variables(size_t index) const
+    {
+      variables vars = variables::create();
+      throw_if_needed(jrk_serial_bus_get_variables(pointer, index,
+        vars.get_pointer()));
+      return vars;
+    }
+
+    /// Wrapper for jrk_serial_bus_get_update_time().
+    uint64_t get_update_time(size_t index) const noexcept
+    {
+      return jrk_serial_bus_get_update_time(pointer, index);
+    }
+
+    /// Wrapper for jrk_serial_bus_get_device_stats().
+    jrk_serial_bus_device_stats get_device_stats(size_t index) const noexcept
+    {
+      jrk_serial_bus_device_stats stats = {};
+      jrk_serial_bus_get_device_stats(pointer, index, &stats);
+      return stats;
+    }
+
+    /// Wrapper for jrk_serial_bus_get_utilization().
+    double get_utilization(uint64_t time) const noexcept
+    {
+      return jrk_serial_bus_get_utilization(pointer, time);
+    }
+
+    /// Wrapper for jrk_serial_bus_get_unexpected_byte_count().
+    uint64_t get_unexpected_byte_count() const noexcept
+    {
+      return jrk_serial_bus_get_unexpected_byte_count(pointer);
+    }
+  };
 }
 
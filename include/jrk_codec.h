@@ -0,0 +1,466 @@
+// Copyright (C) Pololu Corporation.  See www.pololu.com for details.
+
+/// \file jrk_codec.h
+///
+/// This file encodes the commands of the Jrk G2's USB, serial, and I2C
+/// protocols into buffers provided by the caller.  Everything here is inline,
+/// does not allocate memory, and does not depend on libusbp or on the rest of
+/// libpololu-jrk2, so it can be used on its own by programs that do their own
+/// I/O.
+///
+/// Responses are raw bytes.  Responses to "Get variables" and "Get settings"
+/// commands can be assembled into variables and settings images with
+/// jrk_codec_image_merge(), and then decoded with jrk_variables_decode() or
+/// jrk_settings_decode(), or read field by field with the descriptors in
+/// jrk.hpp.
+
+#pragma once
+
+#include "jrk_protocol.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//// USB ///////////////////////////////////////////////////////////////////////
+
+/// The fields of a USB control transfer setup packet.
+typedef struct jrk_usb_setup
+{
+  uint8_t request_type;
+  uint8_t request;
+  uint16_t value;
+  uint16_t index;
+  uint16_t length;
+} jrk_usb_setup;
+
+/// Returns a setup packet for a vendor-specific request.  Requests that read
+/// data from the Jrk have a non-zero length and set the direction bit.
+static inline jrk_usb_setup jrk_codec_usb_request(bool read,
+  uint8_t request, uint16_t value, uint16_t index, uint16_t length)
+{
+  jrk_usb_setup setup;
+  setup.request_type = read ? 0xC0 : 0x40;
+  setup.request = request;
+  setup.value = value;
+  setup.index = index;
+  setup.length = length;
+  return setup;
+}
+
+/// Writes the 8 bytes of a setup packet, as they appear on the bus.
+static inline void jrk_codec_usb_setup_to_bytes(const jrk_usb_setup * setup,
+  uint8_t * buf)
+{
+  buf[0] = setup->request_type;
+  buf[1] = setup->request;
+  buf[2] = setup->value & 0xFF;
+  buf[3] = setup->value >> 8 & 0xFF;
+  buf[4] = setup->index & 0xFF;
+  buf[5] = setup->index >> 8 & 0xFF;
+  buf[6] = setup->length & 0xFF;
+  buf[7] = setup->length >> 8 & 0xFF;
+}
+
+static inline int16_t jrk_codec_cap_duty_cycle(int16_t duty_cycle)
+{
+  if (duty_cycle > 600) { return 600; }
+  if (duty_cycle < -600) { return -600; }
+  return duty_cycle;
+}
+
+/// See jrk_set_target().  Targets above 4095 are capped.
+static inline jrk_usb_setup jrk_codec_usb_set_target(uint16_t target)
+{
+  if (target > 4095) { target = 4095; }
+  return jrk_codec_usb_request(false, JRK_CMD_SET_TARGET_USB, target, 0, 0);
+}
+
+/// See jrk_stop_motor().
+static inline jrk_usb_setup jrk_codec_usb_stop_motor(void)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_STOP_MOTOR_USB, 0, 0, 0);
+}
+
+/// See jrk_force_duty_cycle_target().
+static inline jrk_usb_setup jrk_codec_usb_force_duty_cycle_target(
+  int16_t duty_cycle)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_FORCE_DUTY_CYCLE_TARGET,
+    (uint16_t)jrk_codec_cap_duty_cycle(duty_cycle), 0, 0);
+}
+
+/// See jrk_force_duty_cycle().
+static inline jrk_usb_setup jrk_codec_usb_force_duty_cycle(int16_t duty_cycle)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_FORCE_DUTY_CYCLE,
+    (uint16_t)jrk_codec_cap_duty_cycle(duty_cycle), 0, 0);
+}
+
+/// See jrk_get_variable_segment().  The flags are a combination of the
+/// JRK_GET_VARIABLES_FLAG_* bits.  The response is length bytes.
+static inline jrk_usb_setup jrk_codec_usb_get_variables(uint8_t offset,
+  uint16_t length, uint16_t flags)
+{
+  return jrk_codec_usb_request(true, JRK_CMD_GET_VARIABLES, flags, offset,
+    length);
+}
+
+/// See jrk_get_eeprom_setting_segment().  The response is length bytes.
+static inline jrk_usb_setup jrk_codec_usb_get_eeprom_settings(uint8_t offset,
+  uint16_t length)
+{
+  return jrk_codec_usb_request(true, JRK_CMD_GET_EEPROM_SETTINGS, 0, offset,
+    length);
+}
+
+/// See jrk_get_ram_setting_segment().  The response is length bytes.
+static inline jrk_usb_setup jrk_codec_usb_get_ram_settings(uint8_t offset,
+  uint16_t length)
+{
+  return jrk_codec_usb_request(true, JRK_CMD_GET_RAM_SETTINGS, 0, offset,
+    length);
+}
+
+/// See jrk_set_ram_setting_segment().  The data stage is the length bytes of
+/// settings to write.
+static inline jrk_usb_setup jrk_codec_usb_set_ram_settings(uint8_t offset,
+  uint16_t length)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_SET_RAM_SETTINGS, 0, offset,
+    length);
+}
+
+/// See jrk_set_eeprom_setting_byte().
+static inline jrk_usb_setup jrk_codec_usb_set_eeprom_setting(uint8_t address,
+  uint8_t byte)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_SET_EEPROM_SETTING, byte,
+    address, 0);
+}
+
+/// See jrk_reinitialize().  The flags are a combination of the
+/// JRK_REINITIALIZE_FLAG_* bits.
+static inline jrk_usb_setup jrk_codec_usb_reinitialize(uint16_t flags)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_REINITIALIZE, flags, 0, 0);
+}
+
+/// See jrk_start_bootloader().
+static inline jrk_usb_setup jrk_codec_usb_start_bootloader(void)
+{
+  return jrk_codec_usb_request(false, JRK_CMD_START_BOOTLOADER, 0, 0, 0);
+}
+
+/// See jrk_get_debug_data().  The response is up to length bytes.
+static inline jrk_usb_setup jrk_codec_usb_get_debug_data(uint16_t length)
+{
+  return jrk_codec_usb_request(true, JRK_CMD_GET_DEBUG_DATA, 0, 0, length);
+}
+
+
+//// Serial and I2C ////////////////////////////////////////////////////////////
+
+/// Use the Pololu protocol, which starts with 0xAA and the device number,
+/// instead of the compact protocol.
+#define JRK_CODEC_SERIAL_FLAG_POLOLU 1
+
+/// With JRK_CODEC_SERIAL_FLAG_POLOLU, send a 14-bit device number.  This must
+/// match the serial_enable_14bit_device_number setting.
+#define JRK_CODEC_SERIAL_FLAG_14BIT_DEVICE_NUMBER 2
+
+/// Add a CRC byte to the end of the frame.  This must match the
+/// serial_enable_crc setting.
+#define JRK_CODEC_SERIAL_FLAG_CRC 4
+
+/// The longest frame any of the functions below can produce.
+#define JRK_CODEC_MAX_FRAME_SIZE 16
+
+/// The most bytes that one serial or I2C read of variables or settings can
+/// get.
+#define JRK_CODEC_MAX_SERIAL_READ_LENGTH 15
+
+/// The most bytes that one serial or I2C "Set RAM settings" command can
+/// write.
+#define JRK_CODEC_MAX_SERIAL_WRITE_LENGTH 7
+
+/// Computes the 7-bit CRC used by the serial protocol.
+static inline uint8_t jrk_codec_crc7(const uint8_t * message, size_t length)
+{
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= message[i];
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      if (crc & 1) { crc ^= 0x91; }
+      crc >>= 1;
+    }
+  }
+  return crc;
+}
+
+/// Writes a serial frame for a command to the buffer and returns its size.
+///
+/// The command is given in its compact protocol form, with the most
+/// significant bit set.  Each data byte must be less than 0x80.  The flags
+/// are a combination of the JRK_CODEC_SERIAL_FLAG_* macros.  The device
+/// number is only used with JRK_CODEC_SERIAL_FLAG_POLOLU.
+///
+/// For I2C, pass 0 for the flags and write the frame to the Jrk's I2C
+/// address.  Then, if the command has a response, read it from the same
+/// address.
+///
+/// Returns 0 if the buffer is too small or the arguments are invalid.
+static inline size_t jrk_codec_serial_frame(uint8_t * buf, size_t size,
+  uint32_t flags, uint16_t device_number, uint8_t command,
+  const uint8_t * data, size_t data_length)
+{
+  if (buf == NULL || !(command & 0x80)) { return 0; }
+
+  size_t needed = 1 + data_length;
+  if (flags & JRK_CODEC_SERIAL_FLAG_POLOLU)
+  {
+    needed += (flags & JRK_CODEC_SERIAL_FLAG_14BIT_DEVICE_NUMBER) ? 3 : 2;
+  }
+  if (flags & JRK_CODEC_SERIAL_FLAG_CRC) { needed++; }
+  if (needed > size) { return 0; }
+
+  size_t n = 0;
+  if (flags & JRK_CODEC_SERIAL_FLAG_POLOLU)
+  {
+    buf[n++] = 0xAA;
+    buf[n++] = device_number & 0x7F;
+    if (flags & JRK_CODEC_SERIAL_FLAG_14BIT_DEVICE_NUMBER)
+    {
+      buf[n++] = device_number >> 7 & 0x7F;
+    }
+    buf[n++] = command & 0x7F;
+  }
+  else
+  {
+    buf[n++] = command;
+  }
+
+  for (size_t i = 0; i < data_length; i++)
+  {
+    if (data[i] & 0x80) { return 0; }
+    buf[n++] = data[i];
+  }
+
+  if (flags & JRK_CODEC_SERIAL_FLAG_CRC)
+  {
+    buf[n] = jrk_codec_crc7(buf, n);
+    n++;
+  }
+
+  return n;
+}
+
+/// Encodes "Set target".  Targets above 4095 are capped.  No response.
+static inline size_t jrk_codec_serial_set_target(uint8_t * buf, size_t size,
+  uint32_t flags, uint16_t device_number, uint16_t target)
+{
+  if (target > 4095) { target = 4095; }
+  uint8_t data = target >> 5 & 0x7F;
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_SET_TARGET_SERIAL + (target & 0x1F), &data, 1);
+}
+
+/// Encodes "Set target low resolution forward" if the magnitude is
+/// positive, or "Set target low resolution reverse" if it is negative.  The
+/// magnitude is capped at 127.  No response.
+static inline size_t jrk_codec_serial_set_target_low_res(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number, int16_t magnitude)
+{
+  uint8_t command = JRK_CMD_SET_TARGET_LOW_RES_FWD;
+  if (magnitude < 0)
+  {
+    command = JRK_CMD_SET_TARGET_LOW_RES_REV;
+    magnitude = -magnitude;
+  }
+  if (magnitude > 127) { magnitude = 127; }
+  uint8_t data = (uint8_t)magnitude;
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    command, &data, 1);
+}
+
+/// Encodes "Stop motor".  No response.
+static inline size_t jrk_codec_serial_stop_motor(uint8_t * buf, size_t size,
+  uint32_t flags, uint16_t device_number)
+{
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_STOP_MOTOR_SERIAL, NULL, 0);
+}
+
+static inline size_t jrk_codec_serial_duty_cycle_command(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number, uint8_t command,
+  int16_t duty_cycle)
+{
+  uint16_t value = (uint16_t)jrk_codec_cap_duty_cycle(duty_cycle);
+  uint8_t data[2] = { (uint8_t)(value & 0x7F), (uint8_t)(value >> 7 & 0x7F) };
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    command, data, 2);
+}
+
+/// Encodes "Force duty cycle target".  No response.
+static inline size_t jrk_codec_serial_force_duty_cycle_target(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number, int16_t duty_cycle)
+{
+  return jrk_codec_serial_duty_cycle_command(buf, size, flags, device_number,
+    JRK_CMD_FORCE_DUTY_CYCLE_TARGET, duty_cycle);
+}
+
+/// Encodes "Force duty cycle".  No response.
+static inline size_t jrk_codec_serial_force_duty_cycle(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number, int16_t duty_cycle)
+{
+  return jrk_codec_serial_duty_cycle_command(buf, size, flags, device_number,
+    JRK_CMD_FORCE_DUTY_CYCLE, duty_cycle);
+}
+
+static inline size_t jrk_codec_serial_segment_read(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number, uint8_t command,
+  uint8_t offset, uint8_t length)
+{
+  if (length == 0 || length > JRK_CODEC_MAX_SERIAL_READ_LENGTH) { return 0; }
+  uint8_t data[2] = { offset, length };
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    command, data, 2);
+}
+
+/// Encodes "Get variables".  The response is length bytes, where length is
+/// from 1 to 15.
+static inline size_t jrk_codec_serial_get_variables(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number,
+  uint8_t offset, uint8_t length)
+{
+  return jrk_codec_serial_segment_read(buf, size, flags, device_number,
+    JRK_CMD_GET_VARIABLES, offset, length);
+}
+
+/// Encodes one of the one-byte "Get variable" commands, which read a 1-byte
+/// or 2-byte variable at the specified offset with a single command byte.
+/// The command is JRK_CMD_GET_VARIABLE_SERIAL plus 0x20 for a 2-byte
+/// variable, plus the offset plus one, so the offset must be less than 0x1F.
+/// The response is length bytes, little-endian.
+///
+/// Reading the error flags this way (offset 0x12 or 0x14 with a length of 2)
+/// is the same command as "Get error flags halting" or "Get error flags
+/// occurred", so it clears them.
+static inline size_t jrk_codec_serial_get_variable(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number,
+  uint8_t offset, uint8_t length)
+{
+  if (offset >= 0x1F || (length != 1 && length != 2)) { return 0; }
+  uint8_t command = JRK_CMD_GET_VARIABLE_SERIAL + offset + 1;
+  if (length == 2) { command += 0x20; }
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    command, NULL, 0);
+}
+
+/// Encodes "Get EEPROM settings".  The response is length bytes, where
+/// length is from 1 to 15.
+static inline size_t jrk_codec_serial_get_eeprom_settings(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number,
+  uint8_t offset, uint8_t length)
+{
+  return jrk_codec_serial_segment_read(buf, size, flags, device_number,
+    JRK_CMD_GET_EEPROM_SETTINGS, offset, length);
+}
+
+/// Encodes "Get RAM settings".  The response is length bytes, where length
+/// is from 1 to 15.
+static inline size_t jrk_codec_serial_get_ram_settings(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number,
+  uint8_t offset, uint8_t length)
+{
+  return jrk_codec_serial_segment_read(buf, size, flags, device_number,
+    JRK_CMD_GET_RAM_SETTINGS, offset, length);
+}
+
+/// Encodes "Set RAM settings" for 1 to 7 bytes of settings.  Since serial
+/// data bytes only have 7 bits, the most significant bits of the settings
+/// bytes are sent together in a final data byte.  No response.
+static inline size_t jrk_codec_serial_set_ram_settings(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number,
+  uint8_t offset, uint8_t length, const uint8_t * settings)
+{
+  if (settings == NULL || length == 0 ||
+    length > JRK_CODEC_MAX_SERIAL_WRITE_LENGTH)
+  {
+    return 0;
+  }
+
+  uint8_t data[3 + JRK_CODEC_MAX_SERIAL_WRITE_LENGTH];
+  uint8_t msbs = 0;
+  data[0] = offset;
+  data[1] = length;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    data[2 + i] = settings[i] & 0x7F;
+    msbs |= (settings[i] >> 7 & 1) << i;
+  }
+  data[2 + length] = msbs;
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_SET_RAM_SETTINGS, data, 3 + length);
+}
+
+/// Encodes "Get error flags halting", which also clears them.  The response
+/// is 2 bytes, little-endian.
+static inline size_t jrk_codec_serial_get_error_flags_halting(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number)
+{
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_GET_ERROR_FLAGS_HALTING_SERIAL, NULL, 0);
+}
+
+/// Encodes "Get error flags occurred", which also clears them.  The
+/// response is 2 bytes, little-endian.
+static inline size_t jrk_codec_serial_get_error_flags_occurred(uint8_t * buf,
+  size_t size, uint32_t flags, uint16_t device_number)
+{
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_GET_ERROR_FLAGS_OCCURRED_SERIAL, NULL, 0);
+}
+
+/// Encodes "Get current chopping occurrence count", which also clears it.
+/// The response is 1 byte.
+static inline size_t jrk_codec_serial_get_current_chopping_occurrence_count(
+  uint8_t * buf, size_t size, uint32_t flags, uint16_t device_number)
+{
+  return jrk_codec_serial_frame(buf, size, flags, device_number,
+    JRK_CMD_GET_CURRENT_CHOPPING_OCCURRENCE_COUNT, NULL, 0);
+}
+
+
+//// Responses /////////////////////////////////////////////////////////////////
+
+/// Copies a segment that was read from the Jrk into a variables or settings
+/// image at the offset it was read from.  Returns false, and copies
+/// nothing, if the segment does not fit in the image.
+static inline bool jrk_codec_image_merge(uint8_t * image, size_t image_size,
+  size_t offset, const uint8_t * data, size_t length)
+{
+  if (image == NULL || data == NULL) { return false; }
+  if (offset > image_size || length > image_size - offset) { return false; }
+  for (size_t i = 0; i < length; i++)
+  {
+    image[offset + i] = data[i];
+  }
+  return true;
+}
+
+/// Reads a little-endian 16-bit value from a response.
+static inline uint16_t jrk_codec_read_u16(const uint8_t * buf)
+{
+  return (uint16_t)(buf[0] | buf[1] << 8);
+}
+
+#ifdef __cplusplus
+}
+#endif
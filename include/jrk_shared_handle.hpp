@@ -0,0 +1,186 @@
+// Copyright (C) Pololu Corporation.  See www.pololu.com for details.
+
+/// \file jrk_shared_handle.hpp
+///
+/// This file provides jrk::shared_handle, a handle that several threads can
+/// use at once.  It is separate from jrk.hpp so that programs that do not
+/// need it do not have to include the C++ threading headers.  Programs that
+/// include it must be built with C++11 thread support (std::thread and
+/// std::mutex), like the jrk2cmd command-line utility.
+
+#pragma once
+
+#include "jrk.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace jrk
+{
+  /// Latency statistics for one lane of a shared_handle.  Each latency is the
+  /// time from when the call was made to when its USB transfer finished,
+  /// including the time spent waiting for other transfers, in microseconds.
+  struct lane_latency
+  {
+    uint32_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+    uint64_t last = 0;
+
+    /// Returns the average latency, or 0 if there were no transfers.
+    double mean() const noexcept
+    {
+      return count ? (double)total / count : 0;
+    }
+  };
+
+  /// A handle that can be used from several threads at once, for example one
+  /// that reads the variables continuously and one that sends commands.
+  ///
+  /// Each call waits in one of three lanes until the USB handle is free.
+  /// When the handle becomes free, it goes to the stop lane first, then the
+  /// command lane, and the telemetry lane only gets it when no commands are
+  /// waiting.  A transfer that has already started cannot be interrupted, so a
+  /// stop command waits for at most one transfer from another lane.
+  ///
+  /// Commands that are sent continuously will keep telemetry from being read,
+  /// so the command lane should only be used for occasional commands.
+  class shared_handle
+  {
+  public:
+    /// The lanes, in order of priority.
+    enum lane { stop_lane = 0, command_lane, telemetry_lane, lane_count };
+
+    /// Constructor that takes ownership of an open handle.
+    explicit shared_handle(handle && h) : h(std::move(h))
+    {
+    }
+
+    /// Constructor that opens a handle to the specified device.
+    explicit shared_handle(const device & device) : h(device)
+    {
+    }
+
+    /// Wrapper for jrk_handle_get_device().
+    device get_device() const
+    {
+      return h.get_device();
+    }
+
+    /// Wrapper for jrk_stop_motor(), using the stop lane.
+    void stop_motor()
+    {
+      run(stop_lane, [&] { h.stop_motor(); });
+    }
+
+    /// Wrapper for jrk_set_target(), using the command lane.
+    void set_target(uint16_t target)
+    {
+      run(command_lane, [&] { h.set_target(target); });
+    }
+
+    /// Wrapper for jrk_run_motor(), using the command lane.
+    void run_motor()
+    {
+      run(command_lane, [&] { h.run_motor(); });
+    }
+
+    /// Wrapper for jrk_clear_errors(), using the command lane.
+    uint16_t clear_errors()
+    {
+      uint16_t flags = 0;
+      run(command_lane, [&] { flags = h.clear_errors(); });
+      return flags;
+    }
+
+    /// Wrapper for jrk_force_duty_cycle_target(), using the command lane.
+    void force_duty_cycle_target(int16_t duty_cycle)
+    {
+      run(command_lane, [&] { h.force_duty_cycle_target(duty_cycle); });
+    }
+
+    /// Wrapper for jrk_force_duty_cycle(), using the command lane.
+    void force_duty_cycle(int16_t duty_cycle)
+    {
+      run(command_lane, [&] { h.force_duty_cycle(duty_cycle); });
+    }
+
+    /// Wrapper for jrk_get_variables(), using the telemetry lane.
+    variables get_variables(uint16_t flags)
+    {
+      variables vars;
+      run(telemetry_lane, [&] { vars = h.get_variables(flags); });
+      return vars;
+    }
+
+    /// Gets the latency statistics of a lane.
+    lane_latency get_latency(lane l) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return latency[l];
+    }
+
+    /// Clears the latency statistics of all lanes.
+    void reset_latency()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (lane_latency & stats : latency) { stats = lane_latency(); }
+    }
+
+  private:
+    template <typename F> void run(lane l, F f)
+    {
+      auto start = std::chrono::steady_clock::now();
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting[l]++;
+        cv.wait(lock, [&] { return !busy && !higher_lane_waiting(l); });
+        waiting[l]--;
+        busy = true;
+      }
+
+      // Do the transfer without holding the mutex so other threads can
+      // queue up behind it.
+      struct release_guard
+      {
+        shared_handle & self;
+        lane l;
+        std::chrono::steady_clock::time_point start;
+        ~release_guard()
+        {
+          uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+          {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            self.busy = false;
+            lane_latency & stats = self.latency[l];
+            stats.count++;
+            stats.total += us;
+            stats.last = us;
+            if (us > stats.max) { stats.max = us; }
+          }
+          self.cv.notify_all();
+        }
+      } guard { *this, l, start };
+
+      f();
+    }
+
+    bool higher_lane_waiting(lane l) const noexcept
+    {
+      for (int i = 0; i < l; i++)
+      {
+        if (waiting[i]) { return true; }
+      }
+      return false;
+    }
+
+    handle h;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool busy = false;
+    uint32_t waiting[lane_count] = {};
+    lane_latency latency[lane_count];
+  };
+}
@@ -0,0 +1,342 @@
+// Functions for detecting unusual behavior in the variables of a Jrk as they
+// are read, without keeping a history of them.
+
+#include "jrk_internal.h"
+
+#include <math.h>
+
+#define DEFAULT_TIME_CONSTANT 64
+#define DEFAULT_THRESHOLD 4
+#define DEFAULT_LEARNING_SAMPLES 1200
+
+// The current fit is not learned until the standard deviation of the duty
+// cycle magnitude over the learning samples is at least this much (5%).
+#define MIN_FIT_DUTY_CYCLE_STD_DEV 30
+
+typedef struct channel_stats
+{
+  uint32_t count;
+  double mean;
+  double variance;
+  double z_score;
+  double min_std_dev;
+} channel_stats;
+
+struct jrk_anomaly_detector
+{
+  double alpha;
+  double threshold;
+  uint32_t learning_samples;
+
+  channel_stats channels[JRK_ANOMALY_CHANNEL_COUNT];
+
+  // The last two feedback readings, for computing the feedback noise.
+  uint32_t feedback_count;
+  uint16_t feedback[2];
+
+  // Sums for the least-squares fit of current against the duty cycle
+  // magnitude, used while learning.
+  uint32_t fit_count;
+  double sum_x, sum_y, sum_xx, sum_xy, sum_yy;
+
+  // The fit, once it has been learned.
+  bool fit_ready;
+  double slope, intercept;
+};
+
+static const double default_min_std_dev[JRK_ANOMALY_CHANNEL_COUNT] = {
+  50,  // vin_voltage (mV)
+  50,  // current (mA)
+  2,   // error
+  2,   // feedback_noise
+  50,  // current_residual (mA)
+};
+
+static void reset(jrk_anomaly_detector * detector)
+{
+  for (size_t i = 0; i < JRK_ANOMALY_CHANNEL_COUNT; i++)
+  {
+    channel_stats * stats = &detector->channels[i];
+    stats->count = 0;
+    stats->mean = 0;
+    stats->variance = 0;
+    stats->z_score = 0;
+  }
+
+  detector->feedback_count = 0;
+
+  detector->fit_count = 0;
+  detector->sum_x = 0;
+  detector->sum_y = 0;
+  detector->sum_xx = 0;
+  detector->sum_xy = 0;
+  detector->sum_yy = 0;
+  detector->fit_ready = false;
+  detector->slope = 0;
+  detector->intercept = 0;
+}
+
+jrk_error * jrk_anomaly_detector_create(jrk_anomaly_detector ** detector)
+{
+  if (detector == NULL)
+  {
+    return jrk_error_create("Detector output pointer is null.");
+  }
+
+  *detector = NULL;
+
+  jrk_anomaly_detector * new_detector =
+    (jrk_anomaly_detector *)calloc(1, sizeof(jrk_anomaly_detector));
+  if (new_detector == NULL) { return &jrk_error_no_memory; }
+
+  new_detector->alpha = 1.0 / DEFAULT_TIME_CONSTANT;
+  new_detector->threshold = DEFAULT_THRESHOLD;
+  new_detector->learning_samples = DEFAULT_LEARNING_SAMPLES;
+  for (size_t i = 0; i < JRK_ANOMALY_CHANNEL_COUNT; i++)
+  {
+    new_detector->channels[i].min_std_dev = default_min_std_dev[i];
+  }
+  reset(new_detector);
+
+  *detector = new_detector;
+  return NULL;
+}
+
+void jrk_anomaly_detector_free(jrk_anomaly_detector * detector)
+{
+  free(detector);
+}
+
+void jrk_anomaly_detector_set_time_constant(jrk_anomaly_detector * detector,
+  uint32_t samples)
+{
+  if (detector == NULL) { return; }
+  if (samples == 0) { samples = DEFAULT_TIME_CONSTANT; }
+  detector->alpha = 1.0 / samples;
+}
+
+void jrk_anomaly_detector_set_threshold(jrk_anomaly_detector * detector,
+  double threshold)
+{
+  if (detector == NULL) { return; }
+  if (!(threshold > 0)) { threshold = DEFAULT_THRESHOLD; }
+  detector->threshold = threshold;
+}
+
+void jrk_anomaly_detector_set_learning_samples(
+  jrk_anomaly_detector * detector, uint32_t samples)
+{
+  if (detector == NULL) { return; }
+  if (samples < 2) { samples = 2; }
+  detector->learning_samples = samples;
+}
+
+void jrk_anomaly_detector_set_min_std_dev(jrk_anomaly_detector * detector,
+  uint8_t channel, double min_std_dev)
+{
+  if (detector == NULL || channel >= JRK_ANOMALY_CHANNEL_COUNT) { return; }
+  if (!(min_std_dev > 0)) { min_std_dev = default_min_std_dev[channel]; }
+  detector->channels[channel].min_std_dev = min_std_dev;
+}
+
+void jrk_anomaly_detector_restart(jrk_anomaly_detector * detector)
+{
+  if (detector == NULL) { return; }
+  reset(detector);
+}
+
+static double std_dev(const channel_stats * stats)
+{
+  double sd = sqrt(stats->variance);
+  return sd < stats->min_std_dev ? stats->min_std_dev : sd;
+}
+
+// Scores a value against the exponentially-weighted mean and variance of its
+// channel and then adds it to them.  Returns true if the channel is past its
+// learning period and the value is an outlier.
+static bool update_channel(const jrk_anomaly_detector * detector,
+  channel_stats * stats, double value)
+{
+  if (stats->count == 0)
+  {
+    stats->mean = value;
+    stats->variance = 0;
+    stats->z_score = 0;
+    stats->count = 1;
+    return false;
+  }
+
+  double alpha = detector->alpha;
+  double diff = value - stats->mean;
+  stats->z_score = diff / std_dev(stats);
+  stats->mean += alpha * diff;
+  stats->variance = (1 - alpha) * (stats->variance + alpha * diff * diff);
+
+  if (stats->count < detector->learning_samples)
+  {
+    stats->count++;
+    return false;
+  }
+  return fabs(stats->z_score) > detector->threshold;
+}
+
+// Fits current = slope * |duty cycle| + intercept over the learning period
+// (extended until the duty cycle has varied enough), then tracks how far the
+// current is from that fit.
+//
+// The mean of the current_residual channel is an exponentially-weighted
+// average of the residuals, and its variance is the variance of the
+// residuals over the learning period.  The z-score compares the average to
+// the standard deviation an average of that many residuals would have if
+// nothing changed, so it picks up small but persistent drifts, like the
+// extra current needed when friction rises.
+static bool update_fit(jrk_anomaly_detector * detector, double x, double y)
+{
+  channel_stats * stats = &detector->channels[JRK_ANOMALY_CHANNEL_CURRENT_RESIDUAL];
+
+  if (!detector->fit_ready)
+  {
+    detector->fit_count++;
+    detector->sum_x += x;
+    detector->sum_y += y;
+    detector->sum_xx += x * x;
+    detector->sum_xy += x * y;
+    detector->sum_yy += y * y;
+    if (detector->fit_count < detector->learning_samples) { return false; }
+
+    double n = detector->fit_count;
+    double sxx = detector->sum_xx - detector->sum_x * detector->sum_x / n;
+    double sxy = detector->sum_xy - detector->sum_x * detector->sum_y / n;
+    double syy = detector->sum_yy - detector->sum_y * detector->sum_y / n;
+
+    // A fit learned while the duty cycle barely changed (e.g. while the
+    // motor was idle) would have no slope, so every sample after the motor
+    // started running would look like an anomaly.  Keep learning until the
+    // duty cycle has varied enough.
+    if (sxx / n < MIN_FIT_DUTY_CYCLE_STD_DEV * MIN_FIT_DUTY_CYCLE_STD_DEV)
+    {
+      return false;
+    }
+
+    detector->slope = sxy / sxx;
+    detector->intercept = (detector->sum_y - detector->slope * detector->sum_x) / n;
+    double residual_variance = (syy - detector->slope * sxy) / n;
+
+    detector->fit_ready = true;
+    stats->count = detector->fit_count;
+    stats->mean = 0;
+    stats->variance = residual_variance > 0 ? residual_variance : 0;
+    stats->z_score = 0;
+    return false;
+  }
+
+  double alpha = detector->alpha;
+  double residual = y - (detector->slope * x + detector->intercept);
+  stats->mean += alpha * (residual - stats->mean);
+  stats->z_score = stats->mean /
+    (std_dev(stats) * sqrt(alpha / (2 - alpha)));
+  return fabs(stats->z_score) > detector->threshold;
+}
+
+uint32_t jrk_anomaly_detector_add_sample(jrk_anomaly_detector * detector,
+  const jrk_variables * vars)
+{
+  if (detector == NULL || vars == NULL) { return 0; }
+
+  uint32_t alerts = 0;
+
+  if (update_channel(detector,
+      &detector->channels[JRK_ANOMALY_CHANNEL_VIN_VOLTAGE],
+      jrk_variables_get_vin_voltage(vars)))
+  {
+    alerts |= 1 << JRK_ANOMALY_CHANNEL_VIN_VOLTAGE;
+  }
+
+  if (update_channel(detector,
+      &detector->channels[JRK_ANOMALY_CHANNEL_CURRENT],
+      jrk_variables_get_current(vars)))
+  {
+    alerts |= 1 << JRK_ANOMALY_CHANNEL_CURRENT;
+  }
+
+  if (update_channel(detector,
+      &detector->channels[JRK_ANOMALY_CHANNEL_ERROR],
+      jrk_variables_get_error(vars)))
+  {
+    alerts |= 1 << JRK_ANOMALY_CHANNEL_ERROR;
+  }
+
+  // The second difference of the feedback is zero while the feedback is
+  // steady or changing at a constant rate, so it is mostly noise.
+  uint16_t feedback = jrk_variables_get_feedback(vars);
+  if (detector->feedback_count >= 2)
+  {
+    double noise = (double)feedback - 2.0 * detector->feedback[1] +
+      detector->feedback[0];
+    if (update_channel(detector,
+        &detector->channels[JRK_ANOMALY_CHANNEL_FEEDBACK_NOISE], noise))
+    {
+      alerts |= 1 << JRK_ANOMALY_CHANNEL_FEEDBACK_NOISE;
+    }
+  }
+  else
+  {
+    detector->feedback_count++;
+  }
+  detector->feedback[0] = detector->feedback[1];
+  detector->feedback[1] = feedback;
+
+  int16_t duty_cycle = jrk_variables_get_duty_cycle(vars);
+  if (update_fit(detector, duty_cycle < 0 ? -duty_cycle : duty_cycle,
+      jrk_variables_get_current(vars)))
+  {
+    alerts |= 1 << JRK_ANOMALY_CHANNEL_CURRENT_RESIDUAL;
+  }
+
+  return alerts;
+}
+
+double jrk_anomaly_detector_get_mean(const jrk_anomaly_detector * detector,
+  uint8_t channel)
+{
+  if (detector == NULL || channel >= JRK_ANOMALY_CHANNEL_COUNT) { return 0; }
+  return detector->channels[channel].mean;
+}
+
+double jrk_anomaly_detector_get_std_dev(const jrk_anomaly_detector * detector,
+  uint8_t channel)
+{
+  if (detector == NULL || channel >= JRK_ANOMALY_CHANNEL_COUNT) { return 0; }
+  return sqrt(detector->channels[channel].variance);
+}
+
+double jrk_anomaly_detector_get_z_score(const jrk_anomaly_detector * detector,
+  uint8_t channel)
+{
+  if (detector == NULL || channel >= JRK_ANOMALY_CHANNEL_COUNT) { return 0; }
+  return detector->channels[channel].z_score;
+}
+
+bool jrk_anomaly_detector_get_fit(const jrk_anomaly_detector * detector,
+  double * slope, double * intercept)
+{
+  if (slope) { *slope = 0; }
+  if (intercept) { *intercept = 0; }
+  if (detector == NULL || !detector->fit_ready) { return false; }
+  if (slope) { *slope = detector->slope; }
+  if (intercept) { *intercept = detector->intercept; }
+  return true;
+}
+
+const char * jrk_look_up_anomaly_channel_name(uint8_t channel)
+{
+  switch (channel)
+  {
+  case JRK_ANOMALY_CHANNEL_VIN_VOLTAGE: return "vin_voltage";
+  case JRK_ANOMALY_CHANNEL_CURRENT: return "current";
+  case JRK_ANOMALY_CHANNEL_ERROR: return "error";
+  case JRK_ANOMALY_CHANNEL_FEEDBACK_NOISE: return "feedback_noise";
+  case JRK_ANOMALY_CHANNEL_CURRENT_RESIDUAL: return "current_residual";
+  default: return "";
+  }
+}
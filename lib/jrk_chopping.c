@@ -0,0 +1,365 @@
+// Functions for reconstructing current chopping episodes from the current
+// chopping counters in the Jrk's variables.
+
+#include "jrk_internal.h"
+
+#define DEFAULT_LOG_CAPACITY 256
+
+// The current chopping counters stop at this value instead of overflowing.
+#define COUNT_MAX 255
+
+struct jrk_chopping_tracker
+{
+  uint16_t pid_period;
+
+  // The most recent episodes, in a ring buffer.
+  jrk_chopping_episode * log;
+  size_t log_capacity;
+  size_t log_start;
+  size_t log_size;
+
+  uint32_t episode_count;
+  uint64_t total_duration;
+  uint32_t duration_histogram[JRK_CHOPPING_DURATION_BIN_COUNT];
+  uint32_t duty_cycle_histogram[JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT];
+
+  // The episode that was still going on at the last sample, if any.
+  bool open;
+  jrk_chopping_episode current;
+
+  // The consecutive count from the last sample.
+  uint8_t last_consecutive_count;
+  uint64_t last_time;
+  bool has_last_sample;
+};
+
+jrk_error * jrk_chopping_tracker_create(size_t log_capacity,
+  jrk_chopping_tracker ** tracker)
+{
+  if (tracker == NULL)
+  {
+    return jrk_error_create("Tracker output pointer is null.");
+  }
+
+  *tracker = NULL;
+
+  if (log_capacity == 0) { log_capacity = DEFAULT_LOG_CAPACITY; }
+
+  jrk_chopping_tracker * new_tracker =
+    (jrk_chopping_tracker *)calloc(1, sizeof(jrk_chopping_tracker));
+  if (new_tracker == NULL) { return &jrk_error_no_memory; }
+
+  new_tracker->log = (jrk_chopping_episode *)calloc(log_capacity,
+    sizeof(jrk_chopping_episode));
+  if (new_tracker->log == NULL)
+  {
+    free(new_tracker);
+    return &jrk_error_no_memory;
+  }
+
+  new_tracker->log_capacity = log_capacity;
+  new_tracker->pid_period = 10;
+
+  *tracker = new_tracker;
+  return NULL;
+}
+
+void jrk_chopping_tracker_free(jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return; }
+  free(tracker->log);
+  free(tracker);
+}
+
+void jrk_chopping_tracker_set_pid_period(jrk_chopping_tracker * tracker,
+  uint16_t pid_period)
+{
+  if (tracker == NULL || pid_period == 0) { return; }
+  tracker->pid_period = pid_period;
+}
+
+void jrk_chopping_tracker_clear(jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return; }
+  tracker->log_start = 0;
+  tracker->log_size = 0;
+  tracker->episode_count = 0;
+  tracker->total_duration = 0;
+  memset(tracker->duration_histogram, 0, sizeof(tracker->duration_histogram));
+  memset(tracker->duty_cycle_histogram, 0,
+    sizeof(tracker->duty_cycle_histogram));
+  tracker->open = false;
+  tracker->has_last_sample = false;
+}
+
+static uint8_t duration_bin(uint32_t duration)
+{
+  uint8_t bin = 0;
+  while (duration > 1 && bin < JRK_CHOPPING_DURATION_BIN_COUNT - 1)
+  {
+    duration >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+static uint8_t duty_cycle_bin(int16_t duty_cycle)
+{
+  uint32_t magnitude = duty_cycle < 0 ? -duty_cycle : duty_cycle;
+  uint32_t bin = magnitude * JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT / 600;
+  if (bin >= JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT)
+  {
+    bin = JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT - 1;
+  }
+  return bin;
+}
+
+static void record_episode(jrk_chopping_tracker * tracker,
+  const jrk_chopping_episode * episode)
+{
+  if (episode->duration == 0) { return; }
+
+  size_t index = (tracker->log_start + tracker->log_size) % tracker->log_capacity;
+  tracker->log[index] = *episode;
+  if (tracker->log_size < tracker->log_capacity)
+  {
+    tracker->log_size++;
+  }
+  else
+  {
+    tracker->log_start = (tracker->log_start + 1) % tracker->log_capacity;
+  }
+
+  if (tracker->episode_count < UINT32_MAX) { tracker->episode_count++; }
+  tracker->total_duration += episode->duration;
+  uint32_t * d = &tracker->duration_histogram[duration_bin(episode->duration)];
+  if (*d < UINT32_MAX) { (*d)++; }
+  uint32_t * c = &tracker->duty_cycle_histogram[duty_cycle_bin(episode->duty_cycle)];
+  if (*c < UINT32_MAX) { (*c)++; }
+}
+
+static void start_episode(jrk_chopping_tracker * tracker,
+  const jrk_variables * vars, uint64_t time, uint8_t periods)
+{
+  jrk_chopping_episode * e = &tracker->current;
+  memset(e, 0, sizeof(jrk_chopping_episode));
+  uint64_t elapsed = (uint64_t)periods * tracker->pid_period;
+  e->start_time = time > elapsed ? time - elapsed : 0;
+  e->duration = periods;
+  e->peak_raw_current = jrk_variables_get_raw_current(vars);
+  e->peak_current = jrk_variables_get_current(vars);
+  e->duty_cycle = jrk_variables_get_duty_cycle(vars);
+  if (periods == COUNT_MAX) { e->flags |= JRK_CHOPPING_EPISODE_FLAG_STARTED_EARLIER; }
+  tracker->open = true;
+}
+
+// Records chopping that started and ended entirely between two samples.  We
+// only know how many PID periods it took, not whether it was one episode or
+// several, so it is recorded as one episode.
+static void record_unseen_episode(jrk_chopping_tracker * tracker,
+  const jrk_variables * vars, uint64_t time, uint32_t periods)
+{
+  jrk_chopping_episode e;
+  memset(&e, 0, sizeof(e));
+  e.start_time = tracker->has_last_sample ? tracker->last_time : time;
+  e.duration = periods;
+  e.peak_raw_current = jrk_variables_get_raw_current(vars);
+  e.peak_current = jrk_variables_get_current(vars);
+  e.duty_cycle = jrk_variables_get_duty_cycle(vars);
+  e.flags = JRK_CHOPPING_EPISODE_FLAG_BETWEEN_SAMPLES;
+  record_episode(tracker, &e);
+}
+
+void jrk_chopping_tracker_add_sample(jrk_chopping_tracker * tracker,
+  const jrk_variables * vars, uint64_t time)
+{
+  if (tracker == NULL || vars == NULL) { return; }
+
+  // occurrences: PID periods with chopping since the last sample (the
+  // caller clears the counter with each read).
+  // consecutive: the length of the run of chopping periods that ends now.
+  uint8_t occurrences = jrk_variables_get_current_chopping_occurrence_count(vars);
+  uint8_t consecutive = jrk_variables_get_current_chopping_consecutive_count(vars);
+
+  // On the first sample, the occurrence count covers some unknown time before
+  // we started watching, so ignore it.
+  if (!tracker->has_last_sample) { occurrences = consecutive; }
+
+  if (tracker->open)
+  {
+    uint32_t expected = (uint32_t)tracker->last_consecutive_count + occurrences;
+    bool continued = consecutive != 0 && (consecutive == expected ||
+      (consecutive == COUNT_MAX && expected >= COUNT_MAX));
+
+    if (continued)
+    {
+      tracker->current.duration += occurrences;
+    }
+    else
+    {
+      // The episode ended.  The chopping periods since the last sample that
+      // are not part of a new run are assumed to belong to it.
+      if (occurrences > consecutive)
+      {
+        tracker->current.duration += occurrences - consecutive;
+      }
+      record_episode(tracker, &tracker->current);
+      tracker->open = false;
+      if (consecutive != 0)
+      {
+        start_episode(tracker, vars, time, consecutive);
+      }
+    }
+  }
+  else if (consecutive != 0)
+  {
+    if (occurrences > consecutive)
+    {
+      record_unseen_episode(tracker, vars, time, occurrences - consecutive);
+    }
+    start_episode(tracker, vars, time, consecutive);
+  }
+  else if (occurrences != 0)
+  {
+    record_unseen_episode(tracker, vars, time, occurrences);
+  }
+
+  if (tracker->open && consecutive != 0)
+  {
+    uint16_t raw_current = jrk_variables_get_raw_current(vars);
+    uint16_t current = jrk_variables_get_current(vars);
+    if (raw_current > tracker->current.peak_raw_current)
+    {
+      tracker->current.peak_raw_current = raw_current;
+    }
+    if (current > tracker->current.peak_current)
+    {
+      tracker->current.peak_current = current;
+    }
+  }
+
+  tracker->last_consecutive_count = consecutive;
+  tracker->last_time = time;
+  tracker->has_last_sample = true;
+}
+
+bool jrk_chopping_tracker_is_chopping(const jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return false; }
+  return tracker->open;
+}
+
+uint32_t jrk_chopping_tracker_get_episode_count(
+  const jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return 0; }
+  return tracker->episode_count;
+}
+
+uint64_t jrk_chopping_tracker_get_total_duration(
+  const jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return 0; }
+  return tracker->total_duration;
+}
+
+size_t jrk_chopping_tracker_get_log_size(const jrk_chopping_tracker * tracker)
+{
+  if (tracker == NULL) { return 0; }
+  return tracker->log_size;
+}
+
+bool jrk_chopping_tracker_get_episode(const jrk_chopping_tracker * tracker,
+  size_t index, jrk_chopping_episode * episode)
+{
+  if (tracker == NULL || episode == NULL || index >= tracker->log_size)
+  {
+    return false;
+  }
+  *episode = tracker->log[(tracker->log_start + index) % tracker->log_capacity];
+  return true;
+}
+
+uint32_t jrk_chopping_tracker_get_duration_histogram(
+  const jrk_chopping_tracker * tracker, uint8_t bin)
+{
+  if (tracker == NULL || bin >= JRK_CHOPPING_DURATION_BIN_COUNT) { return 0; }
+  return tracker->duration_histogram[bin];
+}
+
+uint32_t jrk_chopping_tracker_get_duty_cycle_histogram(
+  const jrk_chopping_tracker * tracker, uint8_t bin)
+{
+  if (tracker == NULL || bin >= JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT) { return 0; }
+  return tracker->duty_cycle_histogram[bin];
+}
+
+jrk_error * jrk_chopping_tracker_to_string(
+  const jrk_chopping_tracker * tracker, char ** string)
+{
+  if (string == NULL)
+  {
+    return jrk_error_create("String output pointer is null.");
+  }
+
+  *string = NULL;
+
+  if (tracker == NULL)
+  {
+    return jrk_error_create("Tracker pointer is null.");
+  }
+
+  jrk_string str;
+  jrk_string_setup(&str);
+
+  jrk_sprintf(&str, "# Current chopping episodes\n");
+  jrk_sprintf(&str, "episode_count: %u\n", tracker->episode_count);
+  jrk_sprintf(&str, "total_pid_periods: %llu\n",
+    (unsigned long long)tracker->total_duration);
+
+  jrk_sprintf(&str, "duration_histogram:\n");
+  for (uint8_t i = 0; i < JRK_CHOPPING_DURATION_BIN_COUNT; i++)
+  {
+    if (i == 0)
+    {
+      jrk_sprintf(&str, "  1: %u\n", tracker->duration_histogram[i]);
+    }
+    else if (i == JRK_CHOPPING_DURATION_BIN_COUNT - 1)
+    {
+      jrk_sprintf(&str, "  %u+: %u\n", 1u << i, tracker->duration_histogram[i]);
+    }
+    else
+    {
+      jrk_sprintf(&str, "  %u-%u: %u\n", 1u << i, (2u << i) - 1,
+        tracker->duration_histogram[i]);
+    }
+  }
+
+  jrk_sprintf(&str, "duty_cycle_histogram:\n");
+  for (uint8_t i = 0; i < JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT; i++)
+  {
+    jrk_sprintf(&str, "  %u%%-%u%%: %u\n",
+      i * 100 / JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT,
+      (i + 1) * 100 / JRK_CHOPPING_DUTY_CYCLE_BIN_COUNT,
+      tracker->duty_cycle_histogram[i]);
+  }
+
+  jrk_sprintf(&str, "# start_ms,pid_periods,peak_raw_current,"
+    "peak_current_ma,duty_cycle,flags\n");
+  for (size_t i = 0; i < tracker->log_size; i++)
+  {
+    const jrk_chopping_episode * e =
+      &tracker->log[(tracker->log_start + i) % tracker->log_capacity];
+    jrk_sprintf(&str, "%llu,%u,%u,%u,%d,%u\n",
+      (unsigned long long)e->start_time, e->duration, e->peak_raw_current,
+      e->peak_current, e->duty_cycle, e->flags);
+  }
+
+  if (str.data == NULL)
+  {
+    return &jrk_error_no_memory;
+  }
+
+  *string = str.data;
+  return NULL;
+}
@@ -0,0 +1,234 @@
+// Functions for diagnosing intermittent problems by counting conditions over a
+// sliding window of time.
+
+#include "jrk_internal.h"
+
+// The window is divided into this many buckets.  When the oldest bucket
+// leaves the window, its counts are subtracted from the totals.
+#define BUCKET_COUNT 60
+
+#define DEFAULT_WINDOW 60000
+
+struct jrk_diagnosis_window
+{
+  uint32_t window;
+  uint32_t bucket_duration;
+
+  uint32_t counts[BUCKET_COUNT][JRK_DIAGNOSIS_CONDITION_COUNT];
+  uint32_t totals[JRK_DIAGNOSIS_CONDITION_COUNT];
+  size_t bucket;
+  uint64_t bucket_end_time;
+
+  bool has_last_sample;
+  uint16_t last_error_flags_halting;
+  uint8_t last_current_chopping_consecutive_count;
+  uint32_t last_up_time;
+};
+
+jrk_error * jrk_diagnosis_window_create(uint32_t window,
+  jrk_diagnosis_window ** diagnosis_window)
+{
+  if (diagnosis_window == NULL)
+  {
+    return jrk_error_create("Diagnosis window output pointer is null.");
+  }
+
+  *diagnosis_window = NULL;
+
+  if (window == 0) { window = DEFAULT_WINDOW; }
+  if (window < BUCKET_COUNT) { window = BUCKET_COUNT; }
+
+  jrk_diagnosis_window * new_window =
+    (jrk_diagnosis_window *)calloc(1, sizeof(jrk_diagnosis_window));
+  if (new_window == NULL) { return &jrk_error_no_memory; }
+
+  new_window->window = window;
+  new_window->bucket_duration = window / BUCKET_COUNT;
+
+  *diagnosis_window = new_window;
+  return NULL;
+}
+
+void jrk_diagnosis_window_free(jrk_diagnosis_window * diagnosis_window)
+{
+  free(diagnosis_window);
+}
+
+void jrk_diagnosis_window_clear(jrk_diagnosis_window * w)
+{
+  if (w == NULL) { return; }
+  memset(w->counts, 0, sizeof(w->counts));
+  memset(w->totals, 0, sizeof(w->totals));
+  w->bucket = 0;
+  w->bucket_end_time = 0;
+  w->has_last_sample = false;
+}
+
+// Moves the window forward so that the current bucket contains the specified
+// time, dropping the buckets that leave the window.
+static void advance(jrk_diagnosis_window * w, uint64_t time)
+{
+  if (w->bucket_end_time == 0 || time + w->window < w->bucket_end_time)
+  {
+    // This is the first sample, or the clock went backwards.
+    memset(w->counts, 0, sizeof(w->counts));
+    memset(w->totals, 0, sizeof(w->totals));
+    w->bucket = 0;
+    w->bucket_end_time = time + w->bucket_duration;
+    return;
+  }
+
+  size_t steps = 0;
+  while (time >= w->bucket_end_time && steps < BUCKET_COUNT)
+  {
+    w->bucket = (w->bucket + 1) % BUCKET_COUNT;
+    for (size_t i = 0; i < JRK_DIAGNOSIS_CONDITION_COUNT; i++)
+    {
+      w->totals[i] -= w->counts[w->bucket][i];
+      w->counts[w->bucket][i] = 0;
+    }
+    w->bucket_end_time += w->bucket_duration;
+    steps++;
+  }
+
+  if (time >= w->bucket_end_time)
+  {
+    // There was a long gap, so every bucket was dropped.
+    w->bucket_end_time = time + w->bucket_duration;
+  }
+}
+
+static void count(jrk_diagnosis_window * w, uint8_t condition)
+{
+  w->counts[w->bucket][condition]++;
+  w->totals[condition]++;
+}
+
+void jrk_diagnosis_window_add_sample(jrk_diagnosis_window * w,
+  const jrk_variables * vars, uint64_t time)
+{
+  if (w == NULL || vars == NULL) { return; }
+
+  advance(w, time);
+
+  uint16_t halting = jrk_variables_get_error_flags_halting(vars);
+  uint16_t occurred = jrk_variables_get_error_flags_occurred(vars);
+  uint8_t chopping_occurrences =
+    jrk_variables_get_current_chopping_occurrence_count(vars);
+  uint8_t chopping_consecutive =
+    jrk_variables_get_current_chopping_consecutive_count(vars);
+  uint32_t up_time = jrk_variables_get_up_time(vars);
+
+  // The counters in the first sample cover some unknown time before we
+  // started watching, so we only use it as a reference for the next one.
+  if (w->has_last_sample)
+  {
+    // Count each error when it starts.  An error that is still stopping the
+    // motor from the last sample is not counted again, but one that went
+    // away and came back between two samples is.
+    uint16_t new_errors = occurred & ~w->last_error_flags_halting &
+      ~(1 << JRK_ERROR_AWAITING_COMMAND);
+    for (uint8_t bit = 0; bit < 16; bit++)
+    {
+      if (new_errors & (1 << bit)) { count(w, bit); }
+    }
+
+    if (jrk_variables_get_pid_period_exceeded(vars))
+    {
+      count(w, JRK_DIAGNOSIS_CONDITION_PID_PERIOD_EXCEEDED);
+    }
+
+    if (chopping_occurrences && w->last_current_chopping_consecutive_count == 0)
+    {
+      count(w, JRK_DIAGNOSIS_CONDITION_CURRENT_CHOPPING);
+    }
+
+    if (up_time < w->last_up_time)
+    {
+      count(w, JRK_DIAGNOSIS_CONDITION_DEVICE_RESET);
+    }
+  }
+
+  w->has_last_sample = true;
+  w->last_error_flags_halting = halting;
+  w->last_current_chopping_consecutive_count = chopping_consecutive;
+  w->last_up_time = up_time;
+}
+
+uint32_t jrk_diagnosis_window_get_count(const jrk_diagnosis_window * w,
+  uint8_t condition)
+{
+  if (w == NULL || condition >= JRK_DIAGNOSIS_CONDITION_COUNT) { return 0; }
+  return w->totals[condition];
+}
+
+const char * jrk_look_up_diagnosis_condition_name_ui(uint8_t condition)
+{
+  if (condition < 16)
+  {
+    return jrk_look_up_error_name_ui(1 << condition);
+  }
+
+  switch (condition)
+  {
+  case JRK_DIAGNOSIS_CONDITION_PID_PERIOD_EXCEEDED:
+    return "PID period exceeded";
+  case JRK_DIAGNOSIS_CONDITION_CURRENT_CHOPPING:
+    return "Current chopping";
+  case JRK_DIAGNOSIS_CONDITION_DEVICE_RESET:
+    return "Device reset";
+  default:
+    return "(Unknown)";
+  }
+}
+
+jrk_error * jrk_diagnosis_window_get_findings(const jrk_diagnosis_window * w,
+  char ** findings)
+{
+  if (findings == NULL)
+  {
+    return jrk_error_create("Findings output pointer is null.");
+  }
+
+  *findings = NULL;
+
+  if (w == NULL)
+  {
+    return jrk_error_create("Diagnosis window is null.");
+  }
+
+  // Sort the conditions that happened by how often they happened, most
+  // often first.  Ties keep the order of the conditions.
+  uint8_t order[JRK_DIAGNOSIS_CONDITION_COUNT];
+  size_t found = 0;
+  for (uint8_t i = 0; i < JRK_DIAGNOSIS_CONDITION_COUNT; i++)
+  {
+    if (w->totals[i] == 0) { continue; }
+    size_t j = found++;
+    while (j > 0 && w->totals[order[j - 1]] < w->totals[i])
+    {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  jrk_string str;
+  jrk_string_setup(&str);
+
+  for (size_t i = 0; i < found; i++)
+  {
+    uint32_t n = w->totals[order[i]];
+    jrk_sprintf(&str, "%s %u %s in the last %u s.\n",
+      jrk_look_up_diagnosis_condition_name_ui(order[i]),
+      n, n == 1 ? "time" : "times", w->window / 1000);
+  }
+
+  if (str.data == NULL)
+  {
+    return &jrk_error_no_memory;
+  }
+
+  *findings = str.data;
+  return NULL;
+}
@@ -410,6 +410,30 @@ static void write_buffer_to_settings(const uint8_t * buf, jrk_settings * setting
   }
 }
 
+jrk_error * jrk_settings_decode(const uint8_t * buf, size_t len,
+  jrk_settings * settings)
+{
+  if (buf == NULL)
+  {
+    return jrk_error_create("Settings buffer is null.");
+  }
+
+  if (settings == NULL)
+  {
+    return jrk_error_create("Settings pointer is null.");
+  }
+
+  if (len < JRK_SETTINGS_SIZE)
+  {
+    return jrk_error_create(
+      "Settings buffer is too short: expected %u bytes, got %u.",
+      (unsigned int)JRK_SETTINGS_SIZE, (unsigned int)len);
+  }
+
+  write_buffer_to_settings(buf, settings);
+  return NULL;
+}
+
 jrk_error * jrk_get_eeprom_settings(jrk_handle * handle, jrk_settings ** settings)
 {
   if (settings == NULL)
@@ -469,10 +493,15 @@ jrk_error * jrk_get_eeprom_settings(jrk_handle * handle, jrk_settings ** setting
     }
   }
 
+  // Decode the buffer.
+  if (error == NULL)
+  {
+    error = jrk_settings_decode(buf, sizeof(buf), new_settings);
+  }
+
   // Pass the new settings to the caller.
   if (error == NULL)
   {
-    write_buffer_to_settings(buf, new_settings);
     *settings = new_settings;
     new_settings = NULL;
   }
@@ -542,10 +571,15 @@ jrk_error * jrk_get_ram_settings(jrk_handle * handle, jrk_settings ** settings)
     }
   }
 
+  // Decode the buffer.
+  if (error == NULL)
+  {
+    error = jrk_settings_decode(buf, sizeof(buf), new_settings);
+  }
+
   // Pass the new settings to the caller.
   if (error == NULL)
   {
-    write_buffer_to_settings(buf, new_settings);
     *settings = new_settings;
     new_settings = NULL;
   }
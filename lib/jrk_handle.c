@@ -9,6 +9,15 @@ struct jrk_handle
   char * cached_firmware_version_string;
 };
 
+// Does a control transfer with a setup packet from jrk_codec.h.
+static jrk_error * control_transfer(jrk_handle * handle,
+  jrk_usb_setup setup, void * buffer, size_t * transferred)
+{
+  return jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
+    setup.request_type, setup.request, setup.value, setup.index,
+    buffer, setup.length, transferred));
+}
+
 jrk_error * jrk_handle_open(const jrk_device * device, jrk_handle ** handle)
 {
   if (handle == NULL)
@@ -170,10 +179,13 @@ const char * jrk_get_firmware_version_string(jrk_handle * handle)
 jrk_error * jrk_set_eeprom_setting_byte(jrk_handle * handle,
   uint8_t address, uint8_t byte)
 {
-  assert(handle != NULL);
+  if (handle == NULL)
+  {
+    return jrk_error_create("Handle is null.");
+  }
 
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_SET_EEPROM_SETTING, byte, address, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_set_eeprom_setting(address, byte), NULL, NULL);
 
   if (error != NULL)
   {
@@ -190,16 +202,11 @@ jrk_error * jrk_set_target(jrk_handle * handle, uint16_t target)
     return jrk_error_create("Handle is null.");
   }
 
-  // Cap the value since the firmware doesn't cap it, it could concievably
-  // cause some minor problems if people set targets outside of the allowed
-  // range, and the Arduino library does it.
-  if (target > 4095)
-  {
-    target = 4095;
-  }
-
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_SET_TARGET_USB, target, 0, NULL, 0, NULL));
+  // The codec caps the value since the firmware doesn't cap it, it could
+  // conceivably cause some minor problems if people set targets outside of
+  // the allowed range, and the Arduino library does it.
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_set_target(target), NULL, NULL);
 
   if (error != NULL)
   {
@@ -217,8 +224,8 @@ jrk_error * jrk_stop_motor(jrk_handle * handle)
     return jrk_error_create("Handle is null.");
   }
 
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_STOP_MOTOR_USB, 0, 0, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_stop_motor(), NULL, NULL);
 
   if (error != NULL)
   {
@@ -296,11 +303,8 @@ jrk_error * jrk_force_duty_cycle_target(jrk_handle * handle, int16_t duty_cycle)
     return jrk_error_create("Handle is null.");
   }
 
-  if (duty_cycle > 600) { duty_cycle = 600; }
-  if (duty_cycle < -600) { duty_cycle = -600; }
-
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_FORCE_DUTY_CYCLE_TARGET, duty_cycle, 0, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_force_duty_cycle_target(duty_cycle), NULL, NULL);
 
   if (error != NULL)
   {
@@ -318,11 +322,8 @@ jrk_error * jrk_force_duty_cycle(jrk_handle * handle, int16_t duty_cycle)
     return jrk_error_create("Handle is null.");
   }
 
-  if (duty_cycle > 600) { duty_cycle = 600; }
-  if (duty_cycle < -600) { duty_cycle = -600; }
-
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_FORCE_DUTY_CYCLE, duty_cycle, 0, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_force_duty_cycle(duty_cycle), NULL, NULL);
 
   if (error != NULL)
   {
@@ -364,8 +365,8 @@ jrk_error * jrk_get_eeprom_setting_segment(jrk_handle * handle,
   }
 
   size_t transferred;
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0xC0, JRK_CMD_GET_EEPROM_SETTINGS, 0, index, output, length, &transferred));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_get_eeprom_settings(index, length), output, &transferred);
   if (error != NULL)
   {
     error = jrk_error_add(error, "There was an error reading settings.");
@@ -415,9 +416,8 @@ jrk_error * jrk_get_ram_setting_segment(jrk_handle * handle,
   }
 
   size_t transferred;
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0xC0, JRK_CMD_GET_RAM_SETTINGS, 0, index,
-    output, length, &transferred));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_get_ram_settings(index, length), output, &transferred);
   if (error != NULL)
   {
     error = jrk_error_add(error, "There was an error reading RAM settings.");
@@ -467,9 +467,9 @@ jrk_error * jrk_set_ram_setting_segment(jrk_handle * handle,
   }
 
   size_t transferred;
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_SET_RAM_SETTINGS, 0, index,
-    (uint8_t *)input, length, &transferred));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_set_ram_settings(index, length), (uint8_t *)input,
+    &transferred);
   if (error != NULL)
   {
     error = jrk_error_add(error, "There was an error settings RAM settings.");
@@ -517,8 +517,8 @@ jrk_error * jrk_get_variable_segment(jrk_handle * handle,
   }
 
   size_t transferred;
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0xC0, JRK_CMD_GET_VARIABLES, flags, index, output, length, &transferred));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_get_variables(index, length, flags), output, &transferred);
   if (error != NULL)
   {
     error = jrk_error_add(error, "There was an error reading variables.");
@@ -603,8 +603,8 @@ jrk_error * jrk_reinitialize_core(jrk_handle * handle, uint16_t flags)
     return jrk_error_create("Handle is null.");
   }
 
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_REINITIALIZE, flags, 0, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_reinitialize(flags), NULL, NULL);
 
   if (error != NULL)
   {
@@ -633,8 +633,8 @@ jrk_error * jrk_start_bootloader(jrk_handle * handle)
     return jrk_error_create("Handle is null.");
   }
 
-  jrk_error * error = jrk_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, JRK_CMD_START_BOOTLOADER, 0, 0, NULL, 0, NULL));
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_start_bootloader(), NULL, NULL);
 
   if (error != NULL)
   {
@@ -663,12 +663,12 @@ jrk_error * jrk_get_debug_data(jrk_handle * handle, uint8_t * data, size_t * siz
   }
 
   size_t transferred;
-  libusbp_error * usb_error = libusbp_control_transfer(handle->usb_handle,
-    0xC0, JRK_CMD_GET_DEBUG_DATA, 0, 0, data, *size, &transferred);
-  if (usb_error)
+  jrk_error * error = control_transfer(handle,
+    jrk_codec_usb_get_debug_data(*size), data, &transferred);
+  if (error != NULL)
   {
     *size = 0;
-    return jrk_usb_error(usb_error);
+    return error;
   }
 
   *size = transferred;
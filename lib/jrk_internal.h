@@ -1,6 +1,7 @@
 #pragma once
 
 #include <jrk.h>
+#include <jrk_codec.h>
 #include <config.h>
 
 #include <libusbp.h>
@@ -38,6 +39,7 @@ typedef struct jrk_string
 
 void jrk_string_setup(jrk_string *);
 void jrk_string_setup_dummy(jrk_string *);
+char * jrk_string_duplicate(const char *);
 JRK_PRINTF(2, 3)
 void jrk_sprintf(jrk_string *, const char * format, ...);
 
@@ -85,15 +87,6 @@ const libusbp_generic_interface *
 jrk_device_get_generic_interface(const jrk_device * device);
 
 
-// Internal jrk_handle functions.
-
-jrk_error * jrk_set_eeprom_setting_byte(jrk_handle * handle,
-  uint8_t address, uint8_t byte);
-
-jrk_error * jrk_get_eeprom_setting_segment(jrk_handle * handle,
-  size_t index, size_t length, uint8_t * output);
-
-
 // Error creation functions.
 
 jrk_error * jrk_error_add_code(jrk_error * error, uint32_t code);
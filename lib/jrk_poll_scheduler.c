@@ -0,0 +1,274 @@
+// Functions for deciding when to read the variables of each of several Jrks,
+// so that moving axes are read often and idle ones are not.
+
+#include "jrk_internal.h"
+
+#define DEFAULT_MIN_PERIOD 10
+#define DEFAULT_MAX_PERIOD 500
+#define DEFAULT_BUDGET 200
+#define DEFAULT_DEADBAND 2
+
+typedef struct device_state
+{
+  // The period we would like to use for this device if the budget allows it.
+  uint32_t period;
+
+  // The time of the next read.
+  uint64_t due;
+
+  // The previous sample, for detecting changes.
+  bool has_last_sample;
+  uint16_t last_target;
+  int16_t last_error;
+  int16_t last_duty_cycle;
+  uint16_t last_error_flags_halting;
+} device_state;
+
+struct jrk_poll_scheduler
+{
+  uint32_t min_period;
+  uint32_t max_period;
+  uint32_t budget;
+  uint16_t deadband;
+
+  // The sum of the rates of all devices at their preferred periods, in
+  // reads per 1000 seconds.  Integers keep this from drifting as it is
+  // updated.
+  uint64_t total_rate;
+
+  size_t device_count;
+  device_state devices[];
+};
+
+static uint64_t rate(uint32_t period)
+{
+  return 1000000 / period;
+}
+
+static void compute_total_rate(jrk_poll_scheduler * scheduler)
+{
+  scheduler->total_rate = 0;
+  for (size_t i = 0; i < scheduler->device_count; i++)
+  {
+    scheduler->total_rate += rate(scheduler->devices[i].period);
+  }
+}
+
+jrk_error * jrk_poll_scheduler_create(size_t device_count,
+  jrk_poll_scheduler ** scheduler)
+{
+  if (scheduler == NULL)
+  {
+    return jrk_error_create("Scheduler output pointer is null.");
+  }
+
+  *scheduler = NULL;
+
+  if (device_count == 0)
+  {
+    return jrk_error_create("The scheduler needs at least one device.");
+  }
+
+  jrk_poll_scheduler * new_scheduler = (jrk_poll_scheduler *)calloc(1,
+    sizeof(jrk_poll_scheduler) + device_count * sizeof(device_state));
+  if (new_scheduler == NULL) { return &jrk_error_no_memory; }
+
+  new_scheduler->min_period = DEFAULT_MIN_PERIOD;
+  new_scheduler->max_period = DEFAULT_MAX_PERIOD;
+  new_scheduler->budget = DEFAULT_BUDGET;
+  new_scheduler->deadband = DEFAULT_DEADBAND;
+  new_scheduler->device_count = device_count;
+
+  // Start every device at the fastest period: we don't know what any of them
+  // are doing yet.
+  for (size_t i = 0; i < device_count; i++)
+  {
+    new_scheduler->devices[i].period = DEFAULT_MIN_PERIOD;
+  }
+  compute_total_rate(new_scheduler);
+
+  *scheduler = new_scheduler;
+  return NULL;
+}
+
+void jrk_poll_scheduler_free(jrk_poll_scheduler * scheduler)
+{
+  free(scheduler);
+}
+
+void jrk_poll_scheduler_set_period_range(jrk_poll_scheduler * scheduler,
+  uint32_t min_period, uint32_t max_period)
+{
+  if (scheduler == NULL) { return; }
+  if (min_period == 0) { min_period = DEFAULT_MIN_PERIOD; }
+  if (max_period == 0) { max_period = DEFAULT_MAX_PERIOD; }
+  if (max_period < min_period) { max_period = min_period; }
+  scheduler->min_period = min_period;
+  scheduler->max_period = max_period;
+
+  for (size_t i = 0; i < scheduler->device_count; i++)
+  {
+    device_state * device = &scheduler->devices[i];
+    if (device->period < min_period) { device->period = min_period; }
+    if (device->period > max_period) { device->period = max_period; }
+  }
+  compute_total_rate(scheduler);
+}
+
+void jrk_poll_scheduler_set_budget(jrk_poll_scheduler * scheduler,
+  uint32_t budget)
+{
+  if (scheduler == NULL) { return; }
+  scheduler->budget = budget;
+}
+
+void jrk_poll_scheduler_set_deadband(jrk_poll_scheduler * scheduler,
+  uint16_t deadband)
+{
+  if (scheduler == NULL) { return; }
+  scheduler->deadband = deadband;
+}
+
+size_t jrk_poll_scheduler_next(const jrk_poll_scheduler * scheduler,
+  uint64_t * due)
+{
+  if (scheduler == NULL)
+  {
+    if (due) { *due = 0; }
+    return 0;
+  }
+
+  size_t next = 0;
+  for (size_t i = 1; i < scheduler->device_count; i++)
+  {
+    if (scheduler->devices[i].due < scheduler->devices[next].due)
+    {
+      next = i;
+    }
+  }
+
+  if (due) { *due = scheduler->devices[next].due; }
+  return next;
+}
+
+static bool differs(int32_t a, int32_t b, uint16_t deadband)
+{
+  int32_t difference = a - b;
+  if (difference < 0) { difference = -difference; }
+  return difference > deadband;
+}
+
+// Returns true if the axis is doing something that is worth watching closely.
+static bool is_active(const jrk_poll_scheduler * scheduler,
+  const device_state * device, const jrk_variables * vars)
+{
+  if (!device->has_last_sample) { return true; }
+
+  uint16_t occurred = jrk_variables_get_error_flags_occurred(vars) &
+    ~(1 << JRK_ERROR_AWAITING_COMMAND);
+
+  return jrk_variables_get_target(vars) != device->last_target ||
+    differs(jrk_variables_get_error(vars), device->last_error,
+      scheduler->deadband) ||
+    differs(jrk_variables_get_duty_cycle(vars), device->last_duty_cycle,
+      scheduler->deadband) ||
+    jrk_variables_get_error_flags_halting(vars) !=
+      device->last_error_flags_halting ||
+    occurred != 0;
+}
+
+// Returns the period to use for a device, which is its preferred period
+// stretched if all of the devices together would use more than the budget.
+//
+// Every device keeps the rate of the maximum period if the budget allows it,
+// and the rest of the budget is shared in proportion to how much faster than
+// that each device wants to go.
+static uint32_t scaled_period(const jrk_poll_scheduler * scheduler,
+  uint32_t period)
+{
+  uint64_t budget_rate = (uint64_t)scheduler->budget * 1000;
+  uint64_t total_rate = scheduler->total_rate;
+  if (budget_rate == 0 || total_rate <= budget_rate)
+  {
+    return period;
+  }
+
+  uint64_t floor_rate = rate(scheduler->max_period);
+  uint64_t floor_total = floor_rate * scheduler->device_count;
+  uint64_t scaled_rate;
+  if (budget_rate > floor_total)
+  {
+    scaled_rate = floor_rate + (rate(period) - floor_rate) *
+      (budget_rate - floor_total) / (total_rate - floor_total);
+  }
+  else
+  {
+    // Even the maximum periods are too fast for the budget.
+    scaled_rate = rate(period) * budget_rate / total_rate;
+  }
+
+  if (scaled_rate == 0) { return 0xFFFFFFFF; }
+  return 1000000 / scaled_rate;
+}
+
+void jrk_poll_scheduler_add_sample(jrk_poll_scheduler * scheduler,
+  size_t index, const jrk_variables * vars, uint64_t time)
+{
+  if (scheduler == NULL || index >= scheduler->device_count) { return; }
+
+  device_state * device = &scheduler->devices[index];
+  uint32_t old_period = device->period;
+
+  if (vars == NULL)
+  {
+    // The read failed, so there is nothing to compare the next sample to,
+    // and no point in retrying quickly.
+    device->has_last_sample = false;
+    device->period = scheduler->max_period;
+  }
+  else if (is_active(scheduler, device, vars))
+  {
+    device->period = scheduler->min_period;
+  }
+  else
+  {
+    // Back off gradually so that a short pause in the motion does not drop
+    // the device to the slowest rate right away.
+    uint32_t period = device->period * 2;
+    if (period > scheduler->max_period) { period = scheduler->max_period; }
+    device->period = period;
+  }
+
+  if (vars != NULL)
+  {
+    device->has_last_sample = true;
+    device->last_target = jrk_variables_get_target(vars);
+    device->last_error = jrk_variables_get_error(vars);
+    device->last_duty_cycle = jrk_variables_get_duty_cycle(vars);
+    device->last_error_flags_halting =
+      jrk_variables_get_error_flags_halting(vars);
+  }
+
+  scheduler->total_rate -= rate(old_period);
+  scheduler->total_rate += rate(device->period);
+
+  device->due = time + scaled_period(scheduler, device->period);
+}
+
+uint32_t jrk_poll_scheduler_get_period(const jrk_poll_scheduler * scheduler,
+  size_t index)
+{
+  if (scheduler == NULL || index >= scheduler->device_count) { return 0; }
+  return scaled_period(scheduler, scheduler->devices[index].period);
+}
+
+double jrk_poll_scheduler_get_rate(const jrk_poll_scheduler * scheduler)
+{
+  if (scheduler == NULL) { return 0; }
+  double total = scheduler->total_rate / 1000.0;
+  if (scheduler->budget != 0 && total > scheduler->budget)
+  {
+    return scheduler->budget;
+  }
+  return total;
+}
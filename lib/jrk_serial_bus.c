@@ -0,0 +1,471 @@
+// Functions for driving several Jrks that share one serial line, using the
+// Pololu protocol and their device numbers.
+
+#include "jrk_internal.h"
+
+#define DEFAULT_TIMEOUT 20
+#define DEFAULT_TURNAROUND 3
+
+
+// After this many timeouts in a row, a device is only read once every
+// OFFLINE_READ_DIVIDER rounds so that missing devices do not use up the line.
+#define OFFLINE_TIMEOUT_COUNT 3
+#define OFFLINE_READ_DIVIDER 16
+
+// The longest packet we send: 0xAA, two device number bytes, the command,
+// two data bytes, and the CRC.  Packets that do not fit in the caller's
+// buffer wait for the next burst.
+#define MAX_PACKET_SIZE 7
+
+// Each byte on the line takes a start bit, 8 data bits, and a stop bit.
+#define BITS_PER_BYTE 10
+
+typedef struct bus_device
+{
+  uint16_t device_number;
+
+  bool target_pending;
+  uint16_t target;
+  bool stop_pending;
+
+  // The variables read so far, laid out like JRK_CMD_GET_VARIABLES returns
+  // them over USB.
+  uint8_t image[JRK_VARIABLES_SIZE];
+  uint64_t update_time;
+
+  jrk_serial_bus_device_stats stats;
+} bus_device;
+
+struct jrk_serial_bus
+{
+  uint32_t baud_rate;
+  uint32_t flags;
+  uint32_t timeout;
+  uint32_t turnaround;
+  uint8_t read_offset;
+  uint8_t read_length;
+
+  bus_device * devices;
+  size_t device_count;
+
+  // The device whose turn it is to be read.
+  size_t next_read;
+  uint32_t round;
+
+  // The read we are waiting for a response to, if any.
+  bool read_outstanding;
+  size_t read_device;
+  uint64_t read_deadline;
+  uint8_t response[JRK_CODEC_MAX_SERIAL_READ_LENGTH];
+  size_t response_length;
+
+  // Nothing is sent until the line has been quiet until this time.
+  bool quiet_pending;
+  uint64_t quiet_until;
+
+  // For measuring utilization.
+  bool started;
+  uint64_t start_time;
+  uint64_t tx_bytes;
+  uint64_t rx_bytes;
+  uint64_t unexpected_bytes;
+};
+
+jrk_error * jrk_serial_bus_create(uint32_t baud_rate, uint32_t flags,
+  jrk_serial_bus ** bus)
+{
+  if (bus == NULL)
+  {
+    return jrk_error_create("Serial bus output pointer is null.");
+  }
+
+  *bus = NULL;
+
+  if (baud_rate == 0)
+  {
+    return jrk_error_create("The baud rate is zero.");
+  }
+
+  jrk_serial_bus * new_bus = (jrk_serial_bus *)calloc(1, sizeof(jrk_serial_bus));
+  if (new_bus == NULL) { return &jrk_error_no_memory; }
+
+  new_bus->baud_rate = baud_rate;
+  new_bus->flags = flags;
+  new_bus->timeout = DEFAULT_TIMEOUT;
+  new_bus->turnaround = DEFAULT_TURNAROUND;
+  new_bus->read_offset = 0;
+  new_bus->read_length = JRK_CODEC_MAX_SERIAL_READ_LENGTH;
+
+  *bus = new_bus;
+  return NULL;
+}
+
+void jrk_serial_bus_free(jrk_serial_bus * bus)
+{
+  if (bus == NULL) { return; }
+  free(bus->devices);
+  free(bus);
+}
+
+jrk_error * jrk_serial_bus_add_device(jrk_serial_bus * bus,
+  uint16_t device_number, size_t * index)
+{
+  if (bus == NULL)
+  {
+    return jrk_error_create("Serial bus is null.");
+  }
+
+  uint16_t max = (bus->flags & JRK_SERIAL_BUS_FLAG_14BIT_DEVICE_NUMBER) ?
+    0x3FFF : 0x7F;
+  if (device_number > max)
+  {
+    return jrk_error_create("Invalid device number: %u.", device_number);
+  }
+
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    if (bus->devices[i].device_number == device_number)
+    {
+      return jrk_error_create("Device number %u was already added.",
+        device_number);
+    }
+  }
+
+  bus_device * devices = (bus_device *)realloc(bus->devices,
+    (bus->device_count + 1) * sizeof(bus_device));
+  if (devices == NULL) { return &jrk_error_no_memory; }
+  bus->devices = devices;
+
+  bus_device * device = &devices[bus->device_count];
+  memset(device, 0, sizeof(bus_device));
+  device->device_number = device_number;
+
+  if (index) { *index = bus->device_count; }
+  bus->device_count++;
+  return NULL;
+}
+
+size_t jrk_serial_bus_get_device_count(const jrk_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->device_count;
+}
+
+void jrk_serial_bus_set_timeout(jrk_serial_bus * bus, uint32_t timeout)
+{
+  if (bus == NULL) { return; }
+  if (timeout == 0) { timeout = DEFAULT_TIMEOUT; }
+  bus->timeout = timeout;
+}
+
+void jrk_serial_bus_set_turnaround(jrk_serial_bus * bus, uint32_t turnaround)
+{
+  if (bus == NULL) { return; }
+  bus->turnaround = turnaround;
+}
+
+jrk_error * jrk_serial_bus_set_read_segment(jrk_serial_bus * bus,
+  uint8_t offset, uint8_t length)
+{
+  if (bus == NULL)
+  {
+    return jrk_error_create("Serial bus is null.");
+  }
+
+  if (length == 0 || length > JRK_CODEC_MAX_SERIAL_READ_LENGTH)
+  {
+    return jrk_error_create(
+      "The read length must be between 1 and %u.", JRK_CODEC_MAX_SERIAL_READ_LENGTH);
+  }
+
+  if (offset + length > JRK_VARIABLES_SIZE)
+  {
+    return jrk_error_create("The read segment goes past the variables.");
+  }
+
+  bus->read_offset = offset;
+  bus->read_length = length;
+  return NULL;
+}
+
+void jrk_serial_bus_set_target(jrk_serial_bus * bus, size_t index,
+  uint16_t target)
+{
+  if (bus == NULL || index >= bus->device_count) { return; }
+  bus_device * device = &bus->devices[index];
+  device->target_pending = true;
+  device->target = target > 4095 ? 4095 : target;
+}
+
+void jrk_serial_bus_stop_motor(jrk_serial_bus * bus, size_t index)
+{
+  if (bus == NULL || index >= bus->device_count) { return; }
+  bus_device * device = &bus->devices[index];
+  device->stop_pending = true;
+
+  // A target sent after the stop would start the motor again.
+  device->target_pending = false;
+}
+
+static uint32_t codec_flags(const jrk_serial_bus * bus)
+{
+  uint32_t flags = JRK_CODEC_SERIAL_FLAG_POLOLU;
+  if (bus->flags & JRK_SERIAL_BUS_FLAG_14BIT_DEVICE_NUMBER)
+  {
+    flags |= JRK_CODEC_SERIAL_FLAG_14BIT_DEVICE_NUMBER;
+  }
+  if (bus->flags & JRK_SERIAL_BUS_FLAG_CRC)
+  {
+    flags |= JRK_CODEC_SERIAL_FLAG_CRC;
+  }
+  return flags;
+}
+
+// Picks the next device to read, skipping devices that seem to be missing
+// except once every OFFLINE_READ_DIVIDER rounds.  Returns false if no
+// device should be read now.
+static bool pick_read(jrk_serial_bus * bus, size_t * index)
+{
+  for (size_t tries = 0; tries < bus->device_count; tries++)
+  {
+    size_t i = bus->next_read;
+    bus->next_read++;
+    if (bus->next_read >= bus->device_count)
+    {
+      bus->next_read = 0;
+      bus->round++;
+    }
+
+    if (bus->devices[i].stats.consecutive_timeouts < OFFLINE_TIMEOUT_COUNT ||
+      bus->round % OFFLINE_READ_DIVIDER == 0)
+    {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t transmit_time(const jrk_serial_bus * bus, size_t bytes)
+{
+  uint64_t bits = (uint64_t)bytes * BITS_PER_BYTE;
+  return (bits * 1000 + bus->baud_rate - 1) / bus->baud_rate;
+}
+
+// Makes the bus wait until the line has been quiet for the specified time.
+static void start_quiet(jrk_serial_bus * bus, uint64_t time, uint32_t duration)
+{
+  uint64_t until = time + duration;
+  if (!bus->quiet_pending || until > bus->quiet_until)
+  {
+    bus->quiet_until = until;
+  }
+  bus->quiet_pending = true;
+}
+
+static void finish_response(jrk_serial_bus * bus, uint64_t time)
+{
+  bus_device * device = &bus->devices[bus->read_device];
+  bus->read_outstanding = false;
+
+  jrk_codec_image_merge(device->image, sizeof(device->image),
+    bus->read_offset, bus->response, bus->read_length);
+  device->update_time = time;
+  device->stats.responses++;
+  device->stats.consecutive_timeouts = 0;
+}
+
+// Handles the passage of time: accepts a complete response once the line
+// has been quiet after it, and gives up on a read that timed out.
+static void update(jrk_serial_bus * bus, uint64_t time)
+{
+  bool quiet = !bus->quiet_pending || time >= bus->quiet_until;
+  if (quiet) { bus->quiet_pending = false; }
+
+  if (!bus->read_outstanding) { return; }
+
+  if (bus->response_length == bus->read_length)
+  {
+    if (quiet) { finish_response(bus, time); }
+    return;
+  }
+
+  if (time >= bus->read_deadline)
+  {
+    jrk_serial_bus_device_stats * stats =
+      &bus->devices[bus->read_device].stats;
+    stats->timeouts++;
+    stats->consecutive_timeouts++;
+    bus->read_outstanding = false;
+
+    // The response might still be on its way, so give it as long again to
+    // arrive and be discarded before sending anything else.
+    start_quiet(bus, time, bus->timeout + bus->turnaround);
+  }
+}
+
+size_t jrk_serial_bus_get_output(jrk_serial_bus * bus, uint64_t time,
+  uint8_t * buf, size_t size)
+{
+  if (bus == NULL || buf == NULL) { return 0; }
+
+  if (!bus->started)
+  {
+    bus->started = true;
+    bus->start_time = time;
+  }
+
+  update(bus, time);
+
+  // Nothing can be sent while a device might be answering.
+  if (bus->read_outstanding || bus->quiet_pending) { return 0; }
+
+  size_t n = 0;
+
+  // Commands have no responses, so they can all go out back to back.  Stops
+  // go first because they are the most urgent.
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    bus_device * device = &bus->devices[i];
+    if (!device->stop_pending) { continue; }
+    if (n + MAX_PACKET_SIZE > size) { break; }
+    n += jrk_codec_serial_stop_motor(buf + n, size - n, codec_flags(bus),
+      device->device_number);
+    device->stop_pending = false;
+  }
+
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    bus_device * device = &bus->devices[i];
+    if (!device->target_pending) { continue; }
+    if (n + MAX_PACKET_SIZE > size) { break; }
+    n += jrk_codec_serial_set_target(buf + n, size - n, codec_flags(bus),
+      device->device_number, device->target);
+    device->target_pending = false;
+  }
+
+  // End the burst with one read, since the line has to turn around for the
+  // response.
+  size_t index;
+  if (n + MAX_PACKET_SIZE <= size && bus->device_count && pick_read(bus, &index))
+  {
+    n += jrk_codec_serial_get_variables(buf + n, size - n, codec_flags(bus),
+      bus->devices[index].device_number, bus->read_offset, bus->read_length);
+
+    bus->read_outstanding = true;
+    bus->read_device = index;
+    bus->read_deadline = time + transmit_time(bus, n + bus->read_length) +
+      bus->timeout;
+    bus->response_length = 0;
+    bus->devices[index].stats.reads++;
+  }
+
+  bus->tx_bytes += n;
+  return n;
+}
+
+void jrk_serial_bus_handle_input(jrk_serial_bus * bus, uint64_t time,
+  const uint8_t * buf, size_t size)
+{
+  if (bus == NULL || buf == NULL || size == 0) { return; }
+
+  bus->rx_bytes += size;
+
+  update(bus, time);
+
+  for (size_t i = 0; i < size; i++)
+  {
+    if (bus->read_outstanding && bus->response_length < bus->read_length)
+    {
+      bus->response[bus->response_length++] = buf[i];
+      continue;
+    }
+
+    // Anything else, like a response that came after its timeout, is
+    // dropped.
+    bus->unexpected_bytes++;
+
+    if (bus->read_outstanding)
+    {
+      // More bytes came right after a complete response, so we cannot be
+      // sure the response came from the device we read.
+      bus->devices[bus->read_device].stats.bad_responses++;
+      bus->read_outstanding = false;
+    }
+  }
+
+  start_quiet(bus, time, bus->turnaround);
+}
+
+bool jrk_serial_bus_is_waiting(const jrk_serial_bus * bus, uint64_t * deadline)
+{
+  if (bus == NULL || (!bus->read_outstanding && !bus->quiet_pending))
+  {
+    if (deadline) { *deadline = 0; }
+    return false;
+  }
+
+  if (deadline)
+  {
+    if (bus->read_outstanding && bus->response_length < bus->read_length)
+    {
+      *deadline = bus->read_deadline;
+    }
+    else
+    {
+      *deadline = bus->quiet_until;
+    }
+  }
+  return true;
+}
+
+jrk_error * jrk_serial_bus_get_variables(const jrk_serial_bus * bus,
+  size_t index, jrk_variables * vars)
+{
+  if (bus == NULL)
+  {
+    return jrk_error_create("Serial bus is null.");
+  }
+
+  if (index >= bus->device_count)
+  {
+    return jrk_error_create("Invalid device index: %u.", (unsigned int)index);
+  }
+
+  const bus_device * device = &bus->devices[index];
+  return jrk_variables_decode(device->image, sizeof(device->image), vars);
+}
+
+uint64_t jrk_serial_bus_get_update_time(const jrk_serial_bus * bus,
+  size_t index)
+{
+  if (bus == NULL || index >= bus->device_count) { return 0; }
+  return bus->devices[index].update_time;
+}
+
+bool jrk_serial_bus_get_device_stats(const jrk_serial_bus * bus,
+  size_t index, jrk_serial_bus_device_stats * stats)
+{
+  if (bus == NULL || stats == NULL || index >= bus->device_count)
+  {
+    return false;
+  }
+  *stats = bus->devices[index].stats;
+  return true;
+}
+
+double jrk_serial_bus_get_utilization(const jrk_serial_bus * bus,
+  uint64_t time)
+{
+  if (bus == NULL || !bus->started || time <= bus->start_time) { return 0; }
+
+  double busy = (double)(bus->tx_bytes + bus->rx_bytes) * BITS_PER_BYTE *
+    1000 / bus->baud_rate;
+  return busy / (time - bus->start_time);
+}
+
+uint64_t jrk_serial_bus_get_unexpected_byte_count(const jrk_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->unexpected_bytes;
+}
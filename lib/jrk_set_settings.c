@@ -411,6 +411,85 @@ static void jrk_write_settings_to_buffer(const jrk_settings * settings, uint8_t
   }
 }
 
+jrk_error * jrk_settings_encode(const jrk_settings * settings,
+  uint8_t * buf, size_t len)
+{
+  if (settings == NULL)
+  {
+    return jrk_error_create("Settings pointer is null.");
+  }
+
+  if (buf == NULL)
+  {
+    return jrk_error_create("Settings buffer is null.");
+  }
+
+  if (len < JRK_SETTINGS_SIZE)
+  {
+    return jrk_error_create(
+      "Settings buffer is too short: expected %u bytes, got %u.",
+      (unsigned int)JRK_SETTINGS_SIZE, (unsigned int)len);
+  }
+
+  memset(buf, 0, JRK_SETTINGS_SIZE);
+  jrk_write_settings_to_buffer(settings, buf);
+  return NULL;
+}
+
+// Writes settings that have already been fixed to the EEPROM of the device.
+static jrk_error * write_eeprom_settings(jrk_handle * handle,
+  const jrk_settings * settings)
+{
+  assert(handle != NULL);
+  assert(settings != NULL);
+
+  jrk_error * error = NULL;
+
+  // Construct a buffer holding the bytes we want to write.
+  uint8_t buf[JRK_SETTINGS_SIZE];
+  memset(buf, 0, sizeof(buf));
+  jrk_write_settings_to_buffer(settings, buf);
+
+  // Write the bytes to the device.
+  for (uint8_t i = 1; i < sizeof(buf) && error == NULL; i++)
+  {
+    error = jrk_set_eeprom_setting_byte(handle, i, buf[i]);
+  }
+
+  return error;
+}
+
+// Writes settings that have already been fixed to the RAM of the device.
+static jrk_error * write_ram_settings(jrk_handle * handle,
+  const jrk_settings * settings)
+{
+  assert(handle != NULL);
+  assert(settings != NULL);
+
+  // Construct a buffer holding the bytes we want to write.
+  uint8_t buf[JRK_SETTINGS_SIZE];
+  memset(buf, 0, sizeof(buf));
+  jrk_write_settings_to_buffer(settings, buf);
+
+  // Write the bytes to the device.
+  return jrk_set_ram_setting_segment(handle, 1, sizeof(buf) - 1, buf + 1);
+}
+
+// Makes sure that settings we are going to write without fixing them were
+// fixed for the product of the device.
+static jrk_error * check_settings_product(jrk_handle * handle,
+  const jrk_settings * settings)
+{
+  const jrk_device * device = jrk_handle_get_device(handle);
+  uint32_t product = jrk_device_get_product(device);
+  if (jrk_settings_get_product(settings) != product)
+  {
+    return jrk_error_create(
+      "The settings are for a different product than the device.");
+  }
+  return NULL;
+}
+
 jrk_error * jrk_set_eeprom_settings(jrk_handle * handle, const jrk_settings * settings)
 {
   if (handle == NULL)
@@ -447,21 +526,41 @@ jrk_error * jrk_set_eeprom_settings(jrk_handle * handle, const jrk_settings * se
       fixed_settings, product, firmware_version, NULL);
   }
 
-  // Construct a buffer holding the bytes we want to write.
-  uint8_t buf[JRK_SETTINGS_SIZE];
-  memset(buf, 0, sizeof(buf));
   if (error == NULL)
   {
-    jrk_write_settings_to_buffer(fixed_settings, buf);
+    error = write_eeprom_settings(handle, fixed_settings);
   }
 
-  // Write the bytes to the device.
-  for (uint8_t i = 1; i < sizeof(buf) && error == NULL; i++)
+  jrk_settings_free(fixed_settings);
+
+  if (error != NULL)
   {
-    error = jrk_set_eeprom_setting_byte(handle, i, buf[i]);
+    error = jrk_error_add(error,
+      "There was an error applying settings to the device.");
   }
 
-  jrk_settings_free(fixed_settings);
+  return error;
+}
+
+jrk_error * jrk_set_eeprom_settings_no_fix(jrk_handle * handle,
+  const jrk_settings * settings)
+{
+  if (handle == NULL)
+  {
+    return jrk_error_create("Handle is null.");
+  }
+
+  if (settings == NULL)
+  {
+    return jrk_error_create("Settings object is null.");
+  }
+
+  jrk_error * error = check_settings_product(handle, settings);
+
+  if (error == NULL)
+  {
+    error = write_eeprom_settings(handle, settings);
+  }
 
   if (error != NULL)
   {
@@ -508,14 +607,6 @@ jrk_error * jrk_set_ram_settings(jrk_handle * handle, const jrk_settings * setti
       fixed_settings, product, firmware_version, NULL);
   }
 
-  // Construct a buffer holding the bytes we want to write.
-  uint8_t buf[JRK_SETTINGS_SIZE];
-  memset(buf, 0, sizeof(buf));
-  if (error == NULL)
-  {
-    jrk_write_settings_to_buffer(fixed_settings, buf);
-  }
-
   // Add context here because any error from
   // jrk_set_ram_settings_segment will already have nice context.
   if (error != NULL)
@@ -526,11 +617,33 @@ jrk_error * jrk_set_ram_settings(jrk_handle * handle, const jrk_settings * setti
   // Write the bytes to the device.
   if (error == NULL)
   {
-    error = jrk_set_ram_setting_segment(handle,
-      1, sizeof(buf) - 1, buf + 1);
+    error = write_ram_settings(handle, fixed_settings);
   }
 
   jrk_settings_free(fixed_settings);
 
   return error;
 }
+
+jrk_error * jrk_set_ram_settings_no_fix(jrk_handle * handle,
+  const jrk_settings * settings)
+{
+  if (handle == NULL)
+  {
+    return jrk_error_create("Handle is null.");
+  }
+
+  if (settings == NULL)
+  {
+    return jrk_error_create("RAM settings object is null.");
+  }
+
+  jrk_error * error = check_settings_product(handle, settings);
+
+  if (error != NULL)
+  {
+    return jrk_error_add(error, "There was an error setting RAM settings.");
+  }
+
+  return write_ram_settings(handle, settings);
+}
@@ -2,6 +2,10 @@
 
 struct jrk_settings
 {
+  // True if this object was allocated from a jrk_settings_arena, in which case
+  // jrk_settings_free() does nothing.
+  bool in_arena;
+
   uint32_t product;
   uint16_t firmware_version;
 
@@ -89,21 +93,252 @@ struct jrk_settings
   // End of auto-generated settings struct members.
 };
 
+// The default settings for each product.  Filling a settings object with
+// defaults is just a copy of one of these.
+static const jrk_settings default_settings[] =
+{
+  // Beginning of auto-generated settings default images.
+
+  {
+    .product = JRK_PRODUCT_UMC04A_30V,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .encoded_hard_current_limit_forward = 87,
+    .encoded_hard_current_limit_reverse = 87,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+  {
+    .product = JRK_PRODUCT_UMC04A_40V,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .encoded_hard_current_limit_forward = 63,
+    .encoded_hard_current_limit_reverse = 63,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+  {
+    .product = JRK_PRODUCT_UMC05A_30V,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .encoded_hard_current_limit_forward = 86,
+    .encoded_hard_current_limit_reverse = 86,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+  {
+    .product = JRK_PRODUCT_UMC05A_40V,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .encoded_hard_current_limit_forward = 62,
+    .encoded_hard_current_limit_reverse = 62,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+  {
+    .product = JRK_PRODUCT_UMC06A,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+
+  // End of auto-generated settings default images.
+};
+
+// The default settings for products that are not in the list above, such as
+// products added after this version of the library.  The settings with
+// product-specific defaults are zero.
+static const jrk_settings generic_default_settings[] =
+{
+  // Beginning of auto-generated settings generic default image.
+
+  {
+    .product = 0,
+    .input_error_maximum = 4095,
+    .input_maximum = 4095,
+    .input_neutral_minimum = 2048,
+    .input_neutral_maximum = 2048,
+    .output_neutral = 2048,
+    .output_maximum = 4095,
+    .input_analog_samples_exponent = 7,
+    .feedback_mode = JRK_FEEDBACK_MODE_NONE,
+    .feedback_error_maximum = 4095,
+    .feedback_maximum = 4095,
+    .feedback_analog_samples_exponent = 7,
+    .serial_baud_rate = 9600,
+    .serial_device_number = 11,
+    .pid_period = 10,
+    .integral_limit = 1000,
+    .current_samples_exponent = 7,
+    .hard_overcurrent_threshold = 1,
+    .max_duty_cycle_while_feedback_out_of_range = 1,
+    .max_acceleration_forward = 600,
+    .max_acceleration_reverse = 600,
+    .max_deceleration_forward = 600,
+    .max_deceleration_reverse = 600,
+    .max_duty_cycle_forward = 600,
+    .max_duty_cycle_reverse = 600,
+    .fbt_method = JRK_FBT_METHOD_PULSE_COUNTING,
+    .fbt_timing_clock = JRK_FBT_TIMING_CLOCK_1_5,
+    .fbt_timing_timeout = 100,
+    .fbt_samples = 1,
+  },
+
+  // End of auto-generated settings generic default image.
+};
+
+// Returns NULL if the product is zero (not set).
+static const jrk_settings * default_settings_for_product(uint32_t product)
+{
+  if (product == 0) { return NULL; }
+
+  size_t count = sizeof(default_settings) / sizeof(default_settings[0]);
+  for (size_t i = 0; i < count; i++)
+  {
+    if (default_settings[i].product == product)
+    {
+      return &default_settings[i];
+    }
+  }
+  return &generic_default_settings[0];
+}
+
 void jrk_settings_set_product_specific_defaults(jrk_settings * settings)
 {
   uint32_t product = jrk_settings_get_product(settings);
   assert(product);
 
-  uint16_t limit = 0;
-  switch (product)
+  uint16_t limit_forward = 0;
+  uint16_t limit_reverse = 0;
+  const jrk_settings * defaults = default_settings_for_product(product);
+  if (defaults != NULL)
   {
-  case JRK_PRODUCT_UMC04A_30V: limit = 87; break;
-  case JRK_PRODUCT_UMC04A_40V: limit = 63; break;
-  case JRK_PRODUCT_UMC05A_30V: limit = 86; break;
-  case JRK_PRODUCT_UMC05A_40V: limit = 62; break;
+    limit_forward = defaults->encoded_hard_current_limit_forward;
+    limit_reverse = defaults->encoded_hard_current_limit_reverse;
   }
-  jrk_settings_set_encoded_hard_current_limit_forward(settings, limit);
-  jrk_settings_set_encoded_hard_current_limit_reverse(settings, limit);
+  jrk_settings_set_encoded_hard_current_limit_forward(settings, limit_forward);
+  jrk_settings_set_encoded_hard_current_limit_reverse(settings, limit_reverse);
 
   // These are actually unit-specific settings but it makes sense to reset
   // these too because (for jrk_settings_fix_and_change_product).
@@ -116,52 +351,26 @@ void jrk_settings_fill_with_defaults(jrk_settings * settings)
 {
   if (settings == NULL) { return; }
 
+  bool in_arena = settings->in_arena;
   uint32_t product = jrk_settings_get_product(settings);
   uint16_t firmware_version = jrk_settings_get_firmware_version(settings);
 
-  // Reset all fields to zero and then restore the product/version.
-  memset(settings, 0, sizeof(jrk_settings));
-  jrk_settings_set_product(settings, product);
-  jrk_settings_set_firmware_version(settings, firmware_version);
-
-  // The product should be set beforehand, and if it is not then quit.
-  if (product == 0)
+  // The product should be set beforehand, and if it is not then we just
+  // reset all the fields to zero.
+  const jrk_settings * defaults = default_settings_for_product(product);
+  if (defaults == NULL)
+  {
+    memset(settings, 0, sizeof(jrk_settings));
+  }
+  else
   {
-    return;
+    memcpy(settings, defaults, sizeof(jrk_settings));
   }
 
-  // Beginning of auto-generated settings defaults.
-
-  jrk_settings_set_input_error_maximum(settings, 4095);
-  jrk_settings_set_input_maximum(settings, 4095);
-  jrk_settings_set_input_neutral_minimum(settings, 2048);
-  jrk_settings_set_input_neutral_maximum(settings, 2048);
-  jrk_settings_set_output_neutral(settings, 2048);
-  jrk_settings_set_output_maximum(settings, 4095);
-  jrk_settings_set_input_analog_samples_exponent(settings, 7);
-  jrk_settings_set_feedback_mode(settings, JRK_FEEDBACK_MODE_NONE);
-  jrk_settings_set_feedback_error_maximum(settings, 4095);
-  jrk_settings_set_feedback_maximum(settings, 4095);
-  jrk_settings_set_feedback_analog_samples_exponent(settings, 7);
-  jrk_settings_set_serial_device_number(settings, 11);
-  jrk_settings_set_pid_period(settings, 10);
-  jrk_settings_set_integral_limit(settings, 1000);
-  jrk_settings_set_current_samples_exponent(settings, 7);
-  jrk_settings_set_hard_overcurrent_threshold(settings, 1);
-  jrk_settings_set_max_acceleration_forward(settings, 600);
-  jrk_settings_set_max_acceleration_reverse(settings, 600);
-  jrk_settings_set_max_deceleration_forward(settings, 600);
-  jrk_settings_set_max_deceleration_reverse(settings, 600);
-  jrk_settings_set_max_duty_cycle_forward(settings, 600);
-  jrk_settings_set_max_duty_cycle_reverse(settings, 600);
-  jrk_settings_set_fbt_method(settings, JRK_FBT_METHOD_PULSE_COUNTING);
-  jrk_settings_set_fbt_timing_clock(settings, JRK_FBT_TIMING_CLOCK_1_5);
-  jrk_settings_set_fbt_timing_timeout(settings, 100);
-  jrk_settings_set_fbt_samples(settings, 1);
-
-  // End of auto-generated settings defaults.
-
-  jrk_settings_set_product_specific_defaults(settings);
+  // Restore the fields that are not settings.
+  settings->in_arena = in_arena;
+  settings->product = product;
+  settings->firmware_version = firmware_version;
 }
 
 jrk_error * jrk_settings_create(jrk_settings ** settings)
@@ -195,6 +404,7 @@ jrk_error * jrk_settings_create(jrk_settings ** settings)
 
 void jrk_settings_free(jrk_settings * settings)
 {
+  if (settings != NULL && settings->in_arena) { return; }
   free(settings);
 }
 
@@ -224,6 +434,7 @@ jrk_error * jrk_settings_copy(const jrk_settings * source, jrk_settings ** dest)
   if (error == NULL)
   {
     memcpy(new_settings, source, sizeof(jrk_settings));
+    new_settings->in_arena = false;
   }
 
   if (error == NULL)
@@ -237,6 +448,164 @@ jrk_error * jrk_settings_copy(const jrk_settings * source, jrk_settings ** dest)
   return error;
 }
 
+// A block of settings objects allocated from the heap all at once.
+typedef struct jrk_settings_arena_block
+{
+  struct jrk_settings_arena_block * next;
+  size_t used;
+  size_t capacity;
+  jrk_settings items[];
+} jrk_settings_arena_block;
+
+struct jrk_settings_arena
+{
+  // The block we are currently allocating from.  Older blocks follow it in the
+  // linked list.
+  jrk_settings_arena_block * block;
+
+  // The number of settings objects to put in each new block.
+  size_t block_capacity;
+};
+
+jrk_error * jrk_settings_arena_create(size_t block_capacity,
+  jrk_settings_arena ** arena)
+{
+  if (arena == NULL)
+  {
+    return jrk_error_create("Arena output pointer is null.");
+  }
+
+  *arena = NULL;
+
+  if (block_capacity == 0) { block_capacity = 256; }
+
+  // Make sure the size of a block can be computed without overflowing.
+  if (block_capacity > (SIZE_MAX - sizeof(jrk_settings_arena_block)) /
+    sizeof(jrk_settings))
+  {
+    return jrk_error_create("Arena block capacity is too large.");
+  }
+
+  jrk_settings_arena * new_arena =
+    (jrk_settings_arena *)calloc(1, sizeof(jrk_settings_arena));
+  if (new_arena == NULL) { return &jrk_error_no_memory; }
+
+  new_arena->block_capacity = block_capacity;
+  *arena = new_arena;
+  return NULL;
+}
+
+void jrk_settings_arena_reset(jrk_settings_arena * arena)
+{
+  if (arena == NULL) { return; }
+
+  // Keep the most recent block (all blocks are the same size) so that
+  // applications that reset the arena in a loop and use less than one block
+  // each time do not hit the heap again.
+  jrk_settings_arena_block * block = arena->block;
+  if (block == NULL) { return; }
+  jrk_settings_arena_block * old = block->next;
+  while (old != NULL)
+  {
+    jrk_settings_arena_block * next = old->next;
+    free(old);
+    old = next;
+  }
+  block->next = NULL;
+  block->used = 0;
+}
+
+void jrk_settings_arena_free(jrk_settings_arena * arena)
+{
+  if (arena == NULL) { return; }
+
+  jrk_settings_arena_block * block = arena->block;
+  while (block != NULL)
+  {
+    jrk_settings_arena_block * next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+// Returns a zeroed settings object from the arena, or NULL if we ran out of
+// memory.
+static jrk_settings * jrk_settings_arena_alloc(jrk_settings_arena * arena)
+{
+  assert(arena != NULL);
+
+  jrk_settings_arena_block * block = arena->block;
+  if (block == NULL || block->used == block->capacity)
+  {
+    size_t capacity = arena->block_capacity;
+    block = (jrk_settings_arena_block *)malloc(
+      sizeof(jrk_settings_arena_block) + capacity * sizeof(jrk_settings));
+    if (block == NULL) { return NULL; }
+    block->next = arena->block;
+    block->used = 0;
+    block->capacity = capacity;
+    arena->block = block;
+  }
+
+  jrk_settings * settings = &block->items[block->used++];
+  memset(settings, 0, sizeof(jrk_settings));
+  settings->in_arena = true;
+  return settings;
+}
+
+jrk_error * jrk_settings_create_in_arena(jrk_settings_arena * arena,
+  jrk_settings ** settings)
+{
+  if (settings == NULL)
+  {
+    return jrk_error_create("Settings output pointer is null.");
+  }
+
+  *settings = NULL;
+
+  if (arena == NULL)
+  {
+    return jrk_error_create("Arena is null.");
+  }
+
+  jrk_settings * new_settings = jrk_settings_arena_alloc(arena);
+  if (new_settings == NULL) { return &jrk_error_no_memory; }
+
+  *settings = new_settings;
+  return NULL;
+}
+
+jrk_error * jrk_settings_copy_in_arena(jrk_settings_arena * arena,
+  const jrk_settings * source, jrk_settings ** dest)
+{
+  if (dest == NULL)
+  {
+    return jrk_error_create("Settings output pointer is null.");
+  }
+
+  *dest = NULL;
+
+  if (arena == NULL)
+  {
+    return jrk_error_create("Arena is null.");
+  }
+
+  if (source == NULL)
+  {
+    return NULL;
+  }
+
+  jrk_settings * new_settings = jrk_settings_arena_alloc(arena);
+  if (new_settings == NULL) { return &jrk_error_no_memory; }
+
+  memcpy(new_settings, source, sizeof(jrk_settings));
+  new_settings->in_arena = true;
+
+  *dest = new_settings;
+  return NULL;
+}
+
 void jrk_settings_set_product(jrk_settings * settings, uint32_t product)
 {
   if (settings == NULL) { return; }
@@ -0,0 +1,410 @@
+// Functions for cheaply detecting when the settings on a Jrk drift away from
+// what they are supposed to be.
+
+#include "jrk_internal.h"
+
+// The default number of bytes of settings to check in each step.
+#define DEFAULT_WINDOW_SIZE 16
+
+// This must be at least as large as the number of settings.
+#define MAX_FIELD_COUNT 96
+
+typedef struct setting_field
+{
+  const char * name;
+  uint8_t address;
+  uint8_t size;
+  uint8_t mask;  // The bits used in the first byte (for bit fields).
+} setting_field;
+
+// Describes where each setting is stored in a settings image for a particular
+// product.
+typedef struct setting_layout
+{
+  size_t count;
+  setting_field fields[MAX_FIELD_COUNT];
+} setting_layout;
+
+static void add_field(setting_layout * layout, const char * name,
+  uint8_t address, uint8_t size, uint8_t mask)
+{
+  assert(layout->count < MAX_FIELD_COUNT);
+  assert(address + size <= JRK_SETTINGS_SIZE);
+
+  setting_field * field = &layout->fields[layout->count++];
+  field->name = name;
+  field->address = address;
+  field->size = size;
+  field->mask = size == 1 ? mask : 0xFF;
+}
+
+static void get_setting_layout(uint32_t product, setting_layout * layout)
+{
+  memset(layout, 0, sizeof(setting_layout));
+
+  // Beginning of auto-generated settings field layout code.
+
+  add_field(layout, "input_mode", JRK_SETTING_INPUT_MODE, 1, 0xFF);
+  add_field(layout, "input_error_minimum", JRK_SETTING_INPUT_ERROR_MINIMUM, 2, 0xFF);
+  add_field(layout, "input_error_maximum", JRK_SETTING_INPUT_ERROR_MAXIMUM, 2, 0xFF);
+  add_field(layout, "input_minimum", JRK_SETTING_INPUT_MINIMUM, 2, 0xFF);
+  add_field(layout, "input_maximum", JRK_SETTING_INPUT_MAXIMUM, 2, 0xFF);
+  add_field(layout, "input_neutral_minimum", JRK_SETTING_INPUT_NEUTRAL_MINIMUM, 2, 0xFF);
+  add_field(layout, "input_neutral_maximum", JRK_SETTING_INPUT_NEUTRAL_MAXIMUM, 2, 0xFF);
+  add_field(layout, "output_minimum", JRK_SETTING_OUTPUT_MINIMUM, 2, 0xFF);
+  add_field(layout, "output_neutral", JRK_SETTING_OUTPUT_NEUTRAL, 2, 0xFF);
+  add_field(layout, "output_maximum", JRK_SETTING_OUTPUT_MAXIMUM, 2, 0xFF);
+  add_field(layout, "input_invert", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_INPUT_INVERT);
+  add_field(layout, "input_scaling_degree", JRK_SETTING_INPUT_SCALING_DEGREE, 1, 0xFF);
+  add_field(layout, "input_detect_disconnect", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_INPUT_DETECT_DISCONNECT);
+  add_field(layout, "input_analog_samples_exponent", JRK_SETTING_INPUT_ANALOG_SAMPLES_EXPONENT, 1, 0xFF);
+  add_field(layout, "feedback_mode", JRK_SETTING_FEEDBACK_MODE, 1, 0xFF);
+  add_field(layout, "feedback_error_minimum", JRK_SETTING_FEEDBACK_ERROR_MINIMUM, 2, 0xFF);
+  add_field(layout, "feedback_error_maximum", JRK_SETTING_FEEDBACK_ERROR_MAXIMUM, 2, 0xFF);
+  add_field(layout, "feedback_minimum", JRK_SETTING_FEEDBACK_MINIMUM, 2, 0xFF);
+  add_field(layout, "feedback_maximum", JRK_SETTING_FEEDBACK_MAXIMUM, 2, 0xFF);
+  add_field(layout, "feedback_invert", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_FEEDBACK_INVERT);
+  add_field(layout, "feedback_detect_disconnect", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_FEEDBACK_DETECT_DISCONNECT);
+  add_field(layout, "feedback_dead_zone", JRK_SETTING_FEEDBACK_DEAD_ZONE, 1, 0xFF);
+  add_field(layout, "feedback_analog_samples_exponent", JRK_SETTING_FEEDBACK_ANALOG_SAMPLES_EXPONENT, 1, 0xFF);
+  add_field(layout, "feedback_wraparound", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_FEEDBACK_WRAPAROUND);
+  add_field(layout, "serial_mode", JRK_SETTING_SERIAL_MODE, 1, 0xFF);
+  add_field(layout, "serial_device_number", JRK_SETTING_SERIAL_DEVICE_NUMBER, 2, 0xFF);
+  add_field(layout, "never_sleep", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_NEVER_SLEEP);
+  add_field(layout, "serial_enable_crc", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_CRC);
+  add_field(layout, "serial_enable_14bit_device_number", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_SERIAL_ENABLE_14BIT_DEVICE_NUMBER);
+  add_field(layout, "serial_disable_compact_protocol", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_SERIAL_DISABLE_COMPACT_PROTOCOL);
+  add_field(layout, "proportional_multiplier", JRK_SETTING_PROPORTIONAL_MULTIPLIER, 2, 0xFF);
+  add_field(layout, "proportional_exponent", JRK_SETTING_PROPORTIONAL_EXPONENT, 1, 0xFF);
+  add_field(layout, "integral_multiplier", JRK_SETTING_INTEGRAL_MULTIPLIER, 2, 0xFF);
+  add_field(layout, "integral_exponent", JRK_SETTING_INTEGRAL_EXPONENT, 1, 0xFF);
+  add_field(layout, "derivative_multiplier", JRK_SETTING_DERIVATIVE_MULTIPLIER, 2, 0xFF);
+  add_field(layout, "derivative_exponent", JRK_SETTING_DERIVATIVE_EXPONENT, 1, 0xFF);
+  add_field(layout, "pid_period", JRK_SETTING_PID_PERIOD, 2, 0xFF);
+  add_field(layout, "integral_divider_exponent", JRK_SETTING_INTEGRAL_DIVIDER_EXPONENT, 1, 0xFF);
+  add_field(layout, "integral_limit", JRK_SETTING_INTEGRAL_LIMIT, 2, 0xFF);
+  add_field(layout, "reset_integral", JRK_SETTING_OPTIONS_BYTE3, 1, 1 << JRK_OPTIONS_BYTE3_RESET_INTEGRAL);
+  add_field(layout, "pwm_frequency", JRK_SETTING_PWM_FREQUENCY, 1, 0xFF);
+  add_field(layout, "current_samples_exponent", JRK_SETTING_CURRENT_SAMPLES_EXPONENT, 1, 0xFF);
+  if (product != JRK_PRODUCT_UMC06A)
+  {
+    add_field(layout, "hard_overcurrent_threshold", JRK_SETTING_HARD_OVERCURRENT_THRESHOLD, 1, 0xFF);
+  }
+  add_field(layout, "current_offset_calibration", JRK_SETTING_CURRENT_OFFSET_CALIBRATION, 2, 0xFF);
+  add_field(layout, "current_scale_calibration", JRK_SETTING_CURRENT_SCALE_CALIBRATION, 2, 0xFF);
+  add_field(layout, "motor_invert", JRK_SETTING_OPTIONS_BYTE2, 1, 1 << JRK_OPTIONS_BYTE2_MOTOR_INVERT);
+  add_field(layout, "max_duty_cycle_while_feedback_out_of_range", JRK_SETTING_MAX_DUTY_CYCLE_WHILE_FEEDBACK_OUT_OF_RANGE, 2, 0xFF);
+  add_field(layout, "max_acceleration_forward", JRK_SETTING_MAX_ACCELERATION_FORWARD, 2, 0xFF);
+  add_field(layout, "max_acceleration_reverse", JRK_SETTING_MAX_ACCELERATION_REVERSE, 2, 0xFF);
+  add_field(layout, "max_deceleration_forward", JRK_SETTING_MAX_DECELERATION_FORWARD, 2, 0xFF);
+  add_field(layout, "max_deceleration_reverse", JRK_SETTING_MAX_DECELERATION_REVERSE, 2, 0xFF);
+  add_field(layout, "max_duty_cycle_forward", JRK_SETTING_MAX_DUTY_CYCLE_FORWARD, 2, 0xFF);
+  add_field(layout, "max_duty_cycle_reverse", JRK_SETTING_MAX_DUTY_CYCLE_REVERSE, 2, 0xFF);
+  if (product != JRK_PRODUCT_UMC06A)
+  {
+    add_field(layout, "encoded_hard_current_limit_forward", JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_FORWARD, 2, 0xFF);
+  }
+  if (product != JRK_PRODUCT_UMC06A)
+  {
+    add_field(layout, "encoded_hard_current_limit_reverse", JRK_SETTING_ENCODED_HARD_CURRENT_LIMIT_REVERSE, 2, 0xFF);
+  }
+  add_field(layout, "soft_current_limit_forward", JRK_SETTING_SOFT_CURRENT_LIMIT_FORWARD, 2, 0xFF);
+  add_field(layout, "soft_current_limit_reverse", JRK_SETTING_SOFT_CURRENT_LIMIT_REVERSE, 2, 0xFF);
+  if (product == JRK_PRODUCT_UMC06A)
+  {
+    add_field(layout, "soft_current_regulation_level_forward", JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_FORWARD, 2, 0xFF);
+  }
+  if (product == JRK_PRODUCT_UMC06A)
+  {
+    add_field(layout, "soft_current_regulation_level_reverse", JRK_SETTING_SOFT_CURRENT_REGULATION_LEVEL_REVERSE, 2, 0xFF);
+  }
+  add_field(layout, "coast_when_off", JRK_SETTING_OPTIONS_BYTE3, 1, 1 << JRK_OPTIONS_BYTE3_COAST_WHEN_OFF);
+  add_field(layout, "error_enable", JRK_SETTING_ERROR_ENABLE, 2, 0xFF);
+  add_field(layout, "error_latch", JRK_SETTING_ERROR_LATCH, 2, 0xFF);
+  add_field(layout, "error_hard", JRK_SETTING_ERROR_HARD, 2, 0xFF);
+  add_field(layout, "vin_calibration", JRK_SETTING_VIN_CALIBRATION, 2, 0xFF);
+  add_field(layout, "disable_i2c_pullups", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_DISABLE_I2C_PULLUPS);
+  add_field(layout, "analog_sda_pullup", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_ANALOG_SDA_PULLUP);
+  add_field(layout, "always_analog_sda", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_SDA);
+  add_field(layout, "always_analog_fba", JRK_SETTING_OPTIONS_BYTE1, 1, 1 << JRK_OPTIONS_BYTE1_ALWAYS_ANALOG_FBA);
+  add_field(layout, "fbt_method", JRK_SETTING_FBT_METHOD, 1, 0xFF);
+  add_field(layout, "fbt_timing_clock", JRK_SETTING_FBT_OPTIONS, 1, JRK_FBT_OPTIONS_TIMING_CLOCK_MASK << JRK_FBT_OPTIONS_TIMING_CLOCK);
+  add_field(layout, "fbt_timing_polarity", JRK_SETTING_FBT_OPTIONS, 1, 1 << JRK_FBT_OPTIONS_TIMING_POLARITY);
+  add_field(layout, "fbt_timing_timeout", JRK_SETTING_FBT_TIMING_TIMEOUT, 2, 0xFF);
+  add_field(layout, "fbt_samples", JRK_SETTING_FBT_SAMPLES, 1, 0xFF);
+  add_field(layout, "fbt_divider_exponent", JRK_SETTING_FBT_DIVIDER_EXPONENT, 1, 0xFF);
+
+  // End of auto-generated settings field layout code.
+
+  add_field(layout, "serial_baud_rate",
+    JRK_SETTING_SERIAL_BAUD_RATE_GENERATOR, 2, 0xFF);
+  add_field(layout, "serial_timeout", JRK_SETTING_SERIAL_TIMEOUT, 2, 0xFF);
+  add_field(layout, "brake_duration_forward",
+    JRK_SETTING_BRAKE_DURATION_FORWARD, 1, 0xFF);
+  add_field(layout, "brake_duration_reverse",
+    JRK_SETTING_BRAKE_DURATION_REVERSE, 1, 0xFF);
+}
+
+typedef struct monitored_device
+{
+  char * serial_number;
+
+  // The product of the device, or 0 if we have not talked to it yet.
+  uint32_t product;
+  setting_layout layout;
+
+  bool has_golden;
+  uint32_t golden_product;
+  uint8_t golden[JRK_SETTINGS_SIZE];
+
+  // The index of the first byte to check in the next step.
+  size_t next_index;
+} monitored_device;
+
+struct jrk_settings_monitor
+{
+  size_t window_size;
+  size_t device_count;
+  monitored_device ** devices;
+};
+
+jrk_error * jrk_settings_monitor_create(size_t window_size,
+  jrk_settings_monitor ** monitor)
+{
+  if (monitor == NULL)
+  {
+    return jrk_error_create("Monitor output pointer is null.");
+  }
+
+  *monitor = NULL;
+
+  if (window_size == 0)
+  {
+    window_size = DEFAULT_WINDOW_SIZE;
+  }
+
+  if (window_size > JRK_MAX_USB_RESPONSE_SIZE)
+  {
+    window_size = JRK_MAX_USB_RESPONSE_SIZE;
+  }
+
+  jrk_settings_monitor * new_monitor =
+    (jrk_settings_monitor *)calloc(1, sizeof(jrk_settings_monitor));
+  if (new_monitor == NULL) { return &jrk_error_no_memory; }
+
+  new_monitor->window_size = window_size;
+  *monitor = new_monitor;
+  return NULL;
+}
+
+void jrk_settings_monitor_free(jrk_settings_monitor * monitor)
+{
+  if (monitor == NULL) { return; }
+
+  for (size_t i = 0; i < monitor->device_count; i++)
+  {
+    free(monitor->devices[i]->serial_number);
+    free(monitor->devices[i]);
+  }
+  free(monitor->devices);
+  free(monitor);
+}
+
+// Finds the state we are keeping for the device with the specified serial
+// number, adding a new entry if needed.  Returns NULL if we ran out of memory.
+static monitored_device * find_or_add_device(jrk_settings_monitor * monitor,
+  const char * serial_number)
+{
+  for (size_t i = 0; i < monitor->device_count; i++)
+  {
+    if (strcmp(monitor->devices[i]->serial_number, serial_number) == 0)
+    {
+      return monitor->devices[i];
+    }
+  }
+
+  monitored_device ** new_devices = (monitored_device **)realloc(
+    monitor->devices, (monitor->device_count + 1) * sizeof(monitored_device *));
+  if (new_devices == NULL) { return NULL; }
+  monitor->devices = new_devices;
+
+  monitored_device * device =
+    (monitored_device *)calloc(1, sizeof(monitored_device));
+  if (device == NULL) { return NULL; }
+
+  device->serial_number = jrk_string_duplicate(serial_number);
+  if (device->serial_number == NULL)
+  {
+    free(device);
+    return NULL;
+  }
+
+  device->next_index = 1;
+  monitor->devices[monitor->device_count++] = device;
+  return device;
+}
+
+jrk_error * jrk_settings_monitor_set_golden(jrk_settings_monitor * monitor,
+  const char * serial_number, const jrk_settings * golden)
+{
+  if (monitor == NULL)
+  {
+    return jrk_error_create("Monitor is null.");
+  }
+
+  if (serial_number == NULL)
+  {
+    return jrk_error_create("Serial number is null.");
+  }
+
+  monitored_device * device = find_or_add_device(monitor, serial_number);
+  if (device == NULL) { return &jrk_error_no_memory; }
+
+  if (golden == NULL)
+  {
+    device->has_golden = false;
+    return NULL;
+  }
+
+  jrk_error * error = jrk_settings_encode(golden,
+    device->golden, sizeof(device->golden));
+  if (error == NULL)
+  {
+    device->has_golden = true;
+    device->golden_product = jrk_settings_get_product(golden);
+  }
+  return error;
+}
+
+// Reports every setting in the window [start, end) that is different in the
+// two images.  Bits that do not belong to a setting are ignored.
+static void report_differences(jrk_string * report,
+  const setting_layout * layout, const char * description,
+  const uint8_t * actual, const uint8_t * expected, size_t start, size_t end)
+{
+  for (size_t i = 0; i < layout->count; i++)
+  {
+    const setting_field * field = &layout->fields[i];
+    for (size_t j = 0; j < field->size; j++)
+    {
+      size_t index = field->address + j;
+      if (index < start || index >= end) { continue; }
+      if ((actual[index] ^ expected[index]) & field->mask)
+      {
+        jrk_sprintf(report, "%s: %s\n", description, field->name);
+        break;
+      }
+    }
+  }
+}
+
+jrk_error * jrk_settings_monitor_step(jrk_settings_monitor * monitor,
+  jrk_handle * handle, char ** report)
+{
+  if (report) { *report = NULL; }
+
+  if (monitor == NULL)
+  {
+    return jrk_error_create("Monitor is null.");
+  }
+
+  if (handle == NULL)
+  {
+    return jrk_error_create("Handle is null.");
+  }
+
+  const jrk_device * jrk_device = jrk_handle_get_device(handle);
+  uint32_t product = jrk_device_get_product(jrk_device);
+
+  monitored_device * device = find_or_add_device(monitor,
+    jrk_device_get_serial_number(jrk_device));
+  if (device == NULL) { return &jrk_error_no_memory; }
+
+  if (device->has_golden && device->golden_product != product)
+  {
+    return jrk_error_create(
+      "The golden settings for device %s are for a different product.",
+      device->serial_number);
+  }
+
+  if (device->product != product)
+  {
+    device->product = product;
+    get_setting_layout(product, &device->layout);
+  }
+
+  // Figure out which window of settings to read in this step.
+  size_t start = device->next_index;
+  size_t length = monitor->window_size;
+  if (start + length > JRK_SETTINGS_SIZE)
+  {
+    length = JRK_SETTINGS_SIZE - start;
+  }
+  size_t end = start + length;
+
+  jrk_error * error = NULL;
+
+  uint8_t eeprom[JRK_SETTINGS_SIZE];
+  uint8_t ram[JRK_SETTINGS_SIZE];
+  memset(eeprom, 0, sizeof(eeprom));
+  memset(ram, 0, sizeof(ram));
+
+  if (error == NULL)
+  {
+    error = jrk_get_eeprom_setting_segment(handle, start, length, eeprom + start);
+  }
+
+  if (error == NULL)
+  {
+    error = jrk_get_ram_setting_segment(handle, start, length, ram + start);
+  }
+
+  if (error != NULL)
+  {
+    return jrk_error_add(error,
+      "There was an error checking the settings of device %s.",
+      device->serial_number);
+  }
+
+  device->next_index = end >= JRK_SETTINGS_SIZE ? 1 : end;
+
+  jrk_string str;
+  if (report)
+  {
+    jrk_string_setup(&str);
+  }
+  else
+  {
+    jrk_string_setup_dummy(&str);
+  }
+
+  if (device->has_golden)
+  {
+    report_differences(&str, &device->layout,
+      "EEPROM setting differs from golden settings",
+      eeprom, device->golden, start, end);
+  }
+
+  report_differences(&str, &device->layout,
+    "RAM setting differs from EEPROM", ram, eeprom, start, end);
+
+  if (report && str.data == NULL)
+  {
+    return &jrk_error_no_memory;
+  }
+
+  if (report)
+  {
+    *report = str.data;
+  }
+
+  return NULL;
+}
+
+size_t jrk_settings_monitor_get_steps_per_pass(
+  const jrk_settings_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  size_t bytes = JRK_SETTINGS_SIZE - 1;
+  return (bytes + monitor->window_size - 1) / monitor->window_size;
+}
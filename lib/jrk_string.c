@@ -31,6 +31,17 @@ void jrk_string_setup_dummy(jrk_string * str)
   str->capacity = str->length = 0;
 }
 
+// Returns a copy of the string that must be freed with free(), or NULL if
+// we ran out of memory.
+char * jrk_string_duplicate(const char * str)
+{
+  assert(str != NULL);
+  size_t size = strlen(str) + 1;
+  char * copy = (char *)malloc(size);
+  if (copy != NULL) { memcpy(copy, str, size); }
+  return copy;
+}
+
 void jrk_sprintf(jrk_string * str, const char * format, ...)
 {
   assert(format != NULL);
@@ -0,0 +1,409 @@
+// Functions for accumulating how much a Jrk's motor has been used, one
+// variables sample at a time.
+
+#include "jrk_internal.h"
+
+struct jrk_usage
+{
+  char * serial_number;
+
+  uint64_t monitored_time;
+  uint64_t run_time;
+  uint64_t current_limit_time;
+  uint64_t duty_cycle_band_time[JRK_USAGE_DUTY_CYCLE_BAND_COUNT];
+  uint64_t energy;  // microjoules
+  uint64_t charge;  // microcoulombs
+
+  // Energy that has not been added to the energy total yet because it is less
+  // than a microjoule, in nanojoules.  This is not saved in usage files.
+  uint32_t energy_remainder;
+
+  // The previous sample, which determines what the interval between it and
+  // the next sample gets counted as.
+  bool has_last_sample;
+  uint64_t last_time;
+  uint16_t last_vin_voltage;
+  uint16_t last_current;
+  int16_t last_duty_cycle;
+  bool last_at_current_limit;
+};
+
+jrk_error * jrk_usage_create(const char * serial_number, jrk_usage ** usage)
+{
+  if (usage == NULL)
+  {
+    return jrk_error_create("Usage output pointer is null.");
+  }
+
+  *usage = NULL;
+
+  if (serial_number == NULL)
+  {
+    return jrk_error_create("Serial number is null.");
+  }
+
+  jrk_usage * new_usage = (jrk_usage *)calloc(1, sizeof(jrk_usage));
+  if (new_usage == NULL) { return &jrk_error_no_memory; }
+
+  new_usage->serial_number = jrk_string_duplicate(serial_number);
+  if (new_usage->serial_number == NULL)
+  {
+    free(new_usage);
+    return &jrk_error_no_memory;
+  }
+
+  *usage = new_usage;
+  return NULL;
+}
+
+jrk_error * jrk_usage_copy(const jrk_usage * source, jrk_usage ** dest)
+{
+  if (dest == NULL)
+  {
+    return jrk_error_create("Usage output pointer is null.");
+  }
+
+  *dest = NULL;
+
+  if (source == NULL)
+  {
+    return NULL;
+  }
+
+  jrk_usage * new_usage = (jrk_usage *)malloc(sizeof(jrk_usage));
+  if (new_usage == NULL) { return &jrk_error_no_memory; }
+
+  memcpy(new_usage, source, sizeof(jrk_usage));
+  new_usage->serial_number = jrk_string_duplicate(source->serial_number);
+  if (new_usage->serial_number == NULL)
+  {
+    free(new_usage);
+    return &jrk_error_no_memory;
+  }
+
+  *dest = new_usage;
+  return NULL;
+}
+
+void jrk_usage_free(jrk_usage * usage)
+{
+  if (usage == NULL) { return; }
+  free(usage->serial_number);
+  free(usage);
+}
+
+const char * jrk_usage_get_serial_number(const jrk_usage * usage)
+{
+  if (usage == NULL) { return ""; }
+  return usage->serial_number;
+}
+
+static uint8_t duty_cycle_band(int16_t duty_cycle)
+{
+  uint32_t magnitude = duty_cycle < 0 ? -duty_cycle : duty_cycle;
+  uint32_t band = magnitude * JRK_USAGE_DUTY_CYCLE_BAND_COUNT / 600;
+  if (band >= JRK_USAGE_DUTY_CYCLE_BAND_COUNT)
+  {
+    band = JRK_USAGE_DUTY_CYCLE_BAND_COUNT - 1;
+  }
+  return band;
+}
+
+void jrk_usage_add_sample(jrk_usage * usage, const jrk_variables * vars,
+  uint64_t time_ms)
+{
+  if (usage == NULL || vars == NULL) { return; }
+
+  // Count the interval since the last sample using the values from the
+  // last sample.  Intervals that are too long, or that go backwards, mean we
+  // were not watching the device, so we cannot say what it was doing.
+  if (usage->has_last_sample && time_ms >= usage->last_time &&
+    time_ms - usage->last_time <= JRK_USAGE_MAX_INTERVAL)
+  {
+    uint32_t interval = time_ms - usage->last_time;
+
+    usage->monitored_time += interval;
+    if (usage->last_duty_cycle != 0)
+    {
+      usage->run_time += interval;
+    }
+    if (usage->last_at_current_limit)
+    {
+      usage->current_limit_time += interval;
+    }
+    usage->duty_cycle_band_time[duty_cycle_band(usage->last_duty_cycle)] +=
+      interval;
+
+    // mA * ms = uC, and mV * mA * ms = nJ.
+    usage->charge += (uint64_t)usage->last_current * interval;
+    uint64_t energy_nj = (uint64_t)usage->last_vin_voltage *
+      usage->last_current * interval + usage->energy_remainder;
+    usage->energy += energy_nj / 1000;
+    usage->energy_remainder = energy_nj % 1000;
+  }
+
+  uint16_t errors = jrk_variables_get_error_flags_halting(vars);
+
+  usage->has_last_sample = true;
+  usage->last_time = time_ms;
+  usage->last_vin_voltage = jrk_variables_get_vin_voltage(vars);
+  usage->last_current = jrk_variables_get_current(vars);
+  usage->last_duty_cycle = jrk_variables_get_duty_cycle(vars);
+  usage->last_at_current_limit =
+    jrk_variables_get_current_chopping_consecutive_count(vars) != 0 ||
+    (errors & (1 << JRK_ERROR_SOFT_OVERCURRENT));
+}
+
+void jrk_usage_interrupt(jrk_usage * usage)
+{
+  if (usage == NULL) { return; }
+  usage->has_last_sample = false;
+}
+
+uint64_t jrk_usage_get_monitored_time(const jrk_usage * usage)
+{
+  if (usage == NULL) { return 0; }
+  return usage->monitored_time;
+}
+
+uint64_t jrk_usage_get_run_time(const jrk_usage * usage)
+{
+  if (usage == NULL) { return 0; }
+  return usage->run_time;
+}
+
+uint64_t jrk_usage_get_current_limit_time(const jrk_usage * usage)
+{
+  if (usage == NULL) { return 0; }
+  return usage->current_limit_time;
+}
+
+uint64_t jrk_usage_get_duty_cycle_band_time(const jrk_usage * usage,
+  uint8_t band)
+{
+  if (usage == NULL || band >= JRK_USAGE_DUTY_CYCLE_BAND_COUNT) { return 0; }
+  return usage->duty_cycle_band_time[band];
+}
+
+uint64_t jrk_usage_get_energy(const jrk_usage * usage)
+{
+  if (usage == NULL) { return 0; }
+  return usage->energy;
+}
+
+uint64_t jrk_usage_get_charge(const jrk_usage * usage)
+{
+  if (usage == NULL) { return 0; }
+  return usage->charge;
+}
+
+jrk_error * jrk_usage_to_string(const jrk_usage * usage, char ** string)
+{
+  if (string == NULL)
+  {
+    return jrk_error_create("String output pointer is null.");
+  }
+
+  *string = NULL;
+
+  if (usage == NULL)
+  {
+    return jrk_error_create("Usage pointer is null.");
+  }
+
+  jrk_string str;
+  jrk_string_setup(&str);
+
+  jrk_sprintf(&str, "# Pololu Jrk G2 usage file.\n");
+  jrk_sprintf(&str, "serial_number: %s\n", usage->serial_number);
+  jrk_sprintf(&str, "monitored_time: %llu\n",
+    (unsigned long long)usage->monitored_time);
+  jrk_sprintf(&str, "run_time: %llu\n",
+    (unsigned long long)usage->run_time);
+  jrk_sprintf(&str, "current_limit_time: %llu\n",
+    (unsigned long long)usage->current_limit_time);
+  jrk_sprintf(&str, "energy: %llu\n",
+    (unsigned long long)usage->energy);
+  jrk_sprintf(&str, "charge: %llu\n",
+    (unsigned long long)usage->charge);
+  jrk_sprintf(&str, "duty_cycle_band_time:");
+  for (size_t i = 0; i < JRK_USAGE_DUTY_CYCLE_BAND_COUNT; i++)
+  {
+    jrk_sprintf(&str, " %llu",
+      (unsigned long long)usage->duty_cycle_band_time[i]);
+  }
+  jrk_sprintf(&str, "\n");
+
+  if (str.data == NULL)
+  {
+    return &jrk_error_no_memory;
+  }
+
+  *string = str.data;
+  return NULL;
+}
+
+static jrk_error * parse_u64(const char * key, const char * value,
+  uint64_t * out)
+{
+  int64_t result;
+  uint8_t error = jrk_string_to_i64(value, &result);
+  if (error || result < 0)
+  {
+    return jrk_error_create("Invalid %s value: '%s'.", key, value);
+  }
+  *out = result;
+  return NULL;
+}
+
+// Parses a space-separated list of numbers into the duty cycle band times.
+static jrk_error * parse_band_times(const char * value, jrk_usage * usage)
+{
+  const char * p = value;
+  for (size_t i = 0; i < JRK_USAGE_DUTY_CYCLE_BAND_COUNT; i++)
+  {
+    while (*p == ' ') { p++; }
+    char number[32];
+    size_t length = strcspn(p, " ");
+    if (length == 0 || length >= sizeof(number))
+    {
+      return jrk_error_create("Expected %u numbers for duty_cycle_band_time.",
+        JRK_USAGE_DUTY_CYCLE_BAND_COUNT);
+    }
+    memcpy(number, p, length);
+    number[length] = 0;
+    p += length;
+
+    jrk_error * error = parse_u64("duty_cycle_band_time", number,
+      &usage->duty_cycle_band_time[i]);
+    if (error != NULL) { return error; }
+  }
+
+  while (*p == ' ') { p++; }
+  if (*p != 0)
+  {
+    return jrk_error_create("Expected %u numbers for duty_cycle_band_time.",
+      JRK_USAGE_DUTY_CYCLE_BAND_COUNT);
+  }
+  return NULL;
+}
+
+// Applies one "key: value" line of a usage file.
+static jrk_error * apply_line(jrk_usage * usage, char * line)
+{
+  char * colon = strchr(line, ':');
+  if (colon == NULL)
+  {
+    return jrk_error_create("Expected a colon in line: '%s'.", line);
+  }
+  *colon = 0;
+  const char * key = line;
+  char * value = colon + 1;
+  while (*value == ' ') { value++; }
+
+  if (strcmp(key, "serial_number") == 0)
+  {
+    char * serial_number = jrk_string_duplicate(value);
+    if (serial_number == NULL) { return &jrk_error_no_memory; }
+    free(usage->serial_number);
+    usage->serial_number = serial_number;
+    return NULL;
+  }
+  if (strcmp(key, "monitored_time") == 0)
+  {
+    return parse_u64(key, value, &usage->monitored_time);
+  }
+  if (strcmp(key, "run_time") == 0)
+  {
+    return parse_u64(key, value, &usage->run_time);
+  }
+  if (strcmp(key, "current_limit_time") == 0)
+  {
+    return parse_u64(key, value, &usage->current_limit_time);
+  }
+  if (strcmp(key, "energy") == 0)
+  {
+    return parse_u64(key, value, &usage->energy);
+  }
+  if (strcmp(key, "charge") == 0)
+  {
+    return parse_u64(key, value, &usage->charge);
+  }
+  if (strcmp(key, "duty_cycle_band_time") == 0)
+  {
+    return parse_band_times(value, usage);
+  }
+
+  return jrk_error_create("Unrecognized key: '%s'.", key);
+}
+
+jrk_error * jrk_usage_read_from_string(const char * string,
+  jrk_usage ** usage)
+{
+  if (usage == NULL)
+  {
+    return jrk_error_create("Usage output pointer is null.");
+  }
+
+  *usage = NULL;
+
+  if (string == NULL)
+  {
+    return jrk_error_create("Usage string is null.");
+  }
+
+  jrk_error * error = NULL;
+
+  jrk_usage * new_usage = NULL;
+  error = jrk_usage_create("", &new_usage);
+
+  // Usage files are a handful of short lines, so it is simplest to copy the
+  // string and split it up in place.
+  char * copy = NULL;
+  if (error == NULL)
+  {
+    copy = jrk_string_duplicate(string);
+    if (copy == NULL) { error = &jrk_error_no_memory; }
+  }
+
+  char * line = copy;
+  while (error == NULL && line != NULL && *line)
+  {
+    char * next = strchr(line, '\n');
+    if (next != NULL) { *next++ = 0; }
+
+    size_t length = strlen(line);
+    while (length && (line[length - 1] == '\r' || line[length - 1] == ' '))
+    {
+      line[--length] = 0;
+    }
+
+    if (length != 0 && line[0] != '#')
+    {
+      error = apply_line(new_usage, line);
+    }
+
+    line = next;
+  }
+
+  if (error == NULL && new_usage->serial_number[0] == 0)
+  {
+    error = jrk_error_create("The usage file has no serial number.");
+  }
+
+  free(copy);
+
+  if (error == NULL)
+  {
+    *usage = new_usage;
+    new_usage = NULL;
+  }
+  else
+  {
+    error = jrk_error_add(error, "There was an error reading the usage file.");
+  }
+
+  jrk_usage_free(new_usage);
+
+  return error;
+}
@@ -181,6 +181,30 @@ static void write_buffer_to_variables(const uint8_t * buf, jrk_variables * vars)
   }
 }
 
+jrk_error * jrk_variables_decode(const uint8_t * buf, size_t len,
+  jrk_variables * variables)
+{
+  if (buf == NULL)
+  {
+    return jrk_error_create("Variables buffer is null.");
+  }
+
+  if (variables == NULL)
+  {
+    return jrk_error_create("Variables pointer is null.");
+  }
+
+  if (len < JRK_VARIABLES_SIZE)
+  {
+    return jrk_error_create(
+      "Variables buffer is too short: expected %u bytes, got %u.",
+      (unsigned int)JRK_VARIABLES_SIZE, (unsigned int)len);
+  }
+
+  write_buffer_to_variables(buf, variables);
+  return NULL;
+}
+
 jrk_error * jrk_get_variables(jrk_handle * handle, jrk_variables ** variables,
   uint16_t flags)
 {
@@ -216,7 +240,7 @@ jrk_error * jrk_get_variables(jrk_handle * handle, jrk_variables ** variables,
   // Store the variables in the new variables object.
   if (error == NULL)
   {
-    write_buffer_to_variables(buf, new_variables);
+    error = jrk_variables_decode(buf, sizeof(buf), new_variables);
   }
 
   // Pass the new variables to the caller.
@@ -3,6 +3,7 @@
 # This Ruby script auto-generates certain parts of our C/C++ code that are repetitive.
 
 require 'pathname'
+require 'stringio'
 require_relative 'generate_settings'
 require_relative 'generate_variables'
 
@@ -18,14 +19,22 @@ def generate_fragment(fragment_name, indent, filename)
     generate_settings_accessors(stream)
   when 'settings C++ accessors'
     generate_settings_cpp_accessors(stream)
-  when 'settings defaults'
-    generate_settings_defaults_code(stream)
+  when 'settings C++ field descriptors'
+    generate_settings_cpp_field_descriptors(stream)
+  when 'settings C++ field visitor'
+    generate_settings_cpp_field_visitor(stream)
+  when 'settings default images'
+    generate_settings_default_images(stream)
+  when 'settings generic default image'
+    generate_settings_generic_default_image(stream)
   when 'settings fixing code'
     generate_settings_fixing_code(stream)
   when 'buffer-to-settings code'
     generate_buffer_to_settings_code(stream)
   when 'settings-to-buffer code'
     generate_settings_to_buffer_code(stream)
+  when 'settings field layout code'
+    generate_settings_field_layout_code(stream)
   when 'settings file parsing code'
     generate_settings_file_parsing_code(stream)
   when 'settings file printing code'
@@ -36,6 +45,10 @@ def generate_fragment(fragment_name, indent, filename)
     generate_variables_getter_prototypes(stream)
   when 'variables C++ getters'
     generate_variables_cpp_getters(stream)
+  when 'variables C++ field descriptors'
+    generate_variables_cpp_field_descriptors(stream)
+  when 'variables C++ field visitor'
+    generate_variables_cpp_field_visitor(stream)
   when 'buffer-to-variables code'
     generate_buffer_to_variables_code(stream)
   when 'variables getters'
@@ -116,15 +116,32 @@ def generate_settings_cpp_accessors(stream)
   end
 end
 
-def generate_settings_defaults_code(stream)
+def generate_settings_default_image(stream, product)
+  stream.puts "{"
+  stream.puts "  .product = #{product || 0},"
   Settings.each do |setting_info|
     name = setting_info.fetch(:name)
-    default = setting_info[:default]
+    default = setting_info.fetch(:product_defaults, {}).fetch(product) do
+      setting_info[:default]
+    end
     next unless default && default != 0 && !setting_info[:default_is_zero]
-    stream.puts "jrk_settings_set_#{name}(settings, #{default});"
+    stream.puts "  .#{name} = #{default},"
+  end
+  stream.puts "},"
+end
+
+def generate_settings_default_images(stream)
+  Products.each do |product|
+    generate_settings_default_image(stream, product)
   end
 end
 
+# The defaults for a product this code does not know about: the settings that
+# have product-specific defaults are left at zero.
+def generate_settings_generic_default_image(stream)
+  generate_settings_default_image(stream, nil)
+end
+
 def generate_settings_fixing_code(stream)
   Settings.each do |setting_info|
     next if setting_info[:custom_fix]
@@ -333,3 +350,112 @@ def generate_settings_file_printing_code(stream)
     s.compact.each { |l| stream.puts l }
   end
 end
+
+def cpp_image_read_expression(type, addr, bit_addr, mask)
+  if type == :bool
+    shift = bit_addr != 0 ? " >> #{bit_addr}" : ""
+    "(buf[#{addr}]#{shift} & 1) != 0"
+  elsif [:uint8_t, :int8_t].include?(type)
+    shift_mask = ""
+    shift_mask << " >> #{bit_addr}" if bit_addr != 0
+    shift_mask << " & #{mask}" if mask
+    "static_cast<#{type}>(buf[#{addr}]#{shift_mask})"
+  else
+    raise NotImplementedError if bit_addr != 0 || mask
+    "field_detail::read_#{type}(buf + #{addr})"
+  end
+end
+
+def generate_settings_cpp_field_descriptors(stream)
+  Settings.each do |setting_info|
+    next if setting_info[:custom_eeprom]
+
+    name = setting_info.fetch(:name)
+    type = setting_integer_type(setting_info)
+    type = :bool if setting_info[:type] == :bool
+    addr = setting_info.fetch(:address, "JRK_SETTING_#{name.upcase}")
+    bit_addr = setting_info.fetch(:bit_address, 0)
+    mask = setting_info.fetch(:mask, nil)
+    mask ||= 1 if type == :bool
+
+    s = []
+    s << "/// Describes the #{name} setting."
+    s << "struct #{name}"
+    s << "{"
+    s << "  typedef #{type} type;"
+    s << "  static constexpr const char * name() { return \"#{name}\"; }"
+    s << "  static constexpr uint8_t address() { return #{addr}; }"
+    if setting_info[:products]
+      s << "  static constexpr bool applies_to(uint32_t product)"
+      s << "  {"
+      s << "    return #{setting_info[:products]};"
+      s << "  }"
+    else
+      s << "  static constexpr bool applies_to(uint32_t) { return true; }"
+    end
+    s << "  static type read(const uint8_t * buf) noexcept"
+    s << "  {"
+    s << "    return #{cpp_image_read_expression(type, addr, bit_addr, mask)};"
+    s << "  }"
+    s << "  static void write(uint8_t * buf, type value) noexcept"
+    s << "  {"
+    if [:bool, :uint8_t, :int8_t].include?(type)
+      if mask
+        shift = bit_addr != 0 ? " << #{bit_addr}" : ""
+        s << "    const uint8_t mask = static_cast<uint8_t>(#{mask}#{shift});"
+        s << "    buf[#{addr}] = static_cast<uint8_t>("
+        s << "      (buf[#{addr}] & ~mask) | ((value#{shift}) & mask));"
+      else
+        s << "    buf[#{addr}] = static_cast<uint8_t>(value);"
+      end
+    else
+      s << "    field_detail::write_#{type}(buf + #{addr}, value);"
+    end
+    s << "  }"
+    s << "};"
+    s << ""
+    s.each { |l| stream.puts l }
+  end
+end
+
+def generate_settings_cpp_field_visitor(stream)
+  Settings.each do |setting_info|
+    stream.puts "visitor(field::#{setting_info.fetch(:name)}());"
+  end
+end
+
+def generate_settings_field_layout_code(stream)
+  Settings.each do |setting_info|
+    next if setting_info[:custom_eeprom]
+
+    name = setting_info.fetch(:name)
+    type = setting_info.fetch(:type)
+    integer_type = setting_integer_type(setting_info)
+    addr = setting_info.fetch(:address, "JRK_SETTING_#{name.upcase}")
+    bit_addr = setting_info.fetch(:bit_address, 0)
+    mask = setting_info.fetch(:mask, nil)
+    mask ||= 1 if type == :bool
+
+    size = case integer_type
+           when :bool, :uint8_t, :int8_t then 1
+           when :uint16_t, :int16_t then 2
+           else raise NotImplementedError
+           end
+
+    if mask
+      byte_mask = bit_addr != 0 ? "#{mask} << #{bit_addr}" : mask.to_s
+    else
+      byte_mask = '0xFF'
+    end
+
+    line = "add_field(layout, \"#{name}\", #{addr}, #{size}, #{byte_mask});"
+    if setting_info[:products]
+      stream.puts product_if_statement(setting_info)
+      stream.puts "{"
+      stream.puts "  #{line}"
+      stream.puts "}"
+    else
+      stream.puts line
+    end
+  end
+end
@@ -66,3 +66,31 @@ def generate_variables_getters(stream)
     stream.puts
   end
 end
+
+def generate_variables_cpp_field_descriptors(stream)
+  Variables.each do |info|
+    name = info.fetch(:name)
+    type = info.fetch(:type)
+    addr = info.fetch(:address, "JRK_VAR_#{name.upcase}")
+    bit_addr = info.fetch(:bit_address, 0)
+
+    stream.puts "/// Describes the #{name} variable."
+    stream.puts "struct #{name}"
+    stream.puts "{"
+    stream.puts "  typedef #{type} type;"
+    stream.puts "  static constexpr const char * name() { return \"#{name}\"; }"
+    stream.puts "  static constexpr uint8_t address() { return #{addr}; }"
+    stream.puts "  static type read(const uint8_t * buf) noexcept"
+    stream.puts "  {"
+    stream.puts "    return #{cpp_image_read_expression(type, addr, bit_addr, nil)};"
+    stream.puts "  }"
+    stream.puts "};"
+    stream.puts
+  end
+end
+
+def generate_variables_cpp_field_visitor(stream)
+  Variables.each do |info|
+    stream.puts "visitor(variable_field::#{info.fetch(:name)}());"
+  end
+end
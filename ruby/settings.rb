@@ -1,3 +1,12 @@
+# The products that the default settings images are generated for.
+Products = %w(
+  JRK_PRODUCT_UMC04A_30V
+  JRK_PRODUCT_UMC04A_40V
+  JRK_PRODUCT_UMC05A_30V
+  JRK_PRODUCT_UMC05A_40V
+  JRK_PRODUCT_UMC06A
+)
+
 Settings = [
   {
     name: 'input_mode',
@@ -330,6 +339,7 @@ EOF
   {
     name: 'serial_baud_rate',
     type: :uint32_t,
+    default: 9600,
     custom_fix: true,
     custom_eeprom: true,
     comment:
@@ -624,7 +634,9 @@ EOF
     name: 'max_duty_cycle_while_feedback_out_of_range',
     type: :uint16_t,
     range: 1..600,
-    default: 600,
+    # The library has always filled this with 0 and let fixing raise it to 1,
+    # so that is the effective default of settings files that leave it out.
+    default: 1,
     comment: <<EOF
 If the feedback is beyond the range specified by the feedback error
 minimum and feedback error maximum values, then the duty cycle's magnitude
@@ -715,9 +727,14 @@ EOF
   {
     name: 'encoded_hard_current_limit_forward',
     type: :uint16_t,
-    # the default is actually different for each device
     max: 95,
     products: 'product != JRK_PRODUCT_UMC06A',
+    product_defaults: {
+      'JRK_PRODUCT_UMC04A_30V' => 87,
+      'JRK_PRODUCT_UMC04A_40V' => 63,
+      'JRK_PRODUCT_UMC05A_30V' => 86,
+      'JRK_PRODUCT_UMC05A_40V' => 62,
+    },
     comment: <<EOF
 Sets the current limit to be used when driving forward.
 
@@ -740,6 +757,12 @@ EOF
     type: :uint16_t,
     max: 95,
     products: 'product != JRK_PRODUCT_UMC06A',
+    product_defaults: {
+      'JRK_PRODUCT_UMC04A_30V' => 87,
+      'JRK_PRODUCT_UMC04A_40V' => 63,
+      'JRK_PRODUCT_UMC05A_30V' => 86,
+      'JRK_PRODUCT_UMC05A_40V' => 62,
+    },
     comment:
       "Sets the current limit to be used when driving in reverse.\n" \
       "See the documentation of encoded_hard_current_limit_forward."